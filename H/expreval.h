@@ -128,6 +128,7 @@ struct expr {
     struct asym     *sym;   /* label used */
     struct asym     *mbr;   /* struct member */
 	bool isptr;
+    bool            is_span;   /* v2.52: label difference with an undefined label ( pass 1 ) */
     struct asym     *type;  /* for DOT operator. Must be last (see TokenAssign)! */
 };
 
@@ -142,5 +143,13 @@ enum expr_flags {
 extern ret_code     EvalOperand( int *, struct asm_tok[], int, struct expr *, uint_8 );
 extern void         ExprEvalInit( void );
 extern ret_code     EmitConstError( const struct expr * );
+#if FASTPASS
+struct line_item;
+struct expr_cache;
+extern bool         ExprIsInvariant( void );
+extern void         EvalCacheLine( struct line_item *, struct asm_tok[] );
+extern void         EvalCacheFree( struct expr_cache * );
+extern void         EvalCacheStats( void );
+#endif
 
 #endif
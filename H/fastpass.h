@@ -29,8 +29,10 @@ struct equ_item {
 
 struct line_item {
     struct line_item *next;
+    struct expr_cache *ecache; /* pass-invariant operands, see expreval.c */
     uint_32 lineno:20, srcfile:12;
     uint_32 list_pos; /* position .LST file */
+    uint_8 rescan;    /* line contains a forward-referenced text macro */
     char line[1];
 };
 
@@ -69,13 +71,30 @@ extern bool StoreState; /* is 1 if states are to be stored in pass one */
  */
 extern bool UseSavedState; 
 
+/* reasons why the line store cannot be used in further passes;
+ * displayed with -stats.
+ */
+enum fastpass_skip {
+    FPS_TMACRO_FWDREF,   /* text macro used prior to definition */
+    FPS_PROC_PRIVATE,    /* PROC PRIVATE after PUBLIC directive */
+    FPS_INVALID_PUBLIC,  /* PUBLIC for a non-internal symbol */
+    FPS_UNDEF_SEGMENT,   /* undefined segment (in GROUP) */
+    FPS_SAFESEH,         /* .SAFESEH item isn't an internal PROC */
+    FPS_ALIAS,           /* ALIAS target isn't PUBLIC or external */
+    FPS_ALTNAME,         /* alternate name of EXTERN is invalid */
+    FPS_HLLOPT_LIST,     /* -hllopt code is listed ( -Sg ) */
+};
+
 //void SaveState( void );
 void FastpassInit( void );
 void SegmentSaveState( void );
 void AssumeSaveState( void );
 void ContextSaveState( void );
 void StoreLine( const char *, int, uint_32 );
-void SkipSavedState( void );
+void SkipSavedState( enum fastpass_skip, const char * );
+void TextMacroFwdRef( struct asym * );
+void UnstoredName( const char * );
+void FastpassStats( void );
 struct line_item *RestoreState( void );
 void SaveVariableState( struct asym *sym );
 void FreeLineStore( void );
@@ -521,6 +521,7 @@ enum opt_names {
     OPTN_ERR_FN,              /* -Fr option */
 	OPTN_SYM_FN,              /* -Fs option */
     OPTN_LNKDEF_FN,           /* -Fd option */
+    OPTN_ORDER_FN,            /* -order option */
     OPTN_MODULE_NAME,         /* -nm option */
     OPTN_TEXT_SEG,            /* -nt option */
     OPTN_DATA_SEG,            /* -nd option */
@@ -570,6 +571,7 @@ enum offset_type {
 enum line_output_flags {
     LOF_LISTED = 1, /* line written to .LST file */
     LOF_SKIPPOS  = 2, /* suppress setting list_pos */
+    LOF_OPTIMIZED = 4, /* v2.52: instruction rewritten by OPTION OPTIMIZE */
 };
 
 /* flags for win64_flags */
@@ -688,6 +690,11 @@ struct global_options {
 	bool        hlcall;                  /* Allow High Level C style Calling and object invocation */
 	bool        pie;					 /* Generate Position Independant Executable (Unix) */
     bool        frameflags;              /* Use Lea instead of Add/Sub to preserve flags in frame prologue/epilogue */
+    bool        stats;                   /* -stats option */
+    bool        lazy_include;            /* -lazyinc option */
+    bool        fold_procs;              /* -icf option */
+    bool        hll_optimize;            /* -hllopt option */
+    uint_8      mca_cpu;                 /* -Sc option ( cpu model index+1 ) */
 #if MANGLERSUPP
     enum naming_types naming_convention; /* OW naming peculiarities */
 #endif
@@ -824,6 +831,8 @@ struct module_info {
 #endif
     unsigned            NoSignExtend:1;  /* option nosignextend */
     unsigned            switch_style:1;
+    unsigned            optimize:1;      /* v2.52: option optimize:size */
+    unsigned            riprelative:1;   /* v2.52: option riprelative:on */
 #if ELF_SUPPORT || AMD64_SUPPORT || MZ_SUPPORT
     union {
 #if ELF_SUPPORT || AMD64_SUPPORT
@@ -13,6 +13,8 @@ extern void HllInit( int );    /* reset counter for hll labels */
 extern void HllFini( void );
 #endif
 extern void HllCheckOpen( void );
+extern bool HllFlush( struct asm_tok[] );     /* v2.52: -hllopt */
+extern void HllStats( void );
 
 extern uint_32 GetHllLabel(void);
 #endif
@@ -0,0 +1,26 @@
+/****************************************************************************
+*
+* Description:  JIT mode of the library interface ( see libuasm.h )
+*
+****************************************************************************/
+
+
+#ifndef _JIT_H_
+#define _JIT_H_
+
+struct uasm_image;
+
+/* parameters of a JIT assembly, set by the library interface */
+struct jit_info {
+    void                *memory;   /* caller-provided memory or NULL */
+    size_t              memsize;
+    void                *(*resolver)( void *, const char * );
+    void                *user;     /* first argument of resolver */
+    struct uasm_image   *image;    /* receives the image */
+};
+
+extern void     JitSetParams( struct jit_info * ); /* NULL ends JIT mode */
+extern bool     jit_init( struct module_info * );  /* called by bin_init() */
+extern void     JitFree( struct uasm_image * );
+
+#endif
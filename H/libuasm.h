@@ -0,0 +1,104 @@
+/****************************************************************************
+*
+* Description:  UASM library interface ( libuasm.so, uasm.dll ).
+*               Assembles a source held in memory; object module,
+*               listing and messages are returned in memory buffers.
+*               A context holds a set of options and is reused for
+*               any number of sources. Calls from different threads
+*               are serialized.
+*               JIT mode assembles a source ( -bin rules ) directly
+*               into executable memory of the running process.
+*
+****************************************************************************/
+
+
+#ifndef _LIBUASM_H_
+#define _LIBUASM_H_
+
+#include <stddef.h>
+
+#if defined(__GNUC__) && __GNUC__ >= 4
+#define UASMAPI __attribute__ ((visibility("default")))
+#else
+#define UASMAPI
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct uasm_ctx; /* opaque */
+
+/* buffers are allocated with malloc(); listing and messages are
+ * zero-terminated, the terminator isn't included in the size.
+ */
+struct uasm_result {
+    unsigned char   *object;        /* object module ( or binary ), NULL if errors */
+    size_t          object_size;
+    char            *listing;       /* listing, if -Fl is among the options */
+    size_t          listing_size;
+    char            *messages;      /* errors and warnings */
+    size_t          messages_size;
+    unsigned        errors;
+    unsigned        warnings;
+};
+
+/* create a context; <options> are command line options ( e.g. "-win64 -Zp8" ).
+ * returns NULL if an option is invalid or a file name is included. -h, -?
+ * and @ ( response file or environment variable ) are invalid here.
+ * Each assembly defines the built-in macro library, which costs more time
+ * than assembling a small source; add -nomlib if the sources don't use it.
+ */
+extern UASMAPI struct uasm_ctx *UasmCreate( const char *options );
+
+/* assemble <size> bytes of <source>. returns 1 if ok, 0 if errors occured.
+ * The functions may be called from any thread, but the assembler's state is
+ * global: concurrent calls ( also with different contexts ) are serialized
+ * by a lock, they don't run in parallel.
+ */
+extern UASMAPI int  UasmAssemble( struct uasm_ctx *, const char *source, size_t size, struct uasm_result * );
+
+extern UASMAPI void UasmFreeResult( struct uasm_result * );
+extern UASMAPI void UasmDestroy( struct uasm_ctx * );
+
+/* JIT mode.
+ * the source is assembled with the -bin rules ( the context's output format
+ * is ignored ), so 64-bit code needs .x64 and .model flat. Code segments are
+ * placed first, followed by the other segments on a new page. External
+ * symbols are resolved by a callback, which returns NULL for unknown names.
+ * Calls/jumps to externals out of 32-bit range go through stubs.
+ * When done, the code pages are read/execute, the others read/write.
+ */
+typedef void *(*uasm_resolver)( void *user, const char *name );
+
+struct uasm_symbol {
+    const char      *name;
+    void            *address;
+};
+
+struct uasm_image {
+    void                *base;          /* start of image ( first code segment ) */
+    size_t              size;           /* size of image ( needed size if memory was too small ) */
+    size_t              code_size;      /* size of code pages */
+    struct uasm_symbol  *symbols;       /* labels of the module, sorted by name */
+    size_t              num_symbols;
+    int                 mapped;         /* memory was allocated by UasmJit() */
+};
+
+/* assemble <source> into executable memory. If <memory> is NULL, it is
+ * allocated; else it must be page-aligned and at least as large as the image.
+ * returns 1 if ok, 0 if errors occured ( then there's no image ).
+ */
+extern UASMAPI int  UasmJit( struct uasm_ctx *, const char *source, size_t size,
+                            void *memory, size_t memsize, uasm_resolver, void *user,
+                            struct uasm_result *, struct uasm_image * );
+/* get address of a label, NULL if not found */
+extern UASMAPI void *UasmSymbol( const struct uasm_image *, const char *name );
+/* free the symbol table and the memory, if allocated by UasmJit() */
+extern UASMAPI void UasmFreeImage( struct uasm_image * );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
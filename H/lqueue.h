@@ -8,6 +8,7 @@ extern void     DeleteLineQueue( void );
 extern void     AddLineQueue( const char *line );
 extern void     AddLineQueueX( const char *fmt, ... );
 extern void     RunLineQueue( void );
+extern bool     PopLineQueue( char *buffer );
 extern void     BuildCodeLine(char *buffer, const char *fmt, ...);
 //v2.11: replaced by macro
 //extern bool   is_linequeue_populated( void );
@@ -0,0 +1,23 @@
+/****************************************************************************
+*
+* Description:  static throughput/latency analysis for the listing ( -Sc )
+*
+****************************************************************************/
+
+
+#ifndef _MCA_H_
+#define _MCA_H_
+
+struct code_info;
+struct expr;
+
+extern int         McaSetModel( const char * ); /* returns model index+1 or 0 */
+extern void        McaInit( int );              /* reset block data for a new pass */
+extern void        McaInstr( const struct code_info *, const struct expr *, int );
+extern void        McaDone( void );             /* instruction has been encoded */
+extern void        McaLabel( void );            /* a code label starts a new block */
+extern void        McaEpilogue( bool );         /* RET line: start/end summing the epilogue */
+extern const char *McaListText( void );         /* listing column for LstWrite() */
+extern void        McaFini( void );             /* write block summary to listing */
+
+#endif
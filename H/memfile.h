@@ -0,0 +1,20 @@
+/****************************************************************************
+*
+* Description:  memory files, used for "-" ( stdin/stdout ) as file name
+*
+****************************************************************************/
+
+
+#ifndef _MEMFILE_H_
+#define _MEMFILE_H_
+
+/* "-" as file name: source is read from stdin, output is written to stdout */
+#define IS_STDIO_NAME( name ) ( (name) && (name)[0] == '-' && (name)[1] == NULLC )
+
+extern FILE     *MemFileOpen( FILE * );          /* create file, initial contents read from a stream */
+extern int      MemFileClose( FILE *, FILE * );  /* write contents to a stream and close file */
+extern FILE     *MemFileStdout( void );          /* stream for stdout; messages go to stderr then */
+extern FILE     *MemFileStream( int );           /* stream for "-" of a file type */
+extern void     MemFileSetStream( int, FILE * ); /* set stream for "-" of a file type */
+
+#endif
@@ -386,4 +386,7 @@ pick( NO_EVEX_FORM, "Not possible to EVEX encode requested instruction")
 pick( INVALID_REG_STRUCT_SIZE, "Invalid structure size for WIN64 by-value passing, use the address instead")
 pick( STACKBASE_NOT_SUPPORTED, "Stackbase option not supported with output format")
 pick( STACKBASE_CHANGED, "Stackbase automatically changed to RSP to support WIN64 options")
-pick( REAL10_BY_VALUE, "REAL10 are passed by reference not value")
\ No newline at end of file
+pick( REAL10_BY_VALUE, "REAL10 are passed by reference not value")
+pick( ABSOLUTE_ADDRESS_IN_64BIT_CODE, "Absolute address needs 32-bit relocation: %s" )
+pick( JIT_TARGET_OUT_OF_RANGE, "Fixup target out of range: %s at location %s.%lX" )
+pick( JIT_MEMORY_ERROR, "Cannot set up JIT image of %u bytes: %s" )
\ No newline at end of file
@@ -168,6 +168,13 @@ struct omf_rec {
 
 extern void omf_write_record( const struct omf_rec * );
 
+/* v2.52: object module is built in memory */
+extern uint_32 omf_img_tell( void );
+extern void    omf_img_seek( uint_32 );
+extern void    omf_img_truncate( void );
+extern void    omf_img_flush( void );
+extern void    omf_img_free( void );
+
 #define FIX_GEN_MAX        11   /* max size needed for OmfFixGenFix() */
 #define FIX_GEN_MODEND_MAX  9   /* max size needed for OmfFixGenFixModend() */
 
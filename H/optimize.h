@@ -0,0 +1,20 @@
+/****************************************************************************
+*
+* Description:  size optimizing instruction selection ( OPTION OPTIMIZE )
+*
+****************************************************************************/
+
+
+#ifndef _OPTIMIZE_H_
+#define _OPTIMIZE_H_
+
+struct code_info;
+struct expr;
+
+extern void     OptimizeInit( int );  /* reset sequence for a new pass */
+extern void     OptimizeInstr( struct code_info *, struct expr *, int, const char ** );
+extern void     OptimizeDone( void ); /* instruction has been encoded */
+extern unsigned OptimizeCheck( void ); /* nonzero if another pass is needed */
+extern void     OptimizeFini( void );
+
+#endif
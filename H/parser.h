@@ -343,7 +343,7 @@ struct code_info {
     unsigned char   evex_sae;  /* EVEX Static Rounding Mode */
 #endif
     union {
-        unsigned char flags;
+        unsigned short flags;
         struct {
             unsigned char   iswide:1;       /* 0=byte, 1=word/dword/qword */
             unsigned char   isdirect:1;     /* 1=direct addressing mode */
@@ -354,6 +354,9 @@ struct code_info {
             unsigned char   x64lo_used:1;   /* SPL,BPL,SIL,DIL used */
 #endif
             unsigned char   undef_sym:1;    /* v2.06b: struct member is forward ref */
+            unsigned char   relax_var:1;    /* v2.52: displacement size depends on value */
+            unsigned char   relax_disp:1;   /* v2.52: displacement was unknown span in pass 1 */
+            unsigned char   relax_full:1;   /* v2.52: relaxed displacement has grown to full size */
         };
     };
 };
@@ -391,6 +394,7 @@ extern ret_code   MemtypeFromSize( int, enum memtype * );
 extern int        SizeFromRegister( int );
 extern ret_code   GetLangType( int *, struct asm_tok[], enum lang_type * );
 
+extern uint_32    ExtOrder;
 extern void       sym_add_table( struct symbol_queue *, struct dsym * );
 extern void       sym_remove_table( struct symbol_queue *, struct dsym * );
 extern void       sym_ext2int( struct asym * );
@@ -400,6 +404,11 @@ extern void       set_frame( const struct asym *sym );
 extern void       set_frame2( const struct asym *sym );
 extern ret_code   ParseLine( struct asm_tok[] );
 extern void       ProcessFile( struct asm_tok[] );
+extern void       EncoderStats( void );
+extern void       DispRelaxInit( int );
+extern void       DispRelaxFini( void );
+extern void       DispSized( const struct code_info *, unsigned, unsigned );
+extern void       DispRelaxStats( void );
 
 extern void       WritePreprocessedLine( const char * );
 
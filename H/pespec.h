@@ -169,6 +169,32 @@ struct IMAGE_BASE_RELOCATION {
 //#define IMAGE_REL_BASED_IA64_IMM64 9 /* ??? */
 #define IMAGE_REL_BASED_DIR64      10 /* 64-bit target */
 
+/* export directory ( section .edata ) */
+
+struct IMAGE_EXPORT_DIRECTORY { /* size 40 */
+    uint_32 Characteristics;
+    uint_32 TimeDateStamp;
+    uint_16 MajorVersion;
+    uint_16 MinorVersion;
+    uint_32 Name;                  /* RVA of dll name */
+    uint_32 Base;                  /* ordinal base */
+    uint_32 NumberOfFunctions;
+    uint_32 NumberOfNames;
+    uint_32 AddressOfFunctions;    /* RVA of export address table */
+    uint_32 AddressOfNames;        /* RVA of name pointer table */
+    uint_32 AddressOfNameOrdinals; /* RVA of ordinal table */
+};
+
+/* import directory entry ( section .idata ) */
+
+struct IMAGE_IMPORT_DESCRIPTOR { /* size 20 */
+    uint_32 OriginalFirstThunk;    /* RVA of import lookup table */
+    uint_32 TimeDateStamp;
+    uint_32 ForwarderChain;
+    uint_32 Name;                  /* RVA of dll name */
+    uint_32 FirstThunk;            /* RVA of import address table */
+};
+
 /* PE resource directory structure */
 
 struct IMAGE_RESOURCE_DIRECTORY { /* size 16 */
@@ -8,5 +8,6 @@
 #define _POSNDIR_H_
 
 extern void AlignCurrOffset( int );
+extern void fill_in_objfile_space( unsigned ); /* v2.52: used by -order */
 
 #endif
@@ -6,5 +6,9 @@
 
 extern int      PreprocessLine( char *, struct asm_tok[] );
 extern ret_code WriteCodeLabel( char *, struct asm_tok[] );
+extern void     ParsePreprocessedLine( char *, struct asm_tok[] );
+extern void     LazyDeclInit( void );
+extern void     LazyDeclStats( void );
+extern void     LazyDeclSortExt( void );
 
 #endif
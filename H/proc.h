@@ -59,4 +59,10 @@ extern void             ProcInit( void );
 
 extern void             ProcCheckOpen( void );
 
+extern unsigned         FoldProcs( void );
+extern void             FoldInstr( unsigned );
+extern void             FoldStats( void );
+extern unsigned         OrderProcs( void );
+extern void             OrderStats( void );
+
 #endif
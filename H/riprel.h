@@ -0,0 +1,18 @@
+/****************************************************************************
+*
+* Description:  RIP-relative addressing of labels ( OPTION RIPRELATIVE )
+*
+****************************************************************************/
+
+
+#ifndef _RIPREL_H_
+#define _RIPREL_H_
+
+struct code_info;
+struct expr;
+
+extern void     RipRelInit( int );  /* reset statistics for a new pass */
+extern bool     RipRelInstr( const struct code_info *, const struct expr *, int ); /* TRUE if replaced */
+extern void     RipRelStats( void );
+
+#endif
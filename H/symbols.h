@@ -180,6 +180,10 @@ struct asym {
                     fwdref:1,     /* symbol was forward referenced */
                     included:1,   /* COFF: static symbol added to public queue. ELF:symbol added to symbol table (SYM_INTERNAL) */
                     isparam:1;    /* symbol is local parametar above rsp */
+#if FASTPASS
+    unsigned char   prestore:1,   /* SYM_UNDEFINED: referenced before the line store started */
+                    invariant:1;  /* EQU: value doesn't depend on labels, $ or variables */
+#endif
     union {
         /* for SYM_INTERNAL (data labels, memtype != NEAR|FAR), SYM_STRUCT_FIELD */
         uint_32         first_size;   /* size of 1st initializer's dimension in bytes */
@@ -264,6 +268,7 @@ struct asym {
     uint_16         name_size;
 #endif
     uint_16  langtype; //enum lang_type
+    uint_32  ext_order;    /* v2.52: SYM_EXTERNAL: order of TAB_EXT items */
 	union {
         /* SYM_INTERNAL, SYM_UNDEFINED, SYM_EXTERNAL: backpatching fixup */
         struct fixup *bp_fixup;
@@ -359,6 +364,9 @@ struct seg_info {
     unsigned char       written:1;      /* code/data just written */
     unsigned char       linnum_init:1;  /* v2.10: linnum data emitted for segment? */
     unsigned char       combine:3;      /* combine type, see omfspec.h */
+    unsigned char       hllcode:1;      /* v2.52: _TEXT or _flat, HLL/OOP calls are expanded */
+    unsigned char       overlay:1;      /* v2.52: -icf, code of a folded proc is generated */
+    unsigned char       reordered:1;    /* v2.52: -order, procs aren't in source order */
 #if COMDATSUPP
     unsigned char       comdat_selection:3; /* if > 0, it's a COMDAT (COFF/OMF) */
 #endif
@@ -432,6 +440,9 @@ struct proc_info {
 	uint_8              NoSub;
 	int                frameofs;		/* Optimise 1byte displace to access locals from RBP by using a frame offset */
     bool               prologueDone;    /* UASM 2.51 check when prologue has been completed */
+    struct dsym        *foldto;         /* PROC: v2.52: -icf, proc with identical code */
+    bool               foldable;       /* PROC: v2.52: -icf, code ends with RET, IRET or JMP */
+    struct order_item  *order;          /* PROC: v2.52: -order, position in the segment */
 };
 
 /* macro parameter */
@@ -471,6 +482,7 @@ struct macro_info {
 struct sfield {
     struct asym         sym;        /* field symbol ( state=SYM_STRUCT_FIELD ) */
     struct sfield       *next;      /* next field in STRUCT,UNION,RECORD */
+    struct dflt_init    *dflt;      /* v2.52: image of default initializer ( see data.c ) */
     //char                *init_dir; /* v2.09: removed ; previously: not used by record fields */
     char                ivalue[1];  /* v2.09: type changed from char * to char[] */
 };
@@ -592,6 +604,7 @@ extern  void            SymMakeAllSymbolsPublic( void );
 extern  void            SymGetAll( struct asym ** );
 extern  struct asym     *SymEnum( struct asym *, int * );
 extern  uint_32         SymGetCount( void );
+extern  void            SymSimd( struct dsym * );
 
 extern  void            WriteSymbols( void );
 
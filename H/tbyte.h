@@ -36,6 +36,5 @@ struct TB_LD {
     unsigned short e;
 };
 
-struct TB_LD *strtotb( const char *bufptr, struct TB_LD *pld, char negative );
 
 #endif
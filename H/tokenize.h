@@ -53,6 +53,9 @@ enum tokenize_flags {
 enum tok_flags3 {
     TF3_ISCONCAT  = 0x01,  /* line was concatenated */
     TF3_EXPANSION = 0x02,  /* expansion operator % at pos 0 */
+    TF3_POINTER   = 0x04,  /* v2.52: line contains '->' */
+    TF3_IDBRACKET = 0x08,  /* v2.52: line contains an ID followed by '(' */
+    TF3_CLBRACKET = 0x10,  /* v2.52: line contains ')' */
 };
 
 extern ret_code GetToken( struct asm_tok[], struct line_status * );
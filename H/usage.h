@@ -14,22 +14,26 @@
 "-nomlib\0"         "Disable internal Macro Library\0"
 "-D<name>[=text]\0" "Define text macro\0"
 "-e<number>\0"      "Set error limit number (default=50)\0"
-"-EP\0"             "Output preprocessed listing to stdout\0"
+"-EP\0"             "Output preprocessed listing to stdout ( or -Fo file );\0"
+"\0"                "code labels and PROCs aren't defined,\0"
+"\0"                "HLL-style calls aren't expanded\0"
 "-eq\0"             "don't display error messages\0"
 #if DLLIMPORT
 "-Fd[=<file_name>]\0"  "Write import definition file\0"
 #endif
 "-Fi<file_name>\0"  "Force <file_name> to be included\0"
 "-Fs[=<file_name>]\0" "Write symbolic debug info\0"
-"-Fl[=<file_name>]\0" "Write listing file\0"
-"-Fo<file_name>\0"  "Set object file name\0"
+"-Fl[=<file_name>]\0" "Write listing file ( - = stdout )\0"
+"-Fo<file_name>\0"  "Set object file name ( - = stdout )\0"
 "-Fw<file_name>\0"  "Set errors file name\0"
 "-FPi\0"            "80x87 instructions with emulation fixups\0"
 "-FPi87\0"          "80x87 instructions (default)\0"
 "-fpc\0"            "Disallow floating-point instructions (.NO87)\0"
 "-fp<n>\0"          "Set FPU, <n> is: 0=8087 (default), 2=80287, 3=80387\0"
 "-G<c|d|r|z>\0"     "Use Pascal, C, Fastcall or Stdcall calling convention\0"
+"-hllopt\0"         "Optimize jumps generated by .IF, .WHILE, .REPEAT\0"
 "-I<directory>\0"   "Add directory to list of include directories\0"
+"-icf\0"            "Fold procedures with identical code and fixups\0"
 "-m<t|s|c|m|l|h|f>\0" "Set memory model:\0"
 "\0"                "(Tiny, Small, Compact, Medium, Large, Huge, Flat)\0"
 "-nc=<name>\0"       "Set class name of code segment\0"
@@ -37,9 +41,12 @@
 #if COCTALS
 "-o\0"              "Allow C form of octal constants\0"
 #endif
+"-order=<file_name>\0" "Place procedures in order listed in file (-bin, -pe)\0"
 "-q, -nologo\0"     "Don't display version and copyright information\0"
 "-less\0"           "Reduce console output information (be less verbose)\0"
+"-lazyinc\0"        "Parse declarations of include files on first use\0"
 "-Sa\0"             "Maximize source listing\0"
+"-Sc[=cpu]\0"       "List estimated uops, throughput and latency, cpu=<skl|icl|zen3>\0"
 #if COFF_SUPPORT
 "-safeseh\0"        "Assert all exception handlers are declared\0"
 #endif
@@ -48,6 +55,7 @@
 "-Sn\0"             "Suppress symbol-table listing\0"
 "-Sp[n]\0"          "Set segment alignment, n=<1|2|4|8|16|32 ...>\0"
 "-Sx\0"             "List false conditionals\0"
+"-stats\0"          "Display assembly statistics\0"
 "-w\0"              "Same as /W0 /WX\0"
 "-W<number>\0"      "Set warning level number (default=2, max=4)\0"
 "-WX\0"             "Treat all warnings as errors\0"
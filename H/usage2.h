@@ -1,3 +1,5 @@
-"   UASM [options] asm-file [options] [asm-file] ... [@env_var]\n\n\0"
+"   UASM [options] asm-file [options] [asm-file] ... [@env_var]\n"
+"   asm-file '-' reads the source from stdin; '-' files are held in memory\n"
+"   ( on Windows in a temporary file in the TEMP directory )\n\n\0"
 "Options: \0"
 "\n"
\ No newline at end of file
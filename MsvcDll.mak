@@ -72,10 +72,12 @@ $(OUTD)\$(name).dll : $(OUTD)/$(name)s.lib
 $(lflagsw) $(OUTD)/$(name)s.lib
 /LIBPATH:"$(VCDIR)\Lib" /DLL "$(W32LIB)/kernel32.lib" /OUT:$@
 /EXPORT:AssembleModule /EXPORT:ParseCmdline /EXPORT:CmdlineFini
+/EXPORT:UasmCreate /EXPORT:UasmAssemble /EXPORT:UasmFreeResult /EXPORT:UasmDestroy
+/EXPORT:UasmJit /EXPORT:UasmSymbol /EXPORT:UasmFreeImage
 <<
 
-$(OUTD)\$(name)s.lib : $(proj_obj)
-	@$(lib) /out:$(OUTD)\$(name)s.lib $(proj_obj)
+$(OUTD)\$(name)s.lib : $(proj_obj) $(OUTD)/libuasm.obj
+	@$(lib) /out:$(OUTD)\$(name)s.lib $(proj_obj) $(OUTD)/libuasm.obj
 
 $(OUTD)/msgtext.obj: msgtext.c H/msgdef.h H/globals.h
 	$(CC) -Fo$* msgtext.c
@@ -27,6 +27,9 @@
 #include "proc.h"
 #include "expreval.h"
 #include "hll.h"
+#include "mca.h"
+#include "optimize.h"
+#include "riprel.h"
 #include "context.h"
 #include "types.h"
 #include "label.h"
@@ -43,6 +46,8 @@
 #include "lqueue.h"
 #include "orgfixup.h"
 #include "macrolib.h"
+#include "preproc.h"
+#include "memfile.h"
 //#include "simd.h"
 
 #if DLLIMPORT
@@ -85,6 +90,9 @@ jmp_buf jmpenv;
 #define ERR_EXT "err"
 #define BIN_EXT "BIN"
 #define EXE_EXT "EXE"
+
+/* v2.52: -EP without -Fo writes to stdout */
+#define EP_NO_OUTFILE ( Options.preprocessor_stdout && Options.names[OPTN_OBJ_FN] == NULL )
 extern int_32           LastCodeBufSize;
 extern char             *DefaultDir[NUM_FILE_TYPES];
 extern const char       *ModelToken[];
@@ -404,50 +412,6 @@ void OutputBytes( const unsigned char *pbytes, int len, struct fixup *fixup )
         CurrSeg->sym.max_offset = CurrSeg->e.seginfo->current_loc;
 }
 
-/* Used to output a string to current segment in wide-char format with interleaved zeros */
-void OutputInterleavedBytes(const unsigned char *pbytes, int len, struct fixup *fixup)
-{
-	int i = 0;
-	char *pOut = NULL;
-
-	if (write_to_file == TRUE) {
-		uint_32 idx = CurrSeg->e.seginfo->current_loc - CurrSeg->e.seginfo->start_loc;
-#if 0 /* def DEBUG_OUT */
-		if (CurrSeg->e.seginfo->current_loc < CurrSeg->e.seginfo->start_loc)
-			_asm int 3;
-#endif
-		/**/myassert(CurrSeg->e.seginfo->current_loc >= CurrSeg->e.seginfo->start_loc);
-		if (Options.output_format == OFORMAT_OMF && ((idx + len) > MAX_LEDATA_THRESHOLD)) {
-			omf_FlushCurrSeg();
-			idx = CurrSeg->e.seginfo->current_loc - CurrSeg->e.seginfo->start_loc;
-		}
-		if (fixup)
-			store_fixup(fixup, CurrSeg, (int_32 *)pbytes);
-		pOut = &CurrSeg->e.seginfo->CodeBuffer[idx];
-		for (i = 0; i < len*2; i++)
-		{
-			if (i % 2 == 1)
-				*pOut++ = 0;
-			else
-				*pOut++ = *pbytes++;
-		}
-	}
-#if 1
-	/* check this in pass 1 only */
-	else if (CurrSeg->e.seginfo->current_loc < CurrSeg->e.seginfo->start_loc) {
-		DebugMsg(("OutputBytes: segment start loc changed from %" I32_SPEC "Xh to %" I32_SPEC "Xh\n",
-			CurrSeg->e.seginfo->start_loc,
-			CurrSeg->e.seginfo->current_loc));
-		CurrSeg->e.seginfo->start_loc = CurrSeg->e.seginfo->current_loc;
-	}
-#endif
-	CurrSeg->e.seginfo->current_loc += len*2;
-	CurrSeg->e.seginfo->bytes_written += len*2;
-	CurrSeg->e.seginfo->written = TRUE;
-	if (CurrSeg->e.seginfo->current_loc > CurrSeg->sym.max_offset)
-		CurrSeg->sym.max_offset = CurrSeg->e.seginfo->current_loc;
-}
-
 /* set current offset in a segment (usually CurrSeg) without to write anything */
 ret_code SetCurrOffset( struct dsym *seg, uint_32 value, bool relative, bool select_data )
 /****************************************************************************************/
@@ -714,14 +678,17 @@ void WritePreprocessedLine( const char *string )
     if ( GeneratedCode )
         return;
 #endif
+    /* v2.52: write to the -Fo file if one has been opened */
+    FILE *out = ( CurrFile[OBJ] ? CurrFile[OBJ] : stdout );
+
     if ( Token_Count > 0 ) {
         /* v2.08: don't print a leading % (this char is no longer filtered) */
         for ( p = string; isspace( *p ); p++ );
-        printf("%s\n", *p == '%' ? p+1 : string );
+        fprintf( out, "%s\n", *p == '%' ? p+1 : string );
         PrintEmptyLine = TRUE;
     } else if ( PrintEmptyLine ) {
         PrintEmptyLine = FALSE;
-        printf("\n");
+        fprintf( out, "\n" );
     }
 }
 
@@ -835,6 +802,7 @@ static void ModulePassInit( void )
     ModuleInfo.radix      = 10;
     ModuleInfo.fieldalign = Options.fieldalign;
     ModuleInfo.procalign = 0;
+    ModuleInfo.riprelative = Options.pie; /* v2.52 */
 
 #if DLLIMPORT
     /* if OPTION DLLIMPORT was used, reset all iat_used flags */
@@ -932,7 +900,7 @@ static void PassOneChecks( void )
         } else {
             DebugMsg(("PassOneChecks: invalid public attribute for %s [state=%u weak=%u]\n", q->sym->name, q->sym->state, q->sym->weak ));
 #if FASTPASS
-            SkipSavedState();
+            SkipSavedState( FPS_INVALID_PUBLIC, q->sym->name );
 #endif
             break;
         }
@@ -957,7 +925,7 @@ static void PassOneChecks( void )
     for( curr = SymTables[TAB_SEG].head; curr; curr = curr->next ) {
         if( curr->sym.segment == NULL ) {
             DebugMsg(("PassOneChecks: undefined segment %s\n", curr->sym.name ));
-            SkipSavedState();
+            SkipSavedState( FPS_UNDEF_SEGMENT, curr->sym.name );
             break;
         }
     }
@@ -969,7 +937,7 @@ static void PassOneChecks( void )
      */
     for ( q = ModuleInfo.g.SafeSEHQueue.head; q; q = q->next ) {
         if ( q->sym->state != SYM_INTERNAL || q->sym->isproc == FALSE ) {
-            SkipSavedState();
+            SkipSavedState( FPS_SAFESEH, q->sym->name );
             break;
         }
     }
@@ -984,7 +952,7 @@ static void PassOneChecks( void )
             if ( sym == NULL ||
                 ( sym->state != SYM_EXTERNAL &&
                  ( sym->state != SYM_INTERNAL || sym->ispublic == FALSE ))) {
-                SkipSavedState();
+                SkipSavedState( FPS_ALIAS, curr->sym.name );
                 break;
             }
             /* make sure it becomes a strong external */
@@ -995,6 +963,9 @@ static void PassOneChecks( void )
 
 #endif /* FASTPASS */
 
+    /* v2.52: restore declaration order of lazily declared externals */
+    LazyDeclSortExt();
+
     /* scan the EXTERN/EXTERNDEF items */
 
     for( curr = SymTables[TAB_EXT].head ; curr; curr = next ) 
@@ -1043,12 +1014,12 @@ static void PassOneChecks( void )
                 /* for COFF/ELF, the altname must be public or external */
                 if ( curr->sym.altname->ispublic == FALSE && ( Options.output_format == OFORMAT_COFF || Options.output_format == OFORMAT_ELF ) ) 
 				{
-                    SkipSavedState();
+                    SkipSavedState( FPS_ALTNAME, curr->sym.name );
                 }
             } else if ( curr->sym.altname->state != SYM_EXTERNAL ) 
 			{
                 /* do not use saved state, scan full source in second pass */
-                SkipSavedState();
+                SkipSavedState( FPS_ALTNAME, curr->sym.name );
             }
         }
 #endif
@@ -1115,6 +1086,10 @@ static int OnePass( void )
     ProcInit();
     TypesInit();
     HllInit( Parse_Pass );
+    McaInit( Parse_Pass );
+    OptimizeInit( Parse_Pass );
+    DispRelaxInit( Parse_Pass );
+    RipRelInit( Parse_Pass );
     MacroInit( Parse_Pass ); /* insert predefined macros */
     AssumeInit( Parse_Pass );
     CmdlParamsInit( Parse_Pass );
@@ -1201,12 +1176,33 @@ static int OnePass( void )
             MacroLevel = ( LineStoreCurr->srcfile == 0xFFF ? 1 : 0 );
             DebugMsg1(("OnePass(%u) cur/nxt=%X/%X src=%X.%u mlvl=%u: >%s<\n", Parse_Pass+1, LineStoreCurr, LineStoreCurr->next, LineStoreCurr->srcfile, LineStoreCurr->lineno, MacroLevel, LineStoreCurr->line ));
             ModuleInfo.CurrComment = NULL; /* v2.08: added (var is never reset because GetTextLine() isn't called) */
+            if ( LineStoreCurr->rescan ) {
+                /* line contains a text macro which was defined after
+                 * the line has been stored; expand it again.
+                 */
 #if USELSLINE
-            if ( Token_Count = Tokenize( LineStoreCurr->line, 0, ModuleInfo.tokenarray, TOK_DEFAULT ) )
+                strcpy( CurrSource, LineStoreCurr->line );
+#endif
+                if ( ( Token_Count = Tokenize( CurrSource, 0, ModuleInfo.tokenarray, TOK_DEFAULT ) ) ) {
+                    if ( Options.hll_optimize && HllFlush( ModuleInfo.tokenarray ) ) /* v2.52 */
+                        Token_Count = Tokenize( CurrSource, 0, ModuleInfo.tokenarray, TOK_DEFAULT );
+                    if ( ExpandLine( CurrSource, ModuleInfo.tokenarray ) >= NOT_ERROR && Token_Count )
+                        ParseLine( ModuleInfo.tokenarray );
+                }
+            } else
+#if USELSLINE
+            if ( Token_Count = Tokenize( LineStoreCurr->line, 0, ModuleInfo.tokenarray, TOK_DEFAULT ) ) {
+#else
+            if ( Token_Count = Tokenize( CurrSource, 0, ModuleInfo.tokenarray, TOK_DEFAULT ) ) {
+#endif
+                if ( Options.hll_optimize && HllFlush( ModuleInfo.tokenarray ) ) /* v2.52 */
+#if USELSLINE
+                    Token_Count = Tokenize( LineStoreCurr->line, 0, ModuleInfo.tokenarray, TOK_DEFAULT );
 #else
-            if ( Token_Count = Tokenize( CurrSource, 0, ModuleInfo.tokenarray, TOK_DEFAULT ) )
+                    Token_Count = Tokenize( CurrSource, 0, ModuleInfo.tokenarray, TOK_DEFAULT );
 #endif
                 ParseLine( ModuleInfo.tokenarray );
+            }
             LineStoreCurr = LineStoreCurr->next;
         }
     } else
@@ -1224,7 +1220,8 @@ static int OnePass( void )
 
     LinnumFini();
 
-    if ( Parse_Pass == PASS_1 )
+    /* v2.52: -EP has no further passes */
+    if ( Parse_Pass == PASS_1 && Options.preprocessor_stdout == FALSE )
         PassOneChecks();
 
     ClearSrcStack();
@@ -1269,7 +1266,8 @@ static void get_module_name( void )
         ModuleInfo.name[ sizeof( ModuleInfo.name ) - 1] = NULLC;
     } else {
         /* v2.12: _splitpath()/_makepath() removed */
-        const char *fn = GetFNamePart( CurrFName[ASM] );
+        /* v2.52: source read from stdin is module "stdin" */
+        const char *fn = ( IS_STDIO_NAME( CurrFName[ASM] ) ? "stdin" : GetFNamePart( CurrFName[ASM] ) );
         char *ext = GetExtPart( fn );
         memcpy( ModuleInfo.name, fn, ext - fn );
         ModuleInfo.name[ ext - fn ] = NULLC;
@@ -1344,7 +1342,11 @@ static void open_files( void )
     DebugMsg(("open_files() enter\n" ));
 
     //memset( CurrFile, 0, sizeof( CurrFile ) );
-    CurrFile[ASM] = fopen( CurrFName[ASM], "rb" );
+    /* v2.52: "-" is stdin; it's read once into a memory file */
+    if ( IS_STDIO_NAME( CurrFName[ASM] ) )
+        CurrFile[ASM] = MemFileOpen( MemFileStream( ASM ) );
+    else
+        CurrFile[ASM] = fopen( CurrFName[ASM], "rb" );
     if( CurrFile[ASM] == NULL ) {
         DebugMsg(("open_files(): cannot open source file, fopen(\"%s\") failed\n", CurrFName[ASM] ));
         Fatal( CANNOT_OPEN_FILE, CurrFName[ASM], ErrnoStr() );
@@ -1352,8 +1354,17 @@ static void open_files( void )
 	//CheckBOM(CurrFile[ASM]);
 
     /* open OBJ file */
-    if ( Options.syntax_check_only == FALSE ) {
-        CurrFile[OBJ] = fopen( CurrFName[OBJ], "wb" );
+    /* v2.52: with -EP, it's opened only if a name has been set by -Fo;
+     * the preprocessed source is written to it then.
+     */
+    /* v2.52: for "-", the object module is built in a memory file and
+     * copied to stdout when the module is done.
+     */
+    if ( Options.syntax_check_only == FALSE && EP_NO_OUTFILE == FALSE ) {
+        if ( IS_STDIO_NAME( CurrFName[OBJ] ) )
+            CurrFile[OBJ] = MemFileOpen( NULL );
+        else
+            CurrFile[OBJ] = fopen( CurrFName[OBJ], Options.preprocessor_stdout ? "w" : "wb" );
         if( CurrFile[OBJ] == NULL ) {
             DebugMsg(("open_files(): cannot open object file, fopen(\"%s\") failed\n", CurrFName[OBJ] ));
             Fatal( CANNOT_OPEN_FILE, CurrFName[OBJ], ErrnoStr() );
@@ -1362,7 +1373,10 @@ static void open_files( void )
     }
 
     if( Options.write_listing ) {
-        CurrFile[LST] = fopen( CurrFName[LST], "wb" );
+        if ( IS_STDIO_NAME( CurrFName[LST] ) )
+            CurrFile[LST] = MemFileOpen( NULL );
+        else
+            CurrFile[LST] = fopen( CurrFName[LST], "wb" );
         if ( CurrFile[LST] == NULL )
             Fatal( CANNOT_OPEN_FILE, CurrFName[LST], ErrnoStr() );
     }
@@ -1386,26 +1400,37 @@ void close_files( void )
 
     /* close OBJ file */
     if ( CurrFile[OBJ] != NULL ) {
-        if ( fclose( CurrFile[OBJ] ) != 0 )
-            EmitErr( CANNOT_CLOSE_FILE, CurrFName[OBJ], errno );
+        FILE *file = CurrFile[OBJ];
         CurrFile[OBJ] = NULL;
+        /* v2.52: an object module with errors isn't written to stdout */
+        if ( IS_STDIO_NAME( CurrFName[OBJ] ) ) {
+            if ( MemFileClose( file, ModuleInfo.g.error_count ? NULL : MemFileStream( OBJ ) ) != 0 )
+                EmitErr( CANNOT_CLOSE_FILE, CurrFName[OBJ], errno );
+        } else if ( fclose( file ) != 0 )
+            EmitErr( CANNOT_CLOSE_FILE, CurrFName[OBJ], errno );
     }
     /* delete the object module if errors occured */
-    if ( Options.syntax_check_only == FALSE &&
-        ModuleInfo.g.error_count > 0 ) {
+    if ( Options.syntax_check_only == FALSE && EP_NO_OUTFILE == FALSE &&
+        ModuleInfo.g.error_count > 0 && !IS_STDIO_NAME( CurrFName[OBJ] ) ) {
         remove( CurrFName[OBJ] );
     }
 
     if( CurrFile[LST] != NULL ) {
-        fclose( CurrFile[LST] );
+        if ( IS_STDIO_NAME( CurrFName[LST] ) )
+            MemFileClose( CurrFile[LST], MemFileStream( LST ) );
+        else
+            fclose( CurrFile[LST] );
         CurrFile[LST] = NULL;
     }
 
     /* close ERR file */
     if ( CurrFile[ERR] != NULL ) {
-        fclose( CurrFile[ERR] );
+        if ( IS_STDIO_NAME( CurrFName[ERR] ) )
+            MemFileClose( CurrFile[ERR], MemFileStream( ERR ) );
+        else
+            fclose( CurrFile[ERR] );
         CurrFile[ERR] = NULL;
-    } else if ( CurrFName[ERR] )
+    } else if ( CurrFName[ERR] && !IS_STDIO_NAME( CurrFName[ERR] ) )
         /* nothing written, delete any existing ERR file */
         remove( CurrFName[ERR] );
     return;
@@ -1463,9 +1488,22 @@ static void SetFilenames( const char *name )
     CurrFName[ASM] = LclAlloc( strlen( name ) + 1 );
     strcpy( CurrFName[ASM], name );
 
-    /* set [OBJ], [ERR], [LST] */
-    fn = GetFNamePart( name );
+    /* set [OBJ], [ERR], [LST]
+     * v2.52: for source "-" ( stdin ), the names are derived from "stdin";
+     * there's no error file then, unless -Fw is given.
+     */
+    fn = ( IS_STDIO_NAME( name ) ? "stdin" : GetFNamePart( name ) );
     for ( i = ASM+1; i < NUM_FILE_TYPES; i++ ) {
+        if ( i == ERR && Options.names[i] == NULL && IS_STDIO_NAME( name ) ) {
+            CurrFName[i] = NULL;
+            continue;
+        }
+        /* v2.52: output file "-" is stdout */
+        if ( IS_STDIO_NAME( Options.names[i] ) ) {
+            CurrFName[i] = LclAlloc( 2 );
+            strcpy( CurrFName[i], Options.names[i] );
+            continue;
+        }
         if( Options.names[i] == NULL ) {
             path[0] = NULLC;
             if ( DefaultDir[i])
@@ -1517,6 +1555,7 @@ static void AssembleInit( const char *source )
     ModuleInit();
     CondInit();
     ExprEvalInit();
+    LazyDeclInit();
     LstInit();
 
     return;
@@ -1570,8 +1609,8 @@ int EXPQUAL AssembleModule( const char *source )
 {
     uint_32       prev_written = -1;
     uint_32       curr_written;
-    int           starttime;
-    int           endtime;
+    clock_t       starttime;
+    uint_32       msecs;
     struct dsym   *seg;
 
 	struct module_info tempInfo;
@@ -1635,7 +1674,8 @@ int EXPQUAL AssembleModule( const char *source )
         DebugMsg(( "*************\npass %u\n*************\n", Parse_Pass + 1 ));
         OnePass();
 
-        if( ModuleInfo.g.error_count > 0 ) {
+        /* v2.52: -EP is done after one pass */
+        if( ModuleInfo.g.error_count > 0 || Options.preprocessor_stdout ) {
             DebugMsg(("AssembleModule(%u): errorcnt=%u\n", Parse_Pass + 1, ModuleInfo.g.error_count ));
             break;
         }
@@ -1653,8 +1693,15 @@ int EXPQUAL AssembleModule( const char *source )
 
         /* if there's no phase error and size of segments didn't change, we're done */
         DebugMsg(("AssembleModule(%u): PhaseError=%u, prev_written=%" I32_SPEC "X, curr_written=%" I32_SPEC "X\n", Parse_Pass + 1, ModuleInfo.PhaseError, prev_written, curr_written));
-        if( !ModuleInfo.PhaseError && prev_written == curr_written )
-            break;
+        if( !ModuleInfo.PhaseError && prev_written == curr_written ) {
+            /* v2.52: folding and reordering procs and OPTION OPTIMIZE
+             * may require more passes
+             */
+            if ( ( Options.fold_procs == FALSE || FoldProcs() == 0 ) &&
+                ( Options.names[OPTN_ORDER_FN] == NULL || OrderProcs() == 0 ) &&
+                OptimizeCheck() == 0 )
+                break;
+        }
 
 #ifdef DEBUG_OUT
         if ( curr_written < prev_written && prev_written != -1 ) {
@@ -1715,10 +1762,16 @@ int EXPQUAL AssembleModule( const char *source )
     }
     DebugMsg(("AssembleModule: finished, cleanup\n"));
 
+    /* v2.52: -Sc basic block summary */
+    McaFini();
+    OptimizeFini();
+    DispRelaxFini();
+
     /* Write a symbol listing file (if requested) */
     LstWriteCRef();
 
-    endtime = clock(); /* is in ms already */
+    /* v2.52: clock() counts in ms on Windows only */
+    msecs = (uint_32)( ( clock() - starttime ) * 1000 / CLOCKS_PER_SEC );
 
 	if (Options.lessoutput)
 	{
@@ -1771,7 +1824,7 @@ int EXPQUAL AssembleModule( const char *source )
 			GetFName(ModuleInfo.srcfile)->fname,
 			GetLineNumber(),
 			Parse_Pass + 1,
-			endtime - starttime,
+			msecs,
 			ModuleInfo.g.warning_count,
 			ModuleInfo.g.error_count); // write normal string for listing.
 
@@ -1786,7 +1839,7 @@ int EXPQUAL AssembleModule( const char *source )
 						SetConsoleTextAttribute(hConsole, WIN_LTWHITE | (screenBufferInfo.wAttributes & 0xfff0));
 						printf(", ");
 						SetConsoleTextAttribute(hConsole, WIN_CYAN | (screenBufferInfo.wAttributes & 0xfff0));
-						printf("%u ms", endtime - starttime);
+						printf("%u ms", msecs);
 						SetConsoleTextAttribute(hConsole, WIN_LTWHITE | (screenBufferInfo.wAttributes & 0xfff0));
 						printf(", ");
 						SetConsoleTextAttribute(hConsole, WIN_LTYELLOW | (screenBufferInfo.wAttributes & 0xfff0));
@@ -1800,7 +1853,7 @@ int EXPQUAL AssembleModule( const char *source )
 						printf(FWHT("%s: %lu lines, "), GetFNamePart(GetFName(ModuleInfo.srcfile)->fname), GetLineNumber());
 						printf(FGRN("%u passes"), Parse_Pass + 1);
 						printf(", ");
-						printf(FCYN("%u ms"), endtime - starttime);
+						printf(FCYN("%u ms"), msecs);
 						printf(", ");
 						printf(FYEL("%u warnings"), ModuleInfo.g.warning_count);
 						printf(", ");
@@ -1808,6 +1861,19 @@ int EXPQUAL AssembleModule( const char *source )
  			#endif
 		}
 	}
+#if FASTPASS
+    if ( Options.stats )
+        FastpassStats();
+#endif
+    if ( Options.stats ) {
+        LazyDeclStats();
+        FoldStats();
+        OrderStats();
+        HllStats();
+        EncoderStats();
+        DispRelaxStats();
+        RipRelStats();
+    }
 	if (Options.quiet == FALSE)
 	{
 		fflush(stdout); /* Force flush of each modules assembly progress */
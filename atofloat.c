@@ -8,26 +8,703 @@
 *
 ****************************************************************************/
 
-#include <float.h>
-#include <math.h>
+#include <ctype.h>
 
 #include "globals.h"
 #include "tbyte.h"
 #include "atofloat.h"
-
-#define USESTRTOF 0 /* 0=use strtod() and convert "manually", 1=use strtof() */
+#include "pow5tab.h"
 
 extern void myatoi128( const char *, uint_64[], int, int );
 
+/* v2.52: decimal strings are no longer converted by strtod() and strtotb().
+ * The conversion is done with integer arithmetic only and the result is
+ * correctly rounded ( round to nearest, ties to even ) for all sizes:
+ * - REAL4 and REAL8 use the Eisel-Lemire algorithm: the first 19 digits
+ *   are multiplied with a 128-bit power of 5. This gives the result for
+ *   almost all numbers.
+ * - the rare cases that Eisel-Lemire can't decide and all REAL10 numbers
+ *   are converted exactly with big integers ( BigConvert() ).
+ */
+
+#if defined(LLONG_MAX) || defined(__GNUC__) || defined(__TINYC__)
+#define HIGHBIT64 0x8000000000000000ULL
+#define ALLBITS64 0xFFFFFFFFFFFFFFFFULL
+#else
+#define HIGHBIT64 0x8000000000000000ui64
+#define ALLBITS64 0xFFFFFFFFFFFFFFFFui64
+#endif
+
+#define MAXDIGITS MAX_LINE_LEN /* a float token can't be longer than a line */
+#define BIGLIMBS  530          /* 16960 bits, enough for the REAL10 range */
+
+struct decimal {
+    uint_64  w;           /* the first 19 significant digits */
+    int_32   q;           /* decimal exponent of w */
+    int_32   exp10;       /* value is 0.<digits> * 10^exp10 */
+    unsigned ndigits;     /* significant digits in digits[] */
+    bool     truncated;   /* w doesn't contain all significant digits */
+    bool     sticky;      /* nonzero digits beyond MAXDIGITS */
+    bool     negative;
+    uint_8   special;     /* 'i' = infinity, 'n' = NaN */
+    uint_8   digits[MAXDIGITS];
+};
+
+/* float formats. minq, maxq, minrte and maxrte are used by Eisel-Lemire only */
+
+struct flt_format {
+    int_32  mbits;        /* explicit mantissa bits */
+    int_32  bias;         /* exponent bias */
+    int_32  infexp;       /* biased exponent of infinity */
+    int_32  min10;        /* numbers below 10^min10 are zero */
+    int_32  max10;        /* numbers >= 10^(max10+1) are infinite */
+    int_32  minq;         /* w * 10^q is zero if q < minq */
+    int_32  maxq;         /* w * 10^q is infinite if q > maxq */
+    int_32  minrte;       /* range of q where ties may occur */
+    int_32  maxrte;
+};
+
+static const struct flt_format fmt_real4  = { 23,   127,   0xFF,   -46,   38, -65,  38, -17, 10 };
+static const struct flt_format fmt_real8  = { 52,  1023,  0x7FF,  -324,  308, -342, 308,  -4, 23 };
+static const struct flt_format fmt_real10 = { 63, 16383, 0x7FFF, -4951, 4932,   0,   0,   0,  0 };
+
+/* mantissa ( hidden bit included ) and biased exponent */
+
+struct adj_mant {
+    uint_64 m;
+    int_32  e;
+};
+
+struct bignum {
+    unsigned len;         /* limbs in use */
+    uint_32  limb[BIGLIMBS];
+};
+
+static const uint_32 pow5_32[] = { 1, 5, 25, 125, 625, 3125, 15625, 78125,
+    390625, 1953125, 9765625, 48828125, 244140625, 1220703125 };
+
+static void ParseDecimal( const char *p, struct decimal *dec )
+/************************************************************/
+{
+    bool     gotdot = FALSE;
+    bool     expneg = FALSE;
+    int_32   exp = 0;
+    int_32   exp10 = 0;
+    unsigned nd = 0;
+    unsigned i;
+    uint_64  w;
+
+    dec->sticky = FALSE;
+    dec->negative = FALSE;
+    dec->special = NULLC;
+
+    while ( isspace( *p ) ) p++;
+    if ( *p == '-' ) {
+        dec->negative = TRUE;
+        p++;
+    } else if ( *p == '+' )
+        p++;
+
+    /* "inf" and "nan" may be emitted by sprintf() */
+    if ( ( p[0] | 0x20 ) == 'i' && ( p[1] | 0x20 ) == 'n' && ( p[2] | 0x20 ) == 'f' ) {
+        dec->special = 'i';
+        return;
+    }
+    if ( ( p[0] | 0x20 ) == 'n' && ( p[1] | 0x20 ) == 'a' && ( p[2] | 0x20 ) == 'n' ) {
+        dec->special = 'n';
+        return;
+    }
+
+    /* skip leading zeros */
+    for ( ; ; p++ ) {
+        if ( *p == '.' && gotdot == FALSE )
+            gotdot = TRUE;
+        else if ( *p == '0' )
+            exp10 -= gotdot;
+        else
+            break;
+    }
+    for ( ; ; p++ ) {
+        if ( (unsigned)( *p - '0' ) < 10 ) {
+            exp10 += !gotdot;
+            if ( nd < MAXDIGITS )
+                dec->digits[nd++] = *p - '0';
+            else if ( *p != '0' )
+                dec->sticky = TRUE;
+        } else if ( *p == '.' && gotdot == FALSE )
+            gotdot = TRUE;
+        else
+            break;
+    }
+
+    /* the exponent is ignored if there's no digit behind the 'e' */
+    if ( ( *p | 0x20 ) == 'e' ) {
+        p++;
+        if ( *p == '-' ) {
+            expneg = TRUE;
+            p++;
+        } else if ( *p == '+' )
+            p++;
+        for ( ; (unsigned)( *p - '0' ) < 10; p++ )
+            if ( exp < 100000 )
+                exp = exp * 10 + ( *p - '0' );
+        exp10 += ( expneg ? -exp : exp );
+    }
+
+    while ( nd && dec->digits[nd - 1] == 0 )
+        nd--;
+
+    for ( i = 0, w = 0; i < nd && i < 19; i++ )
+        w = w * 10 + dec->digits[i];
+    dec->w = w;
+    dec->q = exp10 - i;
+    dec->exp10 = exp10;
+    dec->ndigits = nd;
+    dec->truncated = ( nd > 19 || dec->sticky );
+    return;
+}
+
+/* 64 x 64 -> 128 bit multiplication */
+
+static void Mul64( uint_64 a, uint_64 b, uint_64 *hi, uint_64 *lo )
+/*****************************************************************/
+{
+    uint_64 a0 = (uint_32)a;
+    uint_64 a1 = a >> 32;
+    uint_64 b0 = (uint_32)b;
+    uint_64 b1 = b >> 32;
+    uint_64 p01 = a0 * b1;
+    uint_64 p10 = a1 * b0;
+    uint_64 p00 = a0 * b0;
+    uint_64 mid = ( p00 >> 32 ) + (uint_32)p01 + (uint_32)p10;
+
+    *lo = ( mid << 32 ) | (uint_32)p00;
+    *hi = a1 * b1 + ( p01 >> 32 ) + ( p10 >> 32 ) + ( mid >> 32 );
+}
+
+static int Clz64( uint_64 x )
+/***************************/
+{
+    int n;
+    int i;
+
+    for ( n = 0, i = 32; i; i >>= 1 )
+        if ( ( x >> ( 64 - i ) ) == 0 ) {
+            x <<= i;
+            n += i;
+        }
+    return( n );
+}
+
+/* 128 / 64 -> 64 bit division. v must be normalized ( bit 63 set )
+ * and u1 < v. this is algorithm divlu of "Hacker's Delight".
+ */
+
+static uint_64 Div128( uint_64 u1, uint_64 u0, uint_64 v, uint_64 *rem )
+/**********************************************************************/
+{
+    uint_64 vn1 = v >> 32;
+    uint_64 vn0 = (uint_32)v;
+    uint_64 un1 = u0 >> 32;
+    uint_64 un0 = (uint_32)u0;
+    uint_64 un21;
+    uint_64 q1;
+    uint_64 q0;
+    uint_64 rhat;
+
+    q1 = u1 / vn1;
+    rhat = u1 - q1 * vn1;
+    while ( ( q1 >> 32 ) || q1 * vn0 > ( ( rhat << 32 ) | un1 ) ) {
+        q1--;
+        rhat += vn1;
+        if ( rhat >> 32 )
+            break;
+    }
+    un21 = ( u1 << 32 ) + un1 - q1 * v;
+    q0 = un21 / vn1;
+    rhat = un21 - q0 * vn1;
+    while ( ( q0 >> 32 ) || q0 * vn0 > ( ( rhat << 32 ) | un0 ) ) {
+        q0--;
+        rhat += vn1;
+        if ( rhat >> 32 )
+            break;
+    }
+    *rem = ( un21 << 32 ) + un0 - q0 * v;
+    return( ( q1 << 32 ) + q0 );
+}
+
+/* Eisel-Lemire: compute w * 10^q, correctly rounded.
+ * returns FALSE if the 128-bit product isn't precise enough.
+ */
+
+static bool EiselLemire( uint_64 w, int_32 q, const struct flt_format *fmt, struct adj_mant *am )
+/***********************************************************************************************/
+{
+    const uint_64 *pow5;
+    uint_64 hi;
+    uint_64 lo;
+    uint_64 hi2;
+    uint_64 lo2;
+    uint_64 mask;
+    int     lz;
+    int     upperbit;
+    int     shift;
+
+    am->m = 0;
+    am->e = 0;
+    if ( w == 0 || q < fmt->minq )
+        return( TRUE );
+    if ( q > fmt->maxq ) {
+        am->e = fmt->infexp;
+        return( TRUE );
+    }
+    lz = Clz64( w );
+    w <<= lz;
+
+    pow5 = &pow5tab[2 * ( q - POW5_MIN )];
+    Mul64( w, pow5[0], &hi, &lo );
+    /* if the bits below the mantissa ( + 1 rounding bit ) are all set,
+     * the low half of the power may matter.
+     */
+    mask = ALLBITS64 >> ( fmt->mbits + 3 );
+    if ( ( hi & mask ) == mask ) {
+        Mul64( w, pow5[1], &hi2, &lo2 );
+        lo += hi2;
+        if ( hi2 > lo )
+            hi++;
+    }
+    if ( lo == ALLBITS64 && ( q < -27 || q > 55 ) )
+        return( FALSE );
+
+    upperbit = (int)( hi >> 63 );
+    shift = upperbit + 64 - fmt->mbits - 3;
+    am->m = hi >> shift;
+    /* ( 217706 * q ) >> 16 is floor( q * log2(10) ) */
+    am->e = ( ( ( 152170 + 65536 ) * q ) >> 16 ) + 63 + upperbit - lz + fmt->bias;
+
+    if ( am->e <= 0 ) {
+        /* denormal. ties can't happen here */
+        if ( -am->e + 1 >= 64 ) {
+            am->m = 0;
+            am->e = 0;
+            return( TRUE );
+        }
+        am->m >>= -am->e + 1;
+        am->m += ( am->m & 1 );
+        am->m >>= 1;
+        am->e = ( am->m < ( (uint_64)1 << fmt->mbits ) ) ? 0 : 1;
+        return( TRUE );
+    }
+    /* if the product is exact and exactly halfway, round to even */
+    if ( lo <= 1 && q >= fmt->minrte && q <= fmt->maxrte && ( am->m & 3 ) == 1 ) {
+        if ( ( am->m << shift ) == hi )
+            am->m &= ~(uint_64)1;
+    }
+    am->m += ( am->m & 1 );
+    am->m >>= 1;
+    if ( am->m >= ( (uint_64)2 << fmt->mbits ) ) {
+        am->m = (uint_64)1 << fmt->mbits;
+        am->e++;
+    }
+    if ( am->e >= fmt->infexp ) {
+        am->m = 0;
+        am->e = fmt->infexp;
+    }
+    return( TRUE );
+}
+
+/* big integer functions used by BigConvert() */
+
+static void BigMulAdd( struct bignum *b, uint_32 mul, uint_32 add )
+/*****************************************************************/
+{
+    uint_64  cy = add;
+    unsigned i;
+
+    for ( i = 0; i < b->len; i++ ) {
+        cy += (uint_64)b->limb[i] * mul;
+        b->limb[i] = (uint_32)cy;
+        cy >>= 32;
+    }
+    if ( cy && b->len < BIGLIMBS )
+        b->limb[b->len++] = (uint_32)cy;
+}
+
+static void BigMulPow5( struct bignum *b, int_32 n )
+/**************************************************/
+{
+    for ( ; n >= 13; n -= 13 )
+        BigMulAdd( b, pow5_32[13], 0 );
+    if ( n )
+        BigMulAdd( b, pow5_32[n], 0 );
+}
+
+static void BigShl( struct bignum *b, int_32 n )
+/**********************************************/
+{
+    unsigned words = n / 32;
+    unsigned bits = n % 32;
+    unsigned i;
+
+    if ( b->len == 0 )
+        return;
+    if ( bits ) {
+        if ( b->len < BIGLIMBS )
+            b->limb[b->len++] = 0;
+        for ( i = b->len - 1; i > 0; i-- )
+            b->limb[i] = ( b->limb[i] << bits ) | ( b->limb[i-1] >> ( 32 - bits ) );
+        b->limb[0] <<= bits;
+    }
+    if ( words ) {
+        if ( b->len + words > BIGLIMBS )
+            words = BIGLIMBS - b->len;
+        memmove( &b->limb[words], &b->limb[0], b->len * sizeof( uint_32 ) );
+        memset( &b->limb[0], 0, words * sizeof( uint_32 ) );
+        b->len += words;
+    }
+    while ( b->len && b->limb[b->len - 1] == 0 )
+        b->len--;
+}
+
+static void BigShr1( struct bignum *b )
+/*************************************/
+{
+    unsigned i;
+
+    for ( i = 0; i + 1 < b->len; i++ )
+        b->limb[i] = ( b->limb[i] >> 1 ) | ( b->limb[i+1] << 31 );
+    if ( b->len ) {
+        b->limb[i] >>= 1;
+        if ( b->limb[i] == 0 )
+            b->len--;
+    }
+}
+
+static int BigCmp( const struct bignum *a, const struct bignum *b )
+/*****************************************************************/
+{
+    unsigned i;
+
+    if ( a->len != b->len )
+        return( a->len > b->len ? 1 : -1 );
+    for ( i = a->len; i; i-- )
+        if ( a->limb[i-1] != b->limb[i-1] )
+            return( a->limb[i-1] > b->limb[i-1] ? 1 : -1 );
+    return( 0 );
+}
+
+/* a -= b; a must be >= b */
+
+static void BigSub( struct bignum *a, const struct bignum *b )
+/************************************************************/
+{
+    int_64   cy = 0;
+    unsigned i;
+
+    for ( i = 0; i < a->len; i++ ) {
+        cy += (int_64)a->limb[i] - ( i < b->len ? b->limb[i] : 0 );
+        a->limb[i] = (uint_32)cy;
+        cy = ( cy < 0 ? -1 : 0 );
+    }
+    while ( a->len && a->limb[a->len - 1] == 0 )
+        a->len--;
+}
+
+static int_32 BigBits( const struct bignum *b )
+/*********************************************/
+{
+    uint_32 x;
+    int_32  n;
+
+    if ( b->len == 0 )
+        return( 0 );
+    for ( x = b->limb[b->len - 1], n = ( b->len - 1 ) * 32; x; x >>= 1, n++ );
+    return( n );
+}
+
+/* get bit n; bits below bit 0 are zero */
+
+static unsigned BigBit( const struct bignum *b, int_32 n )
+/********************************************************/
+{
+    if ( n < 0 || n / 32 >= (int_32)b->len )
+        return( 0 );
+    return( ( b->limb[n / 32] >> ( n % 32 ) ) & 1 );
+}
+
+/* check if any bit below bit n is set */
+
+static bool BigAnyBelow( const struct bignum *b, int_32 n )
+/*********************************************************/
+{
+    int_32 i;
+
+    if ( n <= 0 )
+        return( FALSE );
+    for ( i = 0; i < n / 32 && i < (int_32)b->len; i++ )
+        if ( b->limb[i] )
+            return( TRUE );
+    if ( i < (int_32)b->len && ( n % 32 ) && ( b->limb[i] << ( 32 - n % 32 ) ) )
+        return( TRUE );
+    return( FALSE );
+}
+
+/* round t * 2^f to the float format; t is normalized ( bit 63 set ).
+ * g is the bit below t, s is set if there are more bits below g.
+ */
+
+static void RoundMant( uint_64 t, int_32 f, unsigned g, bool s, const struct flt_format *fmt, struct adj_mant *am )
+/****************************************************************************************************************/
+{
+    int_32 e = f + 63 + fmt->bias;
+    int_32 r = 63 - fmt->mbits; /* bits to drop */
+    unsigned guard;
+    bool sticky;
+
+    if ( e <= 0 ) {
+        /* denormal */
+        r += 1 - e;
+        e = 0;
+    }
+    if ( r >= 65 ) {
+        am->m = 0;
+        am->e = 0;
+        return;
+    } else if ( r == 64 ) {
+        am->m = 0;
+        guard = 1;
+        sticky = ( ( t << 1 ) != 0 || g || s );
+    } else if ( r == 0 ) {
+        am->m = t;
+        guard = g;
+        sticky = s;
+    } else {
+        am->m = t >> r;
+        guard = ( t >> ( r - 1 ) ) & 1;
+        sticky = ( ( t & ( ( (uint_64)1 << ( r - 1 ) ) - 1 ) ) != 0 || g || s );
+    }
+    if ( guard && ( sticky || ( am->m & 1 ) ) ) {
+        am->m++;
+        /* for REAL10, 2 << 63 is 0, which is what m wraps to */
+        if ( am->m == ( (uint_64)2 << fmt->mbits ) ) {
+            am->m = (uint_64)1 << fmt->mbits;
+            e++;
+        }
+    }
+    if ( e == 0 && ( am->m >> fmt->mbits ) )
+        e = 1;
+    if ( e >= fmt->infexp ) {
+        am->m = 0;
+        e = fmt->infexp;
+    }
+    am->e = e;
+}
+
+/* exact conversion of w * 10^q if 5^|q| fits in 64 bits.
+ * this is the usual case for REAL10.
+ */
+
+static bool ExactConvert( uint_64 w, int_32 q, const struct flt_format *fmt, struct adj_mant *am )
+/************************************************************************************************/
+{
+    uint_64 pow5;
+    uint_64 hi;
+    uint_64 lo;
+    uint_64 rem;
+    int     lz;
+    int     ly;
+
+    if ( q < -27 || q > 27 )
+        return( FALSE );
+    for ( pow5 = 1, lz = ( q < 0 ? -q : q ); lz; lz-- )
+        pow5 *= 5;
+
+    if ( q >= 0 ) {
+        /* w * 5^q * 2^q */
+        Mul64( w, pow5, &hi, &lo );
+        if ( hi == 0 ) {
+            lz = Clz64( lo );
+            RoundMant( lo << lz, q - lz, 0, FALSE, fmt, am );
+        } else {
+            lz = Clz64( hi );
+            if ( lz ) {
+                hi = ( hi << lz ) | ( lo >> ( 64 - lz ) );
+                lo <<= lz;
+            }
+            RoundMant( hi, q + 64 - lz, (unsigned)( lo >> 63 ), ( lo << 1 ) != 0, fmt, am );
+        }
+        return( TRUE );
+    }
+
+    /* w * 2^q / 5^-q: both w and 5^-q are normalized, the dividend
+     * is w * 2^64 or w * 2^63, so the quotient has 64 bits.
+     */
+    lz = Clz64( w );
+    w <<= lz;
+    ly = Clz64( pow5 );
+    pow5 <<= ly;
+    if ( w < pow5 ) {
+        hi = Div128( w, 0, pow5, &rem );
+        ly -= 64;
+    } else {
+        hi = Div128( w >> 1, w << 63, pow5, &rem );
+        ly -= 63;
+    }
+    /* guard bit is set if 2 * rem >= pow5 */
+    RoundMant( hi, q - lz + ly, ( rem >= pow5 - rem ), ( rem != 0 && rem != pow5 - rem ), fmt, am );
+    return( TRUE );
+}
+
+/* exact conversion of all digits with big integers.
+ * the value is D * 10^e, D being the integer made of all digits.
+ */
+
+static void BigConvert( const struct decimal *dec, const struct flt_format *fmt, struct adj_mant *am )
+/****************************************************************************************************/
+{
+    struct bignum x;
+    struct bignum y;
+    struct bignum t;
+    int_32   e = dec->exp10 - dec->ndigits;
+    int_32   bits;
+    int_32   sh;
+    uint_64  m;
+    unsigned g;
+    unsigned i;
+    int      k;
+
+    am->m = 0;
+    am->e = 0;
+    /* numbers out of range would need larger big integers */
+    if ( dec->ndigits == 0 || dec->exp10 - 1 < fmt->min10 )
+        return;
+    if ( dec->exp10 - 1 > fmt->max10 ) {
+        am->e = fmt->infexp;
+        return;
+    }
+
+    x.len = 0;
+    for ( i = 0; i < dec->ndigits; ) {
+        uint_32 chunk = 0;
+        for ( k = 0; k < 9 && i < dec->ndigits; k++, i++ )
+            chunk = chunk * 10 + dec->digits[i];
+        BigMulAdd( &x, pow5_32[k] << k, chunk ); /* 10^k = 5^k * 2^k */
+    }
+
+    if ( e >= 0 ) {
+        /* D * 5^e * 2^e: take the upper 64 bits */
+        BigMulPow5( &x, e );
+        bits = BigBits( &x );
+        for ( m = 0, k = 1; k <= 64; k++ )
+            m = ( m << 1 ) | BigBit( &x, bits - k );
+        RoundMant( m, e + bits - 64, BigBit( &x, bits - 65 ),
+                  BigAnyBelow( &x, bits - 65 ) || dec->sticky, fmt, am );
+        return;
+    }
+
+    /* D / ( 5^-e * 2^-e ): divide D * 2^sh by 5^-e, with sh chosen so
+     * that the quotient is in the range 2^62 - 2^64.
+     */
+    y.len = 1;
+    y.limb[0] = 1;
+    BigMulPow5( &y, -e );
+    sh = 63 - ( BigBits( &x ) - BigBits( &y ) );
+    if ( sh > 0 )
+        BigShl( &x, sh );
+    else if ( sh < 0 )
+        BigShl( &y, -sh );
+    t = y;
+    BigShl( &t, 63 );
+    for ( m = 0, k = 63; k >= 0; k--, BigShr1( &t ) ) {
+        if ( BigCmp( &x, &t ) >= 0 ) {
+            BigSub( &x, &t );
+            m |= (uint_64)1 << k;
+        }
+    }
+    if ( ( m & HIGHBIT64 ) == 0 ) {
+        /* one more quotient bit is needed */
+        BigShl( &x, 1 );
+        m <<= 1;
+        if ( BigCmp( &x, &y ) >= 0 ) {
+            BigSub( &x, &y );
+            m |= 1;
+        }
+        sh++;
+    }
+    BigShl( &x, 1 );
+    g = 0;
+    if ( BigCmp( &x, &y ) >= 0 ) {
+        BigSub( &x, &y );
+        g = 1;
+    }
+    RoundMant( m, e - sh, g, x.len != 0 || dec->sticky, fmt, am );
+}
+
+/* convert a decimal string to REAL4, REAL8 or REAL10.
+ * returns FALSE if the magnitude doesn't fit.
+ */
+
+static bool DecToFloat( void *out, const char *inp, unsigned size, bool negative )
+/********************************************************************************/
+{
+    const struct flt_format *fmt;
+    struct decimal dec;
+    struct adj_mant am;
+    struct adj_mant am2;
+    bool ok = TRUE;
+
+    fmt = ( size == 4 ? &fmt_real4 : ( size == 8 ? &fmt_real8 : &fmt_real10 ) );
+    ParseDecimal( inp, &dec );
+    if ( dec.negative )
+        negative = !negative;
+
+    if ( dec.special ) {
+        /* infinity or quiet NaN */
+        am.e = fmt->infexp;
+        am.m = ( dec.special == 'n' ? (uint_64)1 << ( fmt->mbits - 1 ) : 0 );
+    } else if ( dec.ndigits == 0 ) {
+        am.m = 0;
+        am.e = 0;
+    } else if ( size == 10 ) {
+        if ( dec.truncated || ExactConvert( dec.w, dec.q, fmt, &am ) == FALSE )
+            BigConvert( &dec, fmt, &am );
+    } else if ( EiselLemire( dec.w, dec.q, fmt, &am ) == FALSE ||
+               ( dec.truncated && ( EiselLemire( dec.w + 1, dec.q, fmt, &am2 ) == FALSE ||
+                                   am.m != am2.m || am.e != am2.e ) ) ) {
+        BigConvert( &dec, fmt, &am );
+    }
+
+    if ( dec.special == NULLC && dec.ndigits ) {
+        /* overflow, or a denormal/zero from a nonzero number.
+         * REAL10 denormals are accepted.
+         */
+        if ( am.e == fmt->infexp || ( am.e == 0 && size != 10 ) )
+            ok = FALSE;
+    }
+
+    /* REAL10 has an explicit integer bit, which is also set for infinity and NaN */
+    if ( size == 10 && am.e == fmt->infexp )
+        am.m |= HIGHBIT64;
+
+    switch ( size ) {
+    case 4:
+        *(uint_32 *)out = ( (uint_32)am.e << 23 ) | ( (uint_32)am.m & 0x7FFFFF ) | ( negative ? 0x80000000 : 0 );
+        break;
+    case 8:
+        *(uint_64 *)out = ( (uint_64)am.e << 52 ) | ( am.m & ( ALLBITS64 >> 12 ) ) | ( negative ? HIGHBIT64 : 0 );
+        break;
+    default:
+        ((struct TB_LD *)out)->m = am.m;
+        ((struct TB_LD *)out)->e = am.e | ( negative ? 0x8000 : 0 );
+    }
+    return( ok );
+}
+
 /* it's ensured that 'out' points to a buffer with a size of at least 16 */
 
 void atofloat( void *out, const char *inp, unsigned size, bool negative, uint_8 ftype )
 /*************************************************************************************/
 {
-    //const char *inp;
-    double  double_value;
-    float   float_value;
-
     /* v2.04: accept and handle 'real number designator' */
     if ( ftype ) {
         uint_8 *p;
@@ -47,44 +724,13 @@ void atofloat( void *out, const char *inp, unsigned size, bool negative, uint_8
     } else {
         switch ( size ) {
         case 4:
-#if USESTRTOF
-            errno = 0;
-            float_value = strtof( inp, NULL );
-            if ( errno == ERANGE ) {
-                DebugMsg(("atofloat(%s, 4): magnitude too large\n", inp ));
-                EmitErr( MAGNITUDE_TOO_LARGE_FOR_SPECIFIED_SIZE );
-            }
-            if( negative )
-                float_value *= -1;
-#else
-            double_value = strtod( inp, NULL );
-            /* v2.06: check FLT_MAX added */
-            /* v2.11: check FLT_MIN (min positive value) added */
-            //if ( double_value > FLT_MAX )
-            if ( double_value > FLT_MAX || ( double_value < FLT_MIN && double_value != 0 ) ) {
-                DebugMsg(("atofloat(%s, 4): magnitude too large; FLT_MAX=%e FLT_MIN=%e\n", inp, FLT_MAX, FLT_MIN ));
-                EmitErr( MAGNITUDE_TOO_LARGE_FOR_SPECIFIED_SIZE );
-            }
-            if( negative )
-                double_value *= -1;
-            float_value = double_value;
-#endif
-            *(float *)out = float_value;
-            break;
         case 8:
-            errno = 0; /* v2.11: init errno; errno is set on over- and under-flow */
-            double_value = strtod( inp, NULL );
-            /* v2.11: check added */
-            if ( errno == ERANGE ) {
-                DebugMsg(("atofloat(%s, 8): magnitude too large\n", inp ));
+        case 10:
+            /* v2.52: conversion is done by DecToFloat() */
+            if ( DecToFloat( out, inp, size, negative ) == FALSE ) {
+                DebugMsg(("atofloat(%s, %u): magnitude too large\n", inp, size ));
                 EmitErr( MAGNITUDE_TOO_LARGE_FOR_SPECIFIED_SIZE );
             }
-            if( negative )
-                double_value *= -1;
-            *(double *)out = double_value;
-            break;
-        case 10:
-            strtotb( inp, (struct TB_LD *)out, negative );
             break;
         default:
             /* sizes != 4,8 or 10 aren't accepted.
@@ -52,6 +52,10 @@
 #endif
 
 #include "orgfixup.h"
+#include "jit.h"
+#if AMD64_SUPPORT
+#include "win64seh.h"
+#endif
 
 extern void SortSegments( int );
 
@@ -120,10 +124,8 @@ enum pe_flags_values {
 
 static const char hdrattr[]   = { "read public 'HDR'" };
 static const char edataname[] = { ".edata" };
-static const char edataattr[] = { "FLAT read public alias('.rdata') 'DATA'" };
-static const char idataname[] = { ".idata$" };
-//static const char idataattr[] = { "FLAT read public 'DATA'" };
-static const char idataattr[] = { "FLAT read public alias('.rdata') 'DATA'" };
+#define idataname ".idata$"
+static const char rdataname[] = { ".rdata" };
 
 static const char mzcode[] = {
     "db 'MZ'\0"           /* e_magic */
@@ -860,21 +862,80 @@ static void pe_create_section_table( void )
     }
 }
 
-/*
- struct IMAGE_EXPORT_DIRECTORY {
- uint_32 Characteristics;
- uint_32 TimeDateStamp;
- uint_16 MajorVersion;
- uint_16 MinorVersion;
- uint_32 Name;  // RVA name of dll
- uint_32 Base;  // ordinal base
- uint_32 NumberOfFunctions;
- uint_32 NumberOfNames;
- uint_32 AddressOfFunctions; // RVA of function table (array of RVAs)
- uint_32 AddressOfNames;     // RVA of function names (array of RVAs)
- uint_32 AddressOfNameOrdinals; // RVA (array of shorts)
- };
-*/
+/* v2.52: the export and import directories are no longer generated as
+ * source lines that had to be tokenized and parsed in every pass. The
+ * sections are created as internal segments, their contents are written
+ * directly and the RVAs are FIX_OFF32_IMGREL fixups, resolved by DoFixup()
+ * once the section addresses are known.
+ */
+
+/* create the internal segment for an export/import section. The attributes
+ * are those of "<name> SEGMENT <align> FLAT read public alias('.rdata') 'DATA'".
+ */
+static struct dsym *pe_create_dirseg( const char *name, uint_8 alignment )
+/************************************************************************/
+{
+    struct dsym *seg;
+
+    seg = (struct dsym *)SymSearch( name );
+    if ( seg && seg->sym.state == SYM_SEG && seg->e.seginfo->internal == FALSE ) {
+        EmitErr( SYMBOL_REDEFINITION, name );
+        return( NULL );
+    }
+    if ( seg == NULL || seg->sym.state != SYM_SEG ) {
+        seg = (struct dsym *)CreateIntSegment( name, "DATA", alignment, ModuleInfo.defOfssize, TRUE );
+        if ( seg == NULL )
+            return( NULL );
+        seg->sym.list = TRUE;
+        seg->e.seginfo->group = &ModuleInfo.flat_grp->sym;
+        seg->e.seginfo->combine = COMB_ADDOFF;  /* PUBLIC */
+        seg->e.seginfo->segtype = SEGTYPE_DATA;
+        seg->e.seginfo->characteristics = ( IMAGE_SCN_MEM_READ >> 24 );
+        seg->e.seginfo->aliasname = (char *)rdataname;
+    }
+    seg->e.seginfo->FixupList.head = NULL;
+    seg->e.seginfo->FixupList.tail = NULL;
+    return( seg );
+}
+
+/* set contents of an export/import section */
+static uint_8 *pe_alloc_dirseg( struct dsym *seg, uint_32 size )
+/**************************************************************/
+{
+    seg->e.seginfo->CodeBuffer = LclAlloc( size );
+    memset( seg->e.seginfo->CodeBuffer, 0, size );
+    seg->sym.max_offset = size;
+    seg->e.seginfo->bytes_written = size;
+    return( seg->e.seginfo->CodeBuffer );
+}
+
+/* add an image relative fixup at <locofs> in <seg>; target is <sym> + <offset> */
+static void pe_add_imgrel( struct dsym *seg, uint_32 locofs, struct asym *sym, uint_32 offset )
+/********************************************************************************************/
+{
+    struct fixup *fixup;
+
+    fixup = LclAlloc( sizeof( struct fixup ) );
+#ifdef TRMEM
+    fixup->marker = 'XF';
+#endif
+    fixup->nextbp = NULL;
+    fixup->nextrlc = NULL;
+    fixup->offset = offset;
+    fixup->locofs = locofs;
+    fixup->type = FIX_OFF32_IMGREL;
+    fixup->option = OPTJ_NONE;
+    fixup->flags = 0;
+    fixup->frame_type = FRAME_NONE;
+    fixup->frame_datum = 0;
+    fixup->def_seg = seg;
+    fixup->sym = sym;
+    if ( seg->e.seginfo->FixupList.head == NULL )
+        seg->e.seginfo->FixupList.head = fixup;
+    else
+        seg->e.seginfo->FixupList.tail->nextrlc = fixup;
+    seg->e.seginfo->FixupList.tail = fixup;
+}
 
 struct expitem {
     char *name;
@@ -887,87 +948,172 @@ static int compare_exp( const void *p1, const void *p2 )
     return( strcmp( ((struct expitem *)p1)->name, ((struct expitem *)p2)->name ) );
 }
 
+/* write export data.
+ * .edata: export directory, export address table, name pointer table,
+ * ordinal table, dll name, export names.
+ */
+
 static void pe_emit_export_data( void )
 /*************************************/
 {
     struct dsym *curr;
-    int_32 timedate;
-    int cnt;
-    int i;
-    char *name;
-    char *fname;
+    struct dsym *edata;
+    struct IMAGE_EXPORT_DIRECTORY *expdir;
     struct expitem *pitems;
     struct expitem *pexp;
+    uint_8 *buffer;
+    char *fname;
+    int cnt;
+    int i;
+    uint_32 ofs_eat;
+    uint_32 ofs_names;
+    uint_32 ofs_ord;
+    uint_32 ofs_dll;
+    uint_32 ofs;
 
     DebugMsg(("pe_emit_export_data enter\n" ));
     for( curr = SymTables[TAB_PROC].head, cnt = 0; curr; curr = curr->nextproc ) {
         if( curr->e.procinfo->isexport )
             cnt++;
     }
-    if ( cnt ) {
-        name = ModuleInfo.name;
-        AddLineQueueX( "%r DOTNAME", T_OPTION );
-        /* create .edata segment */
-        AddLineQueueX( "%s %r %r %s", edataname, T_SEGMENT, T_DWORD, edataattr );
-#if 0 //def __UNIX__
-        time( &timedate );
-#else
-        time( (time_t *)&timedate );
-#endif
-        /* create export directory: Characteristics, Timedate, MajMin, Name, Base, ... */
-        AddLineQueueX( "DD 0, 0%xh, 0, %r @%s_name, %u, %u, %u, %r @%s_func, %r @%s_names, %r @%s_nameord",
-                      timedate, T_IMAGEREL, name, 1, cnt, cnt, T_IMAGEREL, name, T_IMAGEREL, name, T_IMAGEREL, name );
+    if ( cnt == 0 )
+        return;
+    if ( ( edata = pe_create_dirseg( edataname, 2 ) ) == NULL )
+        return;
 
-        /* the name pointer table must be in ascending order!
-         * so we have to fill an array of exports and sort it.
-         */
-        pitems = (struct expitem *)myalloca( cnt * sizeof( struct expitem ) );
-        for( curr = SymTables[TAB_PROC].head, pexp = pitems, i = 0; curr; curr = curr->nextproc ) {
-            if( curr->e.procinfo->isexport ) {
-                pexp->name = curr->sym.name;
-                pexp->idx  = i++;
-                pexp++;
-            }
+    /* v2.10: name+ext of dll */
+    for ( fname = CurrFName[OBJ] + strlen( CurrFName[OBJ] ); fname > CurrFName[OBJ]; fname-- )
+        if ( *(fname-1) == '/' || *(fname-1) == '\\' || *(fname-1) == ':' )
+            break;
+
+    ofs_eat = sizeof( struct IMAGE_EXPORT_DIRECTORY );
+    ofs_names = ofs_eat + cnt * sizeof( uint_32 );
+    ofs_ord = ofs_names + cnt * sizeof( uint_32 );
+    ofs_dll = ofs_ord + cnt * sizeof( uint_16 );
+    ofs = ofs_dll + strlen( fname ) + 1;
+
+    /* get the size of the (decorated) export names */
+    pitems = (struct expitem *)myalloca( cnt * sizeof( struct expitem ) );
+    for( curr = SymTables[TAB_PROC].head, pexp = pitems; curr; curr = curr->nextproc ) {
+        if( curr->e.procinfo->isexport ) {
+            pexp->idx = ofs;
+            if ( Options.no_export_decoration )
+                ofs += curr->sym.name_size + 1;
+            else
+                ofs += Mangle( &curr->sym, StringBufferEnd ) + 1;
+            pexp++;
         }
-        qsort( pitems, cnt, sizeof( struct expitem ), compare_exp );
+    }
 
-        /* emit export address table.
-         * would be possible to just use the array of sorted names,
-         * but we want to emit the EAT being sorted by address.
-         */
-        AddLineQueueX( "@%s_func %r DWORD", name, T_LABEL );
-        for( curr = SymTables[TAB_PROC].head; curr; curr = curr->nextproc ) {
-            if( curr->e.procinfo->isexport )
-                AddLineQueueX( "DD %r %s", T_IMAGEREL, curr->sym.name );
+    buffer = pe_alloc_dirseg( edata, ofs );
+    expdir = (struct IMAGE_EXPORT_DIRECTORY *)buffer;
+    expdir->TimeDateStamp = (uint_32)time( NULL );
+    expdir->Base = 1;
+    expdir->NumberOfFunctions = cnt;
+    expdir->NumberOfNames = cnt;
+    pe_add_imgrel( edata, offsetof( struct IMAGE_EXPORT_DIRECTORY, Name ), &edata->sym, ofs_dll );
+    pe_add_imgrel( edata, offsetof( struct IMAGE_EXPORT_DIRECTORY, AddressOfFunctions ), &edata->sym, ofs_eat );
+    pe_add_imgrel( edata, offsetof( struct IMAGE_EXPORT_DIRECTORY, AddressOfNames ), &edata->sym, ofs_names );
+    pe_add_imgrel( edata, offsetof( struct IMAGE_EXPORT_DIRECTORY, AddressOfNameOrdinals ), &edata->sym, ofs_ord );
+    strcpy( (char *)buffer + ofs_dll, fname );
+
+    /* emit export address table ( sorted by address ) and the names */
+    for( curr = SymTables[TAB_PROC].head, pexp = pitems, i = 0; curr; curr = curr->nextproc ) {
+        if( curr->e.procinfo->isexport ) {
+            pe_add_imgrel( edata, ofs_eat + i * sizeof( uint_32 ), &curr->sym, 0 );
+            pexp->name = (char *)buffer + pexp->idx;
+            if ( Options.no_export_decoration )
+                memcpy( pexp->name, curr->sym.name, curr->sym.name_size );
+            else
+                Mangle( &curr->sym, pexp->name );
+            pexp->idx = i++;
+            pexp++;
         }
+    }
 
-        /* emit the name pointer table */
-        AddLineQueueX( "@%s_names %r DWORD", name, T_LABEL );
-        for ( i = 0; i < cnt; i++ )
-            AddLineQueueX( "DD %r @%s", T_IMAGEREL, (pitems+i)->name );
+    /* the name pointer table must be in ascending order of the names */
+    qsort( pitems, cnt, sizeof( struct expitem ), compare_exp );
 
-        /* ordinal table. each ordinal is an index into the export address table */
-        AddLineQueueX( "@%s_nameord %r WORD", name, T_LABEL );
-        for( i = 0; i < cnt; i++ ) {
-            AddLineQueueX( "DW %u", (pitems+i)->idx );
-        }
-        /* v2.10: name+ext of dll */
-        //AddLineQueueX( "@%s_name DB '%s',0", name, name );
-        for ( fname = CurrFName[OBJ] + strlen( CurrFName[OBJ] ); fname > CurrFName[OBJ]; fname-- )
-            if ( *fname == '/' || *fname == '\\' || *fname == ':' )
-                break;
-        AddLineQueueX( "@%s_name DB '%s',0", name, fname );
+    /* emit name pointer and ordinal table. Each ordinal is an index into the EAT */
+    for ( i = 0; i < cnt; i++ ) {
+        pe_add_imgrel( edata, ofs_names + i * sizeof( uint_32 ), &edata->sym, (uint_8 *)(pitems+i)->name - buffer );
+        *(uint_16 *)( buffer + ofs_ord + i * sizeof( uint_16 ) ) = (pitems+i)->idx;
+    }
+}
 
-        for( curr = SymTables[TAB_PROC].head; curr; curr = curr->nextproc ) {
-            if( curr->e.procinfo->isexport ) {
-                Mangle( &curr->sym, StringBufferEnd );
-                AddLineQueueX( "@%s DB '%s',0", curr->sym.name, Options.no_export_decoration ? curr->sym.name : StringBufferEnd );
-            }
+/* define the IAT entry label for an import */
+
+static void pe_set_iat_label( struct asym *imp, struct dsym *iat, uint_32 offset )
+/*******************************************************************************/
+{
+    struct asym *sym;
+    char *p;
+
+    p = StringBufferEnd;
+    strcpy( p, ModuleInfo.g.imp_prefix );
+    Mangle( imp, p + strlen( p ) );
+    sym = SymLookup( p );
+    if ( sym->state == SYM_INTERNAL && sym->segment == &iat->sym ) {
+        if ( sym->offset != offset )
+            ModuleInfo.PhaseError = TRUE;
+    } else {
+        if ( sym->state == SYM_EXTERNAL && sym->weak && sym->isproc == FALSE ) {
+            /* EXTERNDEF created by INVOKE */
+            sym_ext2int( sym );
+        } else if ( sym->state == SYM_UNDEFINED ) {
+            sym_remove_table( &SymTables[TAB_UNDEF], (struct dsym *)sym );
+            sym->state = SYM_INTERNAL;
+        } else {
+            EmitErr( SYMBOL_REDEFINITION, p );
+            return;
         }
-        /* exit .edata segment */
-        AddLineQueueX( "%s %r", edataname, T_ENDS );
-        RunLineQueue();
+        /* same as "<name> LABEL PTR PROC" */
+        sym->mem_type = MT_PTR;
+        sym->Ofssize = ModuleInfo.defOfssize;
+        sym->is_ptr = 1;
+        sym->isfar = FALSE;
+        sym->target_type = NULL;
+        ((struct dsym *)sym)->next = (struct dsym *)iat->e.seginfo->label_list;
+        iat->e.seginfo->label_list = sym;
     }
+    sym->isdefined = TRUE;
+    sym->asmpass = Parse_Pass;
+    sym->segment = &iat->sym;
+    sym->offset = offset;
+    BackPatch( sym );
+}
+
+/* the hint/name table entries are 2-byte aligned: a hint, the
+ * 0-terminated name and an optional pad byte.
+ * Identical names share one entry.
+ */
+
+#define IMP_HASH_SIZE 253
+
+struct impitem {
+    struct impitem *next;
+    const char *name;
+    uint_32 offset;
+};
+
+static uint_32 pe_add_hintname( struct impitem **table, struct impitem *item, const char *name, uint_32 *size )
+/************************************************************************************************************/
+{
+    struct impitem **bucket;
+    const char *p;
+    unsigned h;
+
+    for ( p = name, h = 0; *p; p++ )
+        h = h * 31 + (uint_8)*p;
+    for ( bucket = &table[h % IMP_HASH_SIZE]; *bucket; bucket = &(*bucket)->next )
+        if ( strcmp( (*bucket)->name, name ) == 0 )
+            return( (*bucket)->offset );
+    item->next = NULL;
+    item->name = name;
+    item->offset = *size;
+    *bucket = item;
+    *size += ( sizeof( uint_16 ) + ( p - name ) + 1 + 1 ) & ~1;
+    return( item->offset );
 }
 
 /* write import data.
@@ -976,96 +1122,97 @@ static void pe_emit_export_data( void )
  * .idata$3: final import directory NULL entry
  * .idata$4: ILT entry
  * .idata$5: IAT entry
- * .idata$6: strings
+ * .idata$6: strings ( hint/name table, dll names )
  */
 
 static void pe_emit_import_data( void )
 /*************************************/
 {
     struct dll_desc *p;
-    int type = 0;
-#if AMD64_SUPPORT
-    int ptrtype = ( ModuleInfo.defOfssize == USE64 ? T_QWORD : T_DWORD );
-    char *align = ( ModuleInfo.defOfssize == USE64 ? "ALIGN(8)" : "ALIGN(4)" );
-#else
-    int ptrtype = T_DWORD;
-    char *align = "DWORD";
-#endif
+    struct dsym *curr;
+    struct dsym *idir;
+    struct dsym *indir;
+    struct dsym *ilt;
+    struct dsym *iat;
+    struct dsym *istr;
+    struct impitem **table;
+    struct impitem *items;
+    struct impitem *item;
+    struct asym **imps;
+    uint_32 *hintname;
+    uint_32 *dllname;
+    uint_8 *strbuf;
+    uint_8 ptrsize = ( ModuleInfo.defOfssize == USE64 ? 8 : 4 );
+    unsigned ndlls = 0;
+    unsigned nimps = 0;
+    unsigned cnt;
+    unsigned i;
+    unsigned j;
+    uint_32 size;
+    uint_32 ofs;
 
     DebugMsg(("pe_emit_import_data enter\n" ));
-    for ( p = ModuleInfo.g.DllQueue; p; p = p->next ) {
-        if ( p->cnt ) {
-            struct dsym *curr;
-            char *pdot;
-            if ( !type ) {
-                type = 1;
-                AddLineQueueX( "@LPPROC %r %r %r", T_TYPEDEF, T_PTR, T_PROC );
-                AddLineQueueX( "%r DOTNAME", T_OPTION );
-            }
-
-            /* avoid . in IDs */
-            if ( pdot = strchr( p->name, '.') )
-                *pdot = '_';
-
-            /* import directory entry */
-            AddLineQueueX( "%s" IMPDIRSUF " %r %r %s", idataname, T_SEGMENT, T_DWORD, idataattr );
-            AddLineQueueX( "DD %r @%s_ilt, 0, 0, %r @%s_name, %r @%s_iat", T_IMAGEREL, p->name, T_IMAGEREL, p->name, T_IMAGEREL, p->name );
-            AddLineQueueX( "%s" IMPDIRSUF " %r", idataname, T_ENDS );
-
-            /* emit ILT */
-            AddLineQueueX( "%s" IMPILTSUF " %r %s %s", idataname, T_SEGMENT, align, idataattr );
-            AddLineQueueX( "@%s_ilt label %r", p->name, ptrtype );
-            for ( curr = SymTables[TAB_EXT].head; curr != NULL ; curr = curr->next ) {
-                if ( curr->sym.iat_used && curr->sym.dll == p ) {
-                    AddLineQueueX( "@LPPROC %r @%s_name", T_IMAGEREL, curr->sym.name );
-                }
-            }
-            /* ILT termination entry */
-            AddLineQueueX( "@LPPROC 0" );
-            AddLineQueueX( "%s" IMPILTSUF " %r", idataname, T_ENDS );
-
-            /* emit IAT */
-            AddLineQueueX( "%s" IMPIATSUF " %r %s %s", idataname, T_SEGMENT, align, idataattr );
-            AddLineQueueX( "@%s_iat label %r", p->name, ptrtype );
-
-            for ( curr = SymTables[TAB_EXT].head; curr != NULL ; curr = curr->next ) {
-                if ( curr->sym.iat_used && curr->sym.dll == p ) {
-                    Mangle( &curr->sym, StringBufferEnd );
-                    AddLineQueueX( "%s%s @LPPROC %r @%s_name", ModuleInfo.g.imp_prefix, StringBufferEnd, T_IMAGEREL, curr->sym.name );
-                }
-            }
-            /* IAT termination entry */
-            AddLineQueueX( "@LPPROC 0" );
-            AddLineQueueX( "%s" IMPIATSUF " %r", idataname, T_ENDS );
-
-            /* emit name table */
-            AddLineQueueX( "%s" IMPSTRSUF " %r %r %s", idataname, T_SEGMENT, T_WORD, idataattr );
-            for ( curr = SymTables[TAB_EXT].head; curr != NULL ; curr = curr->next ) {
-                if ( curr->sym.iat_used && curr->sym.dll == p ) {
-                    AddLineQueueX( "@%s_name dw 0", curr->sym.name );
-                    AddLineQueueX( "db '%s',0", curr->sym.name );
-                    AddLineQueue( "even" );
-                }
-            }
-            /* dll name table entry */
-            if ( pdot ) {
-                *pdot = NULLC;
-                AddLineQueueX( "@%s_%s_name db '%s.%s',0", p->name, pdot+1, p->name, pdot+1 );
-                *pdot = '.';  /* restore '.' in dll name */
-            } else
-                AddLineQueueX( "@%s_name db '%s',0", p->name, p->name );
+    for ( curr = SymTables[TAB_EXT].head; curr != NULL ; curr = curr->next )
+        if ( curr->sym.iat_used && curr->sym.dll )
+            nimps++;
+    if ( nimps == 0 )
+        return;
 
-            AddLineQueue( "even" );
-            AddLineQueueX( "%s" IMPSTRSUF " %r", idataname, T_ENDS );
+    if ( ( idir = pe_create_dirseg( idataname IMPDIRSUF, 2 ) ) == NULL ||
+        ( indir = pe_create_dirseg( idataname IMPNDIRSUF, 2 ) ) == NULL ||
+        ( ilt = pe_create_dirseg( idataname IMPILTSUF, ( ptrsize == 8 ? 3 : 2 ) ) ) == NULL ||
+        ( iat = pe_create_dirseg( idataname IMPIATSUF, ( ptrsize == 8 ? 3 : 2 ) ) ) == NULL ||
+        ( istr = pe_create_dirseg( idataname IMPSTRSUF, 1 ) ) == NULL )
+        return;
 
+    /* collect the imports, grouped by dll, and lay out the strings section */
+    table = myalloca( IMP_HASH_SIZE * sizeof( struct impitem * ) );
+    memset( table, 0, IMP_HASH_SIZE * sizeof( struct impitem * ) );
+    items = myalloca( nimps * sizeof( struct impitem ) );
+    imps = myalloca( nimps * sizeof( struct asym * ) );
+    hintname = myalloca( nimps * sizeof( uint_32 ) );
+    dllname = myalloca( nimps * sizeof( uint_32 ) );
+    for ( p = ModuleInfo.g.DllQueue, i = 0, size = 0; p; p = p->next ) {
+        for ( curr = SymTables[TAB_EXT].head, cnt = 0; curr != NULL ; curr = curr->next ) {
+            if ( curr->sym.iat_used && curr->sym.dll == p ) {
+                imps[i] = &curr->sym;
+                hintname[i] = pe_add_hintname( table, items + i, curr->sym.name, &size );
+                i++;
+                cnt++;
+            }
+        }
+        /* dll name follows the names of its imports */
+        if ( cnt ) {
+            dllname[ndlls++] = size;
+            size += ( strlen( p->name ) + 1 + 1 ) & ~1;
         }
     }
-    if ( is_linequeue_populated() ) {
-        /* import directory NULL entry */
-        AddLineQueueX( "%s" IMPNDIRSUF " %r %r %s", idataname, T_SEGMENT, T_DWORD, idataattr );
-        AddLineQueueX( "DD 0, 0, 0, 0, 0" );
-        AddLineQueueX( "%s" IMPNDIRSUF " %r", idataname, T_ENDS );
-        RunLineQueue();
+    strbuf = pe_alloc_dirseg( istr, size );
+    for ( j = 0; j < IMP_HASH_SIZE; j++ )
+        for ( item = table[j]; item; item = item->next )
+            strcpy( (char *)strbuf + item->offset + sizeof( uint_16 ), item->name );
+
+    pe_alloc_dirseg( idir, ndlls * sizeof( struct IMAGE_IMPORT_DESCRIPTOR ) );
+    pe_alloc_dirseg( indir, sizeof( struct IMAGE_IMPORT_DESCRIPTOR ) );
+    pe_alloc_dirseg( ilt, ( nimps + ndlls ) * ptrsize );
+    pe_alloc_dirseg( iat, ( nimps + ndlls ) * ptrsize );
+
+    for ( i = 0, j = 0, ofs = 0; i < nimps; j++ ) {
+        p = imps[i]->dll;
+        /* import directory entry */
+        pe_add_imgrel( idir, j * sizeof( struct IMAGE_IMPORT_DESCRIPTOR ) + offsetof( struct IMAGE_IMPORT_DESCRIPTOR, OriginalFirstThunk ), &ilt->sym, ofs );
+        pe_add_imgrel( idir, j * sizeof( struct IMAGE_IMPORT_DESCRIPTOR ) + offsetof( struct IMAGE_IMPORT_DESCRIPTOR, FirstThunk ), &iat->sym, ofs );
+        /* ILT and IAT entries, both point to the hint/name entry */
+        for ( ; i < nimps && imps[i]->dll == p; i++ ) {
+            pe_add_imgrel( ilt, ofs, &istr->sym, hintname[i] );
+            pe_add_imgrel( iat, ofs, &istr->sym, hintname[i] );
+            pe_set_iat_label( imps[i], iat, ofs );
+            ofs += ptrsize;
+        }
+        /* the termination entries of ILT and IAT are zero */
+        ofs += ptrsize;
+        strcpy( (char *)strbuf + dllname[j], p->name );
+        pe_add_imgrel( idir, j * sizeof( struct IMAGE_IMPORT_DESCRIPTOR ) + offsetof( struct IMAGE_IMPORT_DESCRIPTOR, Name ), &istr->sym, dllname[j] );
     }
 }
 
@@ -1479,6 +1626,38 @@ static void pe_set_values( struct calc_param *cp )
     //mzhdr->e.seginfo->group = NULL;
 }
 
+#if AMD64_SUPPORT
+
+static int compare_pdata( const void *p1, const void *p2 )
+/********************************************************/
+{
+    uint_32 addr1 = ((const IMAGE_RUNTIME_FUNCTION_ENTRY *)p1)->BeginAddress;
+    uint_32 addr2 = ((const IMAGE_RUNTIME_FUNCTION_ENTRY *)p2)->BeginAddress;
+    return( addr1 < addr2 ? -1 : addr1 > addr2 );
+}
+
+/* v2.52: sort the entries of the exception directory by address.
+ * called after the fixups have been resolved; the entries contain RVAs only.
+ */
+static void pe_sort_pdata( void )
+/*******************************/
+{
+    struct dsym *curr;
+    uint_32 size;
+
+    for( curr = SymTables[TAB_SEG].head; curr; curr = curr->next ) {
+        if ( memcmp( curr->sym.name, ".pdata", 6 ) ||
+            ( curr->sym.name[6] != NULLC && curr->sym.name[6] != '$' ) ||
+            curr->e.seginfo->CodeBuffer == NULL )
+            continue;
+        size = curr->sym.max_offset - curr->e.seginfo->start_loc;
+        DebugMsg(("pe_sort_pdata(%s): %" I32_SPEC "u entries\n", curr->sym.name, size / sizeof( IMAGE_RUNTIME_FUNCTION_ENTRY ) ));
+        qsort( curr->e.seginfo->CodeBuffer, size / sizeof( IMAGE_RUNTIME_FUNCTION_ENTRY ),
+              sizeof( IMAGE_RUNTIME_FUNCTION_ENTRY ), compare_pdata );
+    }
+}
+#endif
+
 /* v2.11: this function is called when the END directive has been found.
  * Previously the code was run inside EndDirective() directly.
  */
@@ -1606,6 +1785,12 @@ static ret_code bin_write_module( struct module_info *modinfo )
     if ( modinfo->g.error_count )
         return( ERROR );
 
+#if PE_SUPPORT && AMD64_SUPPORT
+    /* v2.52: with -order, the .pdata entries are no longer sorted by address */
+    if ( Options.names[OPTN_ORDER_FN] && modinfo->sub_format == SFORMAT_PE && modinfo->defOfssize == USE64 )
+        pe_sort_pdata();
+#endif
+
     /* for plain binaries make sure the start label is at
      * the beginning of the first segment */
     if ( modinfo->sub_format == SFORMAT_NONE ) {
@@ -1841,6 +2026,9 @@ static ret_code bin_check_external( struct module_info *modinfo )
 void bin_init( struct module_info *modinfo )
 /******************************************/
 {
+    /* v2.52: JIT mode of the library interface */
+    if ( jit_init( modinfo ) )
+        return;
     modinfo->g.WriteModule = bin_write_module;
     modinfo->g.Pass1Checks = bin_check_external;
     switch ( modinfo->sub_format ) {
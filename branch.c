@@ -216,10 +216,12 @@ ret_code process_branch( struct code_info *CodeInfo, unsigned CurrOpnd, const st
     if ( state == SYM_INTERNAL || state == SYM_EXTERNAL ) {
         /* v2.04: if the symbol is internal, but wasn't met yet
          * in this pass and its offset is < $, don't use current offset
+         * v2.52: unless the procs of the segment have been reordered ( -order )
          */
         if ( state == SYM_INTERNAL &&
             sym->asmpass != ( Parse_Pass & 0xFF) &&
-            sym->offset < addr )
+            sym->offset < addr &&
+            ( sym->segment == NULL || ((struct dsym *)sym->segment)->e.seginfo->reordered == FALSE ) )
             ;
         else
             addr = sym->offset; /* v2.02: init addr, so sym->offset isn't changed */
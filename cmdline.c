@@ -39,6 +39,8 @@
 #include "cmdline.h"
 #include "myassert.h"
 #include "input.h"
+#include "mca.h"
+#include "memfile.h"
 
 #if defined(__UNIX__) || defined(__CYGWIN__) || defined(__DJGPP__)
     #define HANDLECTRLZ 0
@@ -56,6 +58,11 @@
 
 extern char     banner_printed;
 
+/* v2.52: set by the library ( libuasm.c ) while it parses options;
+ * options which display or read something ( -h, -?, @file ) are invalid then.
+ */
+char library_mode = FALSE;
+
 struct global_options Options = {
     /* quiet            */          FALSE,
     /* line_numbers     */          FALSE,
@@ -83,7 +90,7 @@ struct global_options Options = {
     /* dump_symbols_hash */         FALSE,
 #endif
     /* names            */          {
-        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 #if BUILD_TARGET
         NULL,
 #endif
@@ -144,6 +151,9 @@ struct global_options Options = {
 	/* hlcall                */     TRUE,
 	/* pie                   */     FALSE,
     /* frame preserves flags */     FALSE,
+    /* stats                 */     FALSE,
+    /* lazy_include          */     FALSE,
+    /* fold_procs            */     FALSE,
 
 #if MANGLERSUPP
     /* naming_convention*/          NC_DO_NOTHING,
@@ -310,7 +320,7 @@ static void get_fname( int type, const char *token )
     /* v2.10: ensure type is < NUM_FILE_TYPES */
     //if ( drive[0] == NULLC && dir[0] == NULLC && type < NUM_FILE_TYPES && DefaultDir[type] ) {
     name[0] = NULLC;
-    if ( pName == token && type < NUM_FILE_TYPES && DefaultDir[type] ) {
+    if ( pName == token && type < NUM_FILE_TYPES && DefaultDir[type] && !IS_STDIO_NAME( token ) ) {
         DebugMsg(("get_fname: default drive+dir used: %s\n" ));
         //_splitpath( DefaultDir[type], drive, dir, NULL, NULL );
         strcpy( name, DefaultDir[type] );
@@ -467,6 +477,7 @@ static void OPTQUAL Set_Fw( void ) { get_fname( OPTN_ERR_FN, GetAFileName() ); }
 static void OPTQUAL Set_Fs( void ) { get_fname( OPTN_SYM_FN, GetAFileName() ); Options.dumpSymbols = TRUE; }
 static void OPTQUAL Set_Fl( void ) { get_fname( OPTN_LST_FN, GetAFileName() ); Options.write_listing = TRUE;}
 static void OPTQUAL Set_Fo( void ) { get_fname( OPTN_OBJ_FN, GetAFileName() ); }
+static void OPTQUAL Set_order( void ) { get_fname( OPTN_ORDER_FN, GetAFileName() ); }
 
 static void OPTQUAL Set_fp( void ) { Options.cpu &= ~P_FPU_MASK; Options.cpu = OptValue; }
 static void OPTQUAL Set_FPx( void ) { Options.floating_point = OptValue; }
@@ -480,6 +491,17 @@ static void OPTQUAL Set_Sa( void )
     Options.list_macro = LM_LISTMACROALL;
 }
 
+/* v2.52: -Sc[=cpu] static throughput/latency analysis in listing */
+static void OPTQUAL Set_Sc( void )
+/********************************/
+{
+    Options.mca_cpu = McaSetModel( OptName );
+    if ( Options.mca_cpu == 0 ) {
+        EmitWarn( 1, INVALID_CMDLINE_VALUE, "Sc" );
+        Options.mca_cpu = 1; /* the warning says the default is used */
+    }
+}
+
 static void OPTQUAL Set_True( void )
 /**********************************/
 {
@@ -534,7 +556,16 @@ static void OPTQUAL Set_zf( void )  { Options.fctype = OptValue; }
 
 static void OPTQUAL Set_zt( void ) { Options.stdcall_decoration = OptValue; }
 #ifndef __SW_BD
-static void OPTQUAL Set_h( void ) {  PrintUsage();  exit(EXIT_SUCCESS); }
+static void OPTQUAL Set_h( void )
+{
+    /* v2.52: the library must not terminate the host process */
+    if ( library_mode ) {
+        EmitWarn( 1, INVALID_CMDLINE_OPTION, "h" );
+        return;
+    }
+    PrintUsage();
+    exit(EXIT_SUCCESS);
+}
 #endif
 
 static void OPTQUAL Set_zv(void) { Options.vectorcall_decoration = OptValue; }
@@ -605,6 +636,9 @@ static struct cmdloption const cmdl_options[] = {
 	{ "archAVX",0,        Set_AVX },
 	{ "nomlib", 0,        Set_NOMLIB },
 	{ "less",   0,        Set_LessOutput },
+    { "lazyinc",optofs( lazy_include ), Set_True },
+    { "icf",    optofs( fold_procs ), Set_True },
+    { "hllopt", optofs( hll_optimize ), Set_True },
 #ifdef DEBUG_OUT
     { "ce",     0,        Set_ce },
 #endif
@@ -689,6 +723,7 @@ static struct cmdloption const cmdl_options[] = {
     { "nologo", 0,                  Set_nologo },
     { "nt=$",   OPTN_TEXT_SEG,      Set_n },
     { "omf",    OFORMAT_OMF | (SFORMAT_NONE << 8), Set_ofmt },
+    { "order=^@", 0,                Set_order },
 #if COCTALS
     { "o",      optofs( allow_c_octals ),   Set_True },
 #endif
@@ -700,10 +735,12 @@ static struct cmdloption const cmdl_options[] = {
 #endif
     { "q",      0,        Set_q },
     { "Sa",     0,        Set_Sa },
+    { "Sc=$",   0,        Set_Sc },
     { "Sf",     optofs( first_pass_listing  ), Set_True },
     { "Sg",     optofs( list_generated_code ), Set_True },
     { "Sn",     optofs( no_symbol_listing   ), Set_True },
     { "Sx",     optofs( listif              ), Set_True },
+    { "stats",  optofs( stats               ), Set_True },
 #if COFF_SUPPORT
     { "safeseh",optofs( safeseh ),        Set_True },
 #endif
@@ -1074,6 +1111,14 @@ char * EXPQUAL ParseCmdline( const char **cmdline, int *pCntArgs )
             str = getnextcmdstring( cmdline );
             break;
         case '-':
+            /* v2.52: a single '-' is the source file name for stdin */
+            if ( *(str+1) == NULLC || *(str+1) == ' ' || *(str+1) == '\t' ) {
+                get_fname( OPTN_ASM_FN, "-" );
+                DebugMsg(("ParseCmdLine: file=>-< (stdin)\n" ));
+                (*pCntArgs)++;
+                *cmdline = str + 1;
+                return( Options.names[ASM] );
+            }
 #if SWITCHCHAR
         case '/':
 #endif
@@ -1084,6 +1129,12 @@ char * EXPQUAL ParseCmdline( const char **cmdline, int *pCntArgs )
             str = *cmdline;
             break;
         case '@':
+            /* v2.52: no response files or environment variables in library mode */
+            if ( library_mode ) {
+                EmitWarn( 1, INVALID_CMDLINE_OPTION, str );
+                *cmdline = "";
+                return( NULL );
+            }
             if ( rspidx >= MAX_RSP_NESTING ) {
                 EmitErr( NESTING_LEVEL_TOO_DEEP );
                 *cmdline = "";
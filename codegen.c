@@ -2436,7 +2436,7 @@ static void output_opc(struct code_info *CodeInfo)
           else if ((CodeInfo->opnd[OPND2].type & OP_M_ANY) &&
                    (CodeInfo->opnd[OPND1].data32l != -1))
                    index = OPND2;
-          if ((index != -1) && ((Check4CompDisp8(CodeInfo, &comprdsp, &d, CodeInfo->opnd[index].data32l)) && comprdsp)){
+          if ((index != -1) && !CodeInfo->relax_full && ((Check4CompDisp8(CodeInfo, &comprdsp, &d, CodeInfo->opnd[index].data32l)) && comprdsp)){
             CodeInfo->opnd[index].data32l = comprdsp;
             tmp &= ~MOD_10;     /* if        mod = 10, r/m = 100, s-i-b is present */
             tmp |= MOD_01;      /* change to mod = 01, r/m = 100, s-i-b is present */
@@ -2797,6 +2797,15 @@ static void output_data(const struct code_info *CodeInfo, enum operand_type dete
                 size = 4;
             }
         }
+        /* v2.52: track size of displacement ( see set_rm_sib() ). An EVEX
+         * disp8*N is written as 1 byte below, while the mod field of
+         * rm_byte still tells a full-size displacement.
+         */
+        if ( CodeInfo->relax_var )
+            DispSized( CodeInfo, ( size && CodeInfo->tuple && CodeInfo->opnd[OPND2].type != OP_I8 &&
+                                  CodeInfo->opnd[index].InsFixup == NULL ) ? 1 : size,
+                      ( ( CodeInfo->Ofssize == USE16 && CodeInfo->prefix.adrsiz == 0 ) ||
+                       ( CodeInfo->Ofssize == USE32 && CodeInfo->prefix.adrsiz == 1 ) ) ? 2 : 4 );
     }
 #ifdef DEBUG_OUT
     if ( size > 4 )
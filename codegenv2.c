@@ -1363,7 +1363,8 @@ int BuildMemoryEncoding(unsigned char* pmodRM, unsigned char* pSIB, unsigned cha
 	           Specified address format can only be encoded with a displacement. */
 	if (instr->memOpnd > NO_MEM || opExpr[instr->memOpnd].value != 0 ||
 		(ModuleInfo.Ofssize == USE64 && opExpr[instr->memOpnd].base_reg && opExpr[instr->memOpnd].base_reg->token == T_RIP) ||
-		MemTable[memModeIdx].flags & MEMF_DSP || MemTable[memModeIdx].flags & MEMF_DSP32 || (opExpr[instr->memOpnd].sym && opExpr[instr->memOpnd].sym->state != SYM_STACK))
+		MemTable[memModeIdx].flags & MEMF_DSP || MemTable[memModeIdx].flags & MEMF_DSP32 || (opExpr[instr->memOpnd].sym && opExpr[instr->memOpnd].sym->state != SYM_STACK) ||
+		CodeInfo->relax_full)
 	{
 		if (instr->memOpnd > NO_MEM)
 		{
@@ -1383,8 +1384,11 @@ int BuildMemoryEncoding(unsigned char* pmodRM, unsigned char* pSIB, unsigned cha
 		else
 		{
 			/* Is it 8bit or 16/32bit (RIP only allows 32bit). */
-			if (CompDisp(&opExpr[(instr->memOpnd & 7)], instr, CodeInfo) &&
-				(((!opExpr[instr->memOpnd].sym) || (opExpr[instr->memOpnd].sym && opExpr[instr->memOpnd].sym->state == SYM_STACK)) &&
+			/* v2.52: a forward reference is assumed to fit in 8bit in pass 1,
+			   once it has grown it stays 16/32bit. */
+			if (!CodeInfo->relax_full && CompDisp(&opExpr[(instr->memOpnd & 7)], instr, CodeInfo) &&
+				(((!opExpr[instr->memOpnd].sym) || (opExpr[instr->memOpnd].sym && opExpr[instr->memOpnd].sym->state == SYM_STACK) ||
+				(CodeInfo->relax_disp && Parse_Pass == PASS_1)) &&
 				(((MemTable[memModeIdx].flags & MEMF_DSP32) == 0) && (opExpr[instr->memOpnd].value >= -128 && opExpr[instr->memOpnd].value <= 127))))
 			{
 				*dispSize = 1;
@@ -1403,6 +1407,8 @@ int BuildMemoryEncoding(unsigned char* pmodRM, unsigned char* pSIB, unsigned cha
 		}
 		*pDisp = opExpr[(instr->memOpnd & 7)].value64;
 	}
+	if (CodeInfo->relax_var)
+		DispSized(CodeInfo, *dispSize, baseRegSize == 2 ? 2 : 4);
 
 	/* Extend V/REX(.B) and V/REX(.X) to account for 64bit base and index registers.
 	   We use RegNo==16 to represent RIP (even though it's not directly encodable). */
@@ -88,8 +88,242 @@ extern const char szNull[];
 extern UINT_PTR UTF8toWideChar(const unsigned char *pSource, UINT_PTR nSourceLen, UINT_PTR *nSourceDone, unsigned short *szTarget, UINT_PTR nTargetMax);
 static ret_code data_item( int *, struct asm_tok[], struct asym *, uint_32, const struct asym *, uint_32, bool inside_struct, bool, bool, int );
 
-#define OutputDataBytes( x, y ) OutputBytes( x, y, NULL )
-#define OutputInterleavedDataBytes( x, y ) OutputInterleavedBytes( x, y, NULL );
+#define OutputDataBytes( x, y ) DataBytes( x, y )
+
+/* v2.52: default initializer images.
+ * A field's default initializer was tokenized and evaluated by data_item()
+ * for each STRUCT/UNION instance which doesn't override it. If it contains
+ * numbers, strings and operators only, the result can't change; then the
+ * output of its first evaluation is recorded and just replayed later.
+ * For OMF, the output calls are replayed unchanged, since they determine
+ * where LEDATA records are split; else adjacent items are merged.
+ */
+enum dflt_kind {
+    DFLT_BYTES, /* OutputBytes() */
+    DFLT_FILL,  /* FillDataBytes() */
+    DFLT_SKIP   /* SetCurrOffset() */
+};
+
+struct dflt_item {
+    uint_8  kind;
+    uint_8  fill;       /* DFLT_FILL: value */
+    uint_32 len;
+    uint_32 ofs;        /* DFLT_BYTES: start in data */
+};
+
+struct dflt_init {
+    uint_8           radix; /* radix when the image was recorded */
+    uint_32          cnt;   /* items in item[] */
+    uint_8           *data;
+    uint_64          value; /* RECORD field: the value */
+    struct dflt_item item[1];
+};
+
+/* marks fields whose initializer can't be cached */
+static struct dflt_init dflt_none;
+
+static struct {
+    bool             active;
+    uint_32          cnt;
+    uint_32          max;
+    uint_32          size;
+    uint_32          maxsize;
+    struct dflt_item *item;
+    uint_8           *data;
+} rec;
+
+static void *RecGrow( void *p, uint_32 used, uint_32 size )
+/*********************************************************/
+{
+    void *new = MemAlloc( size );
+    if ( p ) {
+        memcpy( new, p, used );
+        MemFree( p );
+    }
+    return( new );
+}
+
+static struct dflt_item *RecItem( enum dflt_kind kind, uint_32 len )
+/******************************************************************/
+{
+    struct dflt_item *item;
+
+    if ( rec.cnt ) {
+        item = &rec.item[rec.cnt-1];
+        if ( Options.output_format != OFORMAT_OMF && item->kind == kind && kind != DFLT_FILL ) {
+            item->len += len;
+            return( item );
+        }
+    }
+    if ( rec.cnt == rec.max ) {
+        rec.max = ( rec.max ? rec.max * 2 : 16 );
+        rec.item = RecGrow( rec.item, rec.cnt * sizeof( struct dflt_item ), rec.max * sizeof( struct dflt_item ) );
+    }
+    item = &rec.item[rec.cnt++];
+    item->kind = kind;
+    item->len = len;
+    item->ofs = rec.size;
+    return( item );
+}
+
+static void RecBytes( const uint_8 *pbytes, uint_32 len )
+/*******************************************************/
+{
+    if ( rec.size + len > rec.maxsize ) {
+        rec.maxsize = ( rec.size + len ) * 2;
+        rec.data = RecGrow( rec.data, rec.size, rec.maxsize );
+    }
+    memcpy( rec.data + rec.size, pbytes, len );
+    RecItem( DFLT_BYTES, len );
+    rec.size += len;
+}
+
+static void DataBytes( const uint_8 *pbytes, int len )
+/****************************************************/
+{
+    if ( rec.active )
+        RecBytes( pbytes, len );
+    OutputBytes( pbytes, len, NULL );
+}
+
+static void DataFill( uint_8 byte, int len )
+/******************************************/
+{
+    if ( rec.active ) {
+        if ( Options.output_format != OFORMAT_OMF ) {
+            uint_8 *p = myalloca( len );
+            memset( p, byte, len );
+            RecBytes( p, len );
+        } else
+            RecItem( DFLT_FILL, len )->fill = byte;
+    }
+    FillDataBytes( byte, len );
+}
+
+static void DataSkip( uint_32 len )
+/*********************************/
+{
+    if ( rec.active )
+        RecItem( DFLT_SKIP, len );
+    SetCurrOffset( CurrSeg, len, TRUE, TRUE );
+}
+
+/* is the image of a default initializer usable?
+ * initialized data in BSS and AT segments must be reported.
+ */
+static bool DefaultUsable( const struct dflt_init *di )
+/*****************************************************/
+{
+    return( di && di != &dflt_none && di->radix == ModuleInfo.radix &&
+           CurrSeg->e.seginfo->segtype != SEGTYPE_BSS &&
+           CurrSeg->e.seginfo->segtype != SEGTYPE_ABS );
+}
+
+/* start recording if the default initializer's tokens have a constant result */
+
+static bool DefaultRecord( struct sfield *f, struct asm_tok tokenarray[], int i )
+/******************************************************************************/
+{
+    if ( f->dflt == &dflt_none || rec.active )
+        return( FALSE );
+    for ( ; tokenarray[i].token != T_FINAL; i++ ) {
+        switch ( tokenarray[i].token ) {
+        case T_NUM:
+        case T_FLOAT:
+        case T_BINARY_OPERATOR:
+        case T_OP_BRACKET:
+        case T_CL_BRACKET:
+        case T_COMMA:
+        case T_QUESTION_MARK:
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+            continue;
+        case T_STRING:
+            if ( tokenarray[i].string_delim == '"' || tokenarray[i].string_delim == '\'' )
+                continue;
+            break;
+        case T_RES_ID:
+            if ( tokenarray[i].tokval == T_DUP )
+                continue;
+            break;
+        }
+        f->dflt = &dflt_none;
+        return( FALSE );
+    }
+    rec.active = TRUE;
+    rec.cnt = 0;
+    rec.size = 0;
+    return( TRUE );
+}
+
+/* stop recording; the image is kept if the initializer was accepted silently */
+
+static void DefaultStore( struct sfield *f, bool ok, uint_64 value )
+/******************************************************************/
+{
+    struct dflt_init *di;
+
+    rec.active = FALSE;
+    if ( ok ) {
+        di = LclAlloc( sizeof( struct dflt_init ) + rec.cnt * sizeof( struct dflt_item ) + rec.size );
+        di->radix = ModuleInfo.radix;
+        di->cnt = rec.cnt;
+        di->value = value;
+        di->data = (uint_8 *)&di->item[rec.cnt];
+        memcpy( di->item, rec.item, rec.cnt * sizeof( struct dflt_item ) );
+        memcpy( di->data, rec.data, rec.size );
+        f->dflt = di;
+        DebugMsg1(("DefaultStore(%s): %" I32_SPEC "u items, %" I32_SPEC "u bytes\n", f->sym.name, rec.cnt, rec.size ));
+    }
+    /* the buffers are needed until the next record only */
+    MemFree( rec.item );
+    MemFree( rec.data );
+    rec.item = NULL;
+    rec.data = NULL;
+    rec.max = 0;
+    rec.maxsize = 0;
+}
+
+static void DefaultReplay( const struct dflt_init *di )
+/*****************************************************/
+{
+    const struct dflt_item *item;
+
+    for ( item = di->item; item < di->item + di->cnt; item++ ) {
+        switch ( item->kind ) {
+        case DFLT_BYTES: OutputBytes( di->data + item->ofs, item->len, NULL ); break;
+        case DFLT_FILL:  FillDataBytes( item->fill, item->len ); break;
+        default:         SetCurrOffset( CurrSeg, item->len, TRUE, TRUE );
+        }
+    }
+}
+
+/* emit the default initializer of a field */
+
+static ret_code DefaultInit( struct sfield *f, struct asm_tok tokenarray[], uint_32 no_of_bytes )
+/***********************************************************************************************/
+{
+    int tc = Token_Count;
+    int j = Token_Count + 1;
+    unsigned errors = ModuleInfo.g.error_count;
+    unsigned warnings = ModuleInfo.g.warning_count;
+    bool record;
+    ret_code rc;
+
+    if ( DefaultUsable( f->dflt ) ) {
+        DefaultReplay( f->dflt );
+        return( NOT_ERROR );
+    }
+    Token_Count = Tokenize( f->ivalue, j, tokenarray, TOK_RESCAN );
+    record = DefaultRecord( f, tokenarray, j );
+    rc = data_item( &j, tokenarray, NULL, no_of_bytes, f->sym.type, 1, FALSE, f->sym.mem_type & MT_FLOAT, FALSE, Token_Count );
+    if ( record )
+        DefaultStore( f, rc == NOT_ERROR && errors == ModuleInfo.g.error_count && warnings == ModuleInfo.g.warning_count, 0 );
+    Token_Count = tc;
+    return( rc );
+}
 
 /* This function shifts left 128 for the RECORD */
  void ShiftLeft (uint_64 *dstHi, uint_64 *dstLo,uint_64 num, int pos)
@@ -307,10 +541,21 @@ static ret_code InitStructuredVar( int index, struct asm_tok tokenarray[], const
         /* is it a RECORD field? */
         if ( f->sym.mem_type == MT_BITS ) {
             if ( tokenarray[i].token == T_COMMA || tokenarray[i].token == T_FINAL ) {
-                if ( f->ivalue[0] ) {
+                if ( f->ivalue[0] && DefaultUsable( f->dflt ) ) {
+                    /* v2.52: value of default initializer has been saved */
+                    opndx.llvalue = f->dflt->value;
+                    opndx.kind = EXPR_CONST;
+                    opndx.quoted_string = NULL;
+                    is_record_set = TRUE;
+                } else if ( f->ivalue[0] ) {
                     int j = Token_Count + 1;
                     int max_item = Tokenize( f->ivalue, j, tokenarray, TOK_RESCAN );
+                    unsigned errors = ModuleInfo.g.error_count;
+                    bool record = DefaultRecord( f, tokenarray, j );
                     EvalOperand( &j, tokenarray, max_item, &opndx, 0 );
+                    if ( record )
+                        DefaultStore( f, errors == ModuleInfo.g.error_count && opndx.kind == EXPR_CONST &&
+                                     opndx.quoted_string == NULL && j == max_item, opndx.llvalue );
                     is_record_set = TRUE;
                 } else {
                     opndx.value = 0;
@@ -369,11 +614,7 @@ static ret_code InitStructuredVar( int index, struct asm_tok tokenarray[], const
             //for ( sym = f->sym->type; sym && sym->type; sym = sym->type );
 
             if ( tokenarray[i].token == T_FINAL || tokenarray[i].token == T_COMMA ) {
-                int tc = Token_Count;
-                int j = Token_Count+1;
-                Token_Count = Tokenize( f->ivalue, j, tokenarray, TOK_RESCAN );
-                data_item( &j, tokenarray, NULL, no_of_bytes, f->sym.type, 1, FALSE, f->sym.mem_type & MT_FLOAT, FALSE, Token_Count );
-                Token_Count = tc;
+                DefaultInit( f, tokenarray, no_of_bytes );
             } else {
                 char c;
                 int j = i;
@@ -552,12 +793,12 @@ static ret_code data_item( int *start_pos, struct asm_tok tokenarray[], struct a
     bool                initwarn = FALSE;
     bool                half = FALSE;
     //unsigned int        count;
-    uint_8              *pchar,*p;
+    uint_8              *pchar;
     char                tmp;
     enum fixup_types    fixup_type;
     struct fixup        *fixup;
     struct expr         opndx;
-    uint_16 buff[256];
+    uint_16 buff[MAX_STRING_LEN];
     DebugMsg1(("data_item( idx=%u [%s], label=%s, no_of_bytes=%" I32_SPEC "u, type=%s, dup=%" I32_SPEC "Xh, inside_struct=%u, is_float=%u ) enter\n",
                *start_pos, tokenarray[*start_pos].tokpos, sym ? sym->name : "NULL",
                no_of_bytes, type_sym ? type_sym->name : "NULL",
@@ -718,7 +959,7 @@ next_item:  /* <--- continue scan if a comma has been detected */
             total++;
         }
         if( !inside_struct ) {
-            SetCurrOffset( CurrSeg, opndx.uvalue, TRUE, TRUE );
+            DataSkip( opndx.uvalue );
         }
         i++;
         goto item_done;
@@ -800,17 +1041,12 @@ next_item:  /* <--- continue scan if a comma has been detected */
                 if (string_len > no_of_bytes && sym && sym->mem_type != MT_WORD)
 						return(EmitError(INITIALIZER_OUT_OF_RANGE));
                 /* if characters are not single byte, 2 bytes are used for 1 size v2.38 */
-                 p = pchar;
-                 half = FALSE; 
-                  for (j = 0; j < string_len; j++,p++){
-                    if ((unsigned char)*p > 0x7F){
-                       half = TRUE; 
-                       break;
-                      }
-                  }
+                /* v2.52: the string is converted in any case; since multi-byte
+                 * characters shrink, a length change tells if there were some.
+                 */
+                 j = UTF8toWideChar(pchar, string_len, NULL,(unsigned short *) &buff, string_len);
+                 half = ( j != string_len );
                  if (half){
-                   memset( &buff, 0, string_len * 2 );
-                  j = UTF8toWideChar(pchar, string_len, NULL,(unsigned short *) &buff, string_len);
                     opndx.quoted_string->stringlen = j;
                     string_len = j;
                     sym->mem_type = MT_BYTE;      /* each byte must be stored without zeros between */
@@ -853,13 +1089,14 @@ next_item:  /* <--- continue scan if a comma has been detected */
 						pchar = little_endian( (const char *)pchar, string_len );
 					OutputDataBytes( pchar, string_len );
 					if ( no_of_bytes > string_len )
-						FillDataBytes(0, no_of_bytes - string_len);
+						DataFill(0, no_of_bytes - string_len);
 				}
 				else
 				{
 					if (string_len > 1 && no_of_bytes > 1 && sym && sym->mem_type == MT_WORD)
 					{
-						OutputInterleavedDataBytes(pchar, string_len);
+						/* v2.52: the converted string is written in one go */
+						OutputDataBytes((uint_8*)&buff, string_len * 2);
 					}
 					else
 					{
@@ -876,7 +1113,7 @@ next_item:  /* <--- continue scan if a comma has been detected */
                         }
 					}
 					if (no_of_bytes > string_len)
-						FillDataBytes(0, no_of_bytes - string_len);
+						DataFill(0, no_of_bytes - string_len);
 				}
 
 				
@@ -892,7 +1129,7 @@ next_item:  /* <--- continue scan if a comma has been detected */
                 if ( no_of_bytes > 16 ) {
                     OutputDataBytes( opndx.chararray, 16 );
                     tmp = ( opndx.chararray[15] < 0x80 ? 0 : 0xFF );
-                    FillDataBytes( tmp, no_of_bytes - 16 );
+                    DataFill( tmp, no_of_bytes - 16 );
                 } else {
                     /* v2.06: TBYTE/OWORD/XMMWORD: extend a negative value to 16-byte */
                     if ( no_of_bytes > sizeof( int_64 ) ) {
@@ -362,6 +362,9 @@ struct asym *CreateConstant( struct asm_tok tokenarray[] )
     ret_code            rc;
     char                *p;
     bool                cmpvalue = FALSE;
+#if FASTPASS
+    bool                invariant = TRUE;
+#endif
     struct expr         opnd;
     char                argbuffer[MAX_LINE_LEN];
 
@@ -464,6 +467,9 @@ struct asym *CreateConstant( struct asm_tok tokenarray[] )
             DebugMsg1(("CreateConstant(%s): after ExpandLineItems: >%s<\n", name, p ));
         }
         rc = EvalOperand( &i, tokenarray, Token_Count, &opnd, EXPF_NOERRMSG | EXPF_NOUNDEF );
+#if FASTPASS
+        invariant = ExprIsInvariant();
+#endif
 
         /* v2.08: if it's a quoted string, handle it like a plain number */
         /* v2.10: quoted_string field is != 0 if kind == EXPR_FLOAT,
@@ -529,6 +535,9 @@ struct asym *CreateConstant( struct asm_tok tokenarray[] )
         //    }
         //}
         sym->variable = FALSE;
+#if FASTPASS
+        sym->invariant = ( opnd.kind == EXPR_CONST && invariant );
+#endif
         SetValue( sym, &opnd );
         DebugMsg1(("CreateConstant(%s): memtype=%Xh value=%" I64_SPEC "X isproc=%u variable=%u type=%s\n",
             name, sym->mem_type, (uint_64)sym->value + ( (uint_64)sym->value3264 << 32), sym->isproc, sym->variable, sym->type ? sym->type->name : "NULL" ));
@@ -41,6 +41,7 @@
 #include "msgtext.h"
 #include "listing.h"
 #include "segment.h"
+#include "memfile.h"
 
 #include <stdio.h>
 
@@ -51,6 +52,7 @@
 
 extern void             print_source_nesting_structure( void );
 extern jmp_buf          jmpenv;
+extern char             library_mode;
 
 //static bool             Errfile_Written;
 //static void             PrtMsg( int severity, int msgnum, va_list args1, va_list args2 );
@@ -264,23 +266,30 @@ static void PutMsg( FILE *fp, int severity, int msgnum, va_list args )
 			fwrite("\n", 1, 1, fp);
 			SetConsoleTextAttribute(hConsole, screenBufferInfo.wAttributes);
 		#else	
-			if (severity <= 2)
-				printf(KRED);
-			else
-				printf(KYEL);
-			fflush(NULL);
+			/* v2.52: colors for console output only */
+			if (fp == errout) {
+				if (severity <= 2)
+					printf(KRED);
+				else
+					printf(KYEL);
+				fflush(NULL);
+			}
 			fwrite(buffer, 1, i, fp);
 			fwrite("\n", 1, 1, fp);
-			printf(RST);
-			fflush(NULL);
+			if (fp == errout) {
+				printf(RST);
+				fflush(NULL);
+			}
 		#endif
 
 
-        /* if in Pass 1, add the error msg to the listing */
+        /* if in Pass 1, add the error msg to the listing
+         * v2.52: also if there's no error file ( source read from stdin )
+         */
         if ( CurrFile[LST] &&
              severity &&
              Parse_Pass == PASS_1 &&
-             fp == CurrFile[ERR] ) {
+             ( fp == CurrFile[ERR] || ( CurrFile[ERR] == NULL && fp == errout ) ) ) {
             LstWrite( LSTTYPE_DIRECTIVE, GetCurrOffset(), 0 );
             /* size of "blank" prefix to be explained! */
             LstPrintf( "                           %s", buffer );
@@ -297,7 +306,11 @@ static void PrtMsg( int severity, int msgnum, va_list args1, va_list args2 )
 #endif
     /* open .err file if not already open and a name is given */
     if( CurrFile[ERR] == NULL && CurrFName[ERR] != NULL ) {
-        CurrFile[ERR] = fopen( CurrFName[ERR], "w" );
+        /* v2.52: "-" is a memory file, copied to stdout when closed */
+        if ( IS_STDIO_NAME( CurrFName[ERR] ) )
+            CurrFile[ERR] = MemFileOpen( NULL );
+        else
+            CurrFile[ERR] = fopen( CurrFName[ERR], "w" );
         if( CurrFile[ERR] == NULL ) {
             /* v2.06: no fatal error anymore if error file cannot be written */
             char *p = CurrFName[ERR];
@@ -416,8 +429,9 @@ void Fatal( int msgnum, ... )
     /* setjmp() has been called in AssembleModule().
      * if a fatal error happens outside of this function, longjmp()
      * is NOT to be used ( out of memory condition, @cmd file open error, ... )
+     * v2.52: except in library mode, where UasmCreate() has called setjmp().
      */
-    if ( CurrFName[ASM] )
+    if ( CurrFName[ASM] || library_mode )
         longjmp( jmpenv, 2 );
 
     exit(1);
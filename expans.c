@@ -28,6 +28,7 @@
 #include "macro.h"
 #include "condasm.h"
 #include "listing.h"
+#include "fastpass.h"
 #include "myassert.h"
 
 /* TEVALUE_UNSIGNED
@@ -794,9 +795,7 @@ int RunMacro( struct dsym *macro, int idx, struct asm_tok tokenarray[], char *ou
                     break;
                 }
             }
-            ParseLine( tokenarray );
-            if ( Options.preprocessor_stdout == TRUE )
-                WritePreprocessedLine( CurrSource );
+            ParsePreprocessedLine( CurrSource, tokenarray );
 
             /* the macro might contain an END directive.
              * v2.08: this doesn't mean the macro is to be cancelled.
@@ -1142,6 +1141,23 @@ static ret_code RebuildLine( const char *newstring, int i, struct asm_tok tokena
  * *pi: index of token in tokenarray
  * equmode: if 1, dont expand macro functions
  */
+#if FASTPASS
+/* v2.52: is a line not stored as it is expanded? This is true for
+ * preprocessor directives ( conditional assembly, loops ) and text
+ * equates; lines of macros are checked by the caller.
+ */
+static bool IsUnstoredLine( const struct asm_tok tokenarray[] )
+/*************************************************************/
+{
+    int i = ( Token_Count > 2 && ( tokenarray[1].token == T_COLON || tokenarray[1].token == T_DBL_COLON ) ) ? 2 : 0;
+
+    if ( tokenarray[i].token == T_DIRECTIVE )
+        return( tokenarray[i].dirtype <= DRT_INCLUDE );
+    return( Token_Count > 1 && tokenarray[1].token == T_DIRECTIVE &&
+           ( tokenarray[1].dirtype == DRT_CATSTR || tokenarray[1].dirtype == DRT_SUBSTR ) );
+}
+#endif
+
 static ret_code ExpandToken( char *line, int *pi, struct asm_tok tokenarray[], int max, int bracket_flags, int equmode )
 /**********************************************************************************************************************/
 {
@@ -1183,6 +1199,14 @@ static ret_code ExpandToken( char *line, int *pi, struct asm_tok tokenarray[], i
 			else
 				sym = SymSearch( tokenarray[i].string_ptr );
             DebugMsg1(("ExpandToken: testing id >%s< equmode=%u\n", tokenarray[i].string_ptr, equmode ));
+#if FASTPASS
+            /* v2.52: if the name becomes a text macro later, further
+             * passes must be full passes, see TextMacroFwdRef().
+             */
+            if ( ( sym == NULL || sym->state == SYM_UNDEFINED ) && Parse_Pass == PASS_1 &&
+                ( MacroLevel || IsUnstoredLine( tokenarray ) ) )
+                UnstoredName( tokenarray[i].string_ptr );
+#endif
             /* don't check isdefined flag (which cannot occur in pass one, and this code usually runs
              * in pass one only!
              */
@@ -46,6 +46,8 @@
 #include "lqueue.h"
 #include "data.h"
 #include "symbols.h"
+#include "memalloc.h"
+#include "fastpass.h"
 
 #if defined(WINDOWSDDK)
 #define PRIx64       "llx"
@@ -87,6 +89,39 @@ static struct asym *nullmbr; /* used for T_DOT if "current" struct is a forward
 static int (* fnEmitErr)( int, ... );
 static int noEmitErr( int msg, ... );
 
+#if FASTPASS
+/* v2.52: pass-invariant operand cache.
+ * The results of EvalOperand() for the operands of an instruction are
+ * attached to the stored line. If an expression consists of numbers,
+ * strings, registers, types, struct fields and invariant equates only,
+ * the result is reused in further passes instead of evaluating it again.
+ * Labels, $, assembly-time variables and anything which depends on the
+ * current assembler state make an expression "variant".
+ * The entries of a line are matched in the order of the EvalOperand()
+ * calls; if the sequence differs, the cache of the line isn't used.
+ */
+struct expr_cache {
+    struct expr_cache *next;
+    struct expr *opnd;     /* result if expression is invariant, else NULL */
+    uint_32 sig;           /* signature of the expression's tokens */
+    uint_16 start;         /* index of first token */
+    uint_16 end;           /* index of token which terminated the expression */
+    uint_16 next_tok;      /* index returned in *start_tok */
+    uint_8  flags;         /* flags argument of EvalOperand() */
+    int_16  tok[5];        /* token pointers in opnd, stored as indices */
+};
+
+static bool eval_variant;              /* current expression isn't pass-invariant */
+static struct line_item *cache_line;   /* stored line whose cache is active */
+static struct asm_tok *cache_tokens;   /* token buffer of this line */
+static struct expr_cache **cache_pos;  /* next entry to be matched or added */
+static uint_32 cntLookup;              /* evaluations in pass 2+ with active cache */
+static uint_32 cntHit;                 /* evaluations replaced by a cached result */
+#define SetVariant() eval_variant = TRUE
+#else
+#define SetVariant()
+#endif
+
 /* code label type values - returned by SIZE and TYPE operators */
 enum labelsize {
     LS_SHORT  = 0xFF01, /* it's documented, but can a label be "short"? */
@@ -118,6 +153,7 @@ static void init_expr( struct expr *opnd )
     opnd->mbr      = NULL;
     opnd->type     = NULL;
 	opnd->isptr = FALSE;
+    opnd->is_span  = FALSE;
 }
 
 static ret_code  GetMask128(struct expr *opnd1, int index, struct asm_tok tokenarray[])
@@ -804,6 +840,49 @@ static uint_32 GetRecordMask( struct dsym *record )
  * generated code is run, the old strategy needed too much space.
  */
 
+/* gcc needs suffixes if the constants won't fit in long type */
+#if defined(LLONG_MAX) || defined(__GNUC__) || defined(__TINYC__)
+#define SWAR64( x ) x##ULL
+#else
+#define SWAR64( x ) x##ui64
+#endif
+
+/* v2.52: SWAR conversion of 8 digits. The chars are read as a
+ * little-endian 64-bit number, so the first char is in the low byte.
+ * The digits have been checked by the tokenizer already.
+ */
+
+static uint_64 get_le64( const char *src )
+/****************************************/
+{
+    const uint_8 *p = (const uint_8 *)src;
+
+    return( (uint_64)p[0]       | (uint_64)p[1] << 8  | (uint_64)p[2] << 16 | (uint_64)p[3] << 24 |
+            (uint_64)p[4] << 32 | (uint_64)p[5] << 40 | (uint_64)p[6] << 48 | (uint_64)p[7] << 56 );
+}
+
+static uint_32 dec8( const char *src )
+/************************************/
+{
+    uint_64 val = get_le64( src ) - SWAR64( 0x3030303030303030 );
+
+    val = ( val * 10 + ( val >> 8 ) ) & SWAR64( 0x00FF00FF00FF00FF );       /* 2 digits per word */
+    val = ( val * 100 + ( val >> 16 ) ) & SWAR64( 0x0000FFFF0000FFFF );     /* 4 digits per dword */
+    return( (uint_32)( val * 10000 + ( val >> 32 ) ) );              /* 8 digits */
+}
+
+static uint_32 hex8( const char *src )
+/************************************/
+{
+    uint_64 val = get_le64( src );
+
+    /* '0'-'9' -> 0-9, 'A'-'F' and 'a'-'f' -> 10-15 */
+    val = ( val & SWAR64( 0x0F0F0F0F0F0F0F0F ) ) + ( ( val >> 6 ) & SWAR64( 0x0101010101010101 ) ) * 9;
+    val = ( ( val & SWAR64( 0x000F000F000F000F ) ) << 4 ) | ( ( val >> 8 ) & SWAR64( 0x000F000F000F000F ) );
+    val = ( ( val & SWAR64( 0x000000FF000000FF ) ) << 8 ) | ( ( val >> 16 ) & SWAR64( 0x000000FF000000FF ) );
+    return( (uint_32)( ( ( val & 0xFFFF ) << 16 ) | ( ( val >> 32 ) & 0xFFFF ) ) );
+}
+
 void myatoi128( const char *src, uint_64 dst[], int base, int size )
 /******************************************************************/
 {
@@ -820,6 +899,24 @@ void myatoi128( const char *src, uint_64 dst[], int base, int size )
       end += 2;
     }
 #endif
+    /* v2.52: if the number has at most 64 bits, convert it with 64-bit
+     * arithmetic; hex and decimal digits are converted in groups of 8.
+     */
+    len = end - src;
+    if ( size > 0 && ( ( base == 16 && len <= 16 ) || ( base == 10 && len <= 19 ) ||
+                      ( base == 8 && len <= 21 ) || ( base == 2 && len <= 64 ) ) ) {
+        uint_64 val64 = 0;
+        if ( base == 16 )
+            for ( ; len >= 8; len -= 8, src += 8 )
+                val64 = ( val64 << 32 ) | hex8( src );
+        else if ( base == 10 )
+            for ( ; len >= 8; len -= 8, src += 8 )
+                val64 = val64 * 100000000 + dec8( src );
+        for ( ; src < end; src++ )
+            val64 = val64 * base + ( *src <= '9' ? *src - '0' : ( *src | 0x20 ) - 'a' + 10 );
+        dst[0] = val64;
+        return;
+    }
     do {
         val = ( *src <= '9' ? *src - '0' : ( *src | 0x20 ) - 'a' + 10 );
         px = (uint_16 *)dst;
@@ -848,6 +945,26 @@ void myatoi128( const char *src, uint_64 dst[], int base, int size )
  * - variable (internal, external, stack ) or constant (EQU, '=')
  * valid reserved IDs are types (BYTE, WORD, ... ) and FLAT
  */
+#if FASTPASS
+
+/* is symbol's value the same in all passes? */
+
+static bool IsInvariantSym( const struct asym *sym )
+/**************************************************/
+{
+    switch ( sym->state ) {
+    case SYM_TYPE:
+    case SYM_STRUCT_FIELD:
+        return( TRUE );
+    case SYM_INTERNAL:
+        return( sym->isequate && sym->invariant && sym->variable == FALSE &&
+               sym->predefined == FALSE && sym->segment == NULL );
+    }
+    return( FALSE );
+}
+
+#endif
+
 static ret_code get_operand( struct expr *opnd, int *idx, struct asm_tok tokenarray[], const uint_8 flags )
 /*********************************************************************************************************/
 {
@@ -862,6 +979,9 @@ static ret_code get_operand( struct expr *opnd, int *idx, struct asm_tok tokenar
 	struct asym *labelsym;
 	struct asym *labelsym2;
 	struct asm_tok tok;
+#if FASTPASS
+    bool        prev_variant;
+#endif
 
     DebugMsg1(("%u get_operand(idx=%u >%s<) enter [memtype=%Xh]\n", evallvl, i, tokenarray[i].tokpos, opnd->mem_type ));
     switch( tokenarray[i].token ) {
@@ -869,6 +989,7 @@ static ret_code get_operand( struct expr *opnd, int *idx, struct asm_tok tokenar
 		/* Allow .labelname to be used as an operand */
 		if ((tokenarray[*idx].token == T_DOT && tokenarray[(*idx) + 1].token == T_ID))
 		{
+			SetVariant();
 			// check that T_ID is a label
 			sprintf(clabel, "%s%s", ".", tokenarray[(*idx) + 1].string_ptr);
 			labelsym = SymFind(clabel);
@@ -914,6 +1035,7 @@ static ret_code get_operand( struct expr *opnd, int *idx, struct asm_tok tokenar
 			*/
 			/* optimized and alowed white space after '{' and before '}', v2.38 */
 			if (tokenarray[i].string_delim == '{' && evex) {
+				SetVariant(); /* depends on the instruction */
 				p = tokenarray[i].string_ptr;
 				while (isspace(*p)) p++;           /* skip white spaces*/
 				if (memcmp(p, "rn-sae", 6) == 0) {
@@ -971,6 +1093,9 @@ static ret_code get_operand( struct expr *opnd, int *idx, struct asm_tok tokenar
         opnd->kind = EXPR_REG;
         opnd->base_reg = &tokenarray[i];
         j = tokenarray[i].tokval;
+        /* indirect addressing and segment registers depend on ASSUMEs */
+        if ( ( flags & EXPF_IN_SQBR ) || ( GetValueSp( j ) & OP_SR ) )
+            SetVariant();
         
         /* check if cpu is sufficient for register */
         if( ( ( GetCpuSp( j ) & P_EXT_MASK ) &&
@@ -1020,6 +1145,11 @@ static ret_code get_operand( struct expr *opnd, int *idx, struct asm_tok tokenar
         break;
     case T_ID:
 		isNowID:
+#if FASTPASS
+        /* the expression is variant unless the symbol is found to be invariant */
+        prev_variant = eval_variant;
+        eval_variant = TRUE;
+#endif
         tmp = tokenarray[i].string_ptr;
         //if ( opnd->type ) { /* v2.11 */
         if ( opnd->is_dot ) {
@@ -1184,6 +1314,10 @@ static ret_code get_operand( struct expr *opnd, int *idx, struct asm_tok tokenar
         }
         /* set default values */
         sym->used = TRUE;
+#if FASTPASS
+        if ( IsInvariantSym( sym ) )
+            eval_variant = prev_variant;
+#endif
         DebugMsg1(("get_operand(%s): sym->state=%u type=>%s< ofs=%X memtype=%Xh total_size=%u defined=%u\n",
                 tokenarray[i].string_ptr, sym->state, sym->type ? sym->type->name : "NULL", sym->offset, sym->mem_type, sym->total_size, sym->isdefined ));
         switch ( sym->state ) {
@@ -2073,6 +2207,7 @@ static ret_code argidx_op(int oper, struct expr *opnd1, struct expr *opnd2, stru
 	bool argFound = FALSE;
 	struct dsym* param = NULL;
 
+	SetVariant(); /* depends on the current PROC */
 	if (CurrProc == NULL)
 	{
 		EmitErr(ARGIDX_NOT_IN_PROC);
@@ -2134,6 +2269,7 @@ static ret_code argsize_op(int oper, struct expr *opnd1, struct expr *opnd2, str
 	bool argFound = FALSE;
 	struct dsym* param = NULL;
 
+	SetVariant(); /* depends on the current PROC */
 	if (CurrProc == NULL)
 	{
 		EmitErr(ARGSIZE_NOT_IN_PROC);
@@ -2197,6 +2333,7 @@ static ret_code argtype_op(int oper, struct expr *opnd1, struct expr *opnd2, str
 	bool argFound = FALSE;
 	struct dsym* param = NULL;
 
+	SetVariant(); /* depends on the current PROC */
 	if (CurrProc == NULL)
 	{
 		EmitErr(ARGTYPE_NOT_IN_PROC);
@@ -2412,6 +2549,7 @@ static ret_code high32_op( int oper, struct expr *opnd1, struct expr *opnd2, str
 static ret_code this_op( int oper, struct expr *opnd1, struct expr *opnd2, struct asym *sym, char *name )
 /*******************************************************************************************************/
 {
+    SetVariant(); /* THIS is the current location */
     if ( opnd2->is_type == FALSE ) {
         return( fnEmitErr( INVALID_TYPE_EXPRESSION ) );
     }
@@ -2473,6 +2611,7 @@ static ret_code wimask_op( int oper, struct expr *opnd1, struct expr *opnd2, str
     }
     if ( oper == T_MASK ) {
         int i;
+        SetVariant(); /* result depends on the instruction's first operand */
         opnd1->value = 0;
         if ( opnd2->is_type ) { /* get mask of the RECORD? */
           if (0 == _memicmp(ModuleInfo.tokenarray[1].string_ptr, "xmm", 3)){
@@ -2583,6 +2722,7 @@ static ret_code plus_op( struct expr *opnd1, struct expr *opnd2 )
 
         DebugMsg1(("plus_op: CONST - CONST\n" ));
         opnd1->llvalue += opnd2->llvalue;
+        opnd1->is_span |= opnd2->is_span; /* v2.52 */
 
     } else if( check_same( opnd1, opnd2, EXPR_ADDR ) ) {
 
@@ -2603,6 +2743,7 @@ static ret_code plus_op( struct expr *opnd1, struct expr *opnd2 )
             }
             opnd1->label_tok = opnd2->label_tok;
             opnd1->sym = opnd2->sym;
+            opnd1->is_span = opnd2->is_span; /* v2.52 */
             /* v2.05: added */
             if ( opnd1->mem_type == MT_EMPTY )
                 opnd1->mem_type = opnd2->mem_type;
@@ -2618,6 +2759,7 @@ static ret_code plus_op( struct expr *opnd1, struct expr *opnd2 )
     } else if( check_both( opnd1, opnd2, EXPR_CONST, EXPR_ADDR ) ) {
 
         if( opnd1->kind == EXPR_CONST ) {
+            bool span = opnd1->is_span;
             DebugMsg1(("plus_op: CONST - ADDR\n" ));
             opnd2->llvalue += opnd1->llvalue;
             opnd2->indirect |= opnd1->indirect;
@@ -2637,10 +2779,16 @@ static ret_code plus_op( struct expr *opnd1, struct expr *opnd2 )
                 opnd1->type = opnd2->type; /* set <type> in op1! */
 
             TokenAssign( opnd1, opnd2 );
+            /* v2.52: a scaled label difference, [(L2-L1)*4+ebx] */
+            if ( span && opnd1->sym == NULL )
+                opnd1->is_span = TRUE;
 
         } else {
             DebugMsg1(("plus_op: ADDR - CONST\n" ));
             opnd1->llvalue += opnd2->llvalue;
+            /* v2.52: a scaled label difference, [ebx+(L2-L1)*4] */
+            if ( opnd2->is_span && opnd1->sym == NULL )
+                opnd1->is_span = TRUE;
             /* v2.04: added. to make this case behave like
              * the CONST - REG case (see below).
              */
@@ -2696,12 +2844,15 @@ static ret_code minus_op( struct expr *opnd1, struct expr *opnd2 )
 
         DebugMsg1(("minus_op: CONST-CONST\n" ));
         opnd1->llvalue -= opnd2->llvalue;
+        opnd1->is_span |= opnd2->is_span; /* v2.52 */
 
     } else if( opnd1->kind == EXPR_ADDR &&
               opnd2->kind == EXPR_CONST ) {
 
         DebugMsg1(("minus_op: ADDR-CONST\n" ));
         opnd1->llvalue -= opnd2->llvalue;
+        if ( opnd2->is_span && opnd1->sym == NULL ) /* v2.52 */
+            opnd1->is_span = TRUE;
         fix_struct_value( opnd1 );
 
     } else if( check_same( opnd1, opnd2, EXPR_ADDR ) ){
@@ -2768,6 +2919,7 @@ static ret_code minus_op( struct expr *opnd1, struct expr *opnd2 )
                     opnd1->label_tok = opnd2->label_tok;
                 }
                 opnd1->kind = EXPR_ADDR;
+                opnd1->is_span = TRUE; /* v2.52: will be a constant */
             } else {
                 /* v2.06c: do 64-bit arithmetic (more rigid test in data.c) */
                 //opnd1->value -= sym->offset;
@@ -3523,6 +3675,8 @@ static ret_code calculate( struct expr *opnd1, struct expr *opnd2, const struct
 
         if( check_same( opnd1, opnd2, EXPR_CONST ) ) {
             opnd1->llvalue *= opnd2->llvalue;
+            /* v2.52: a scaled label difference is still relaxable */
+            opnd1->is_span |= opnd2->is_span;
         } else if( check_both( opnd1, opnd2, EXPR_REG, EXPR_CONST ) ) {
             if( check_direct_reg( opnd1, opnd2 ) == ERROR ) {
                 DebugMsg(("calculate(*) error direct register\n"));
@@ -3575,6 +3729,7 @@ static ret_code calculate( struct expr *opnd1, struct expr *opnd2, const struct
         }
 
         opnd1->value64 /= opnd2->value64;
+        opnd1->is_span |= opnd2->is_span; /* v2.52 */
         break;
     case T_BINARY_OPERATOR:
         DebugMsg1(("calculate(%s [T_BINARY_OPERATOR] ): t1-t2 kind %d/%d memtype %X-%X sym %s-%s type %s-%s\n",
@@ -4052,6 +4207,7 @@ static ret_code evaluate( struct expr *opnd1, int *i, struct asm_tok tokenarray[
 	/* Allow .labelname to be used as an operand */
 	if ( (tokenarray[*i].token == T_DOT && tokenarray[(*i) + 1].token == T_ID) && opnd1->kind != EXPR_REG )
 	{
+		SetVariant();
 		// check that T_ID is a label
 		sprintf(clabel, "%s%s", ".", tokenarray[(*i) + 1].string_ptr);
 		labelsym = SymFind(clabel);
@@ -4076,6 +4232,7 @@ static ret_code evaluate( struct expr *opnd1, int *i, struct asm_tok tokenarray[
 	}
 	if ((tokenarray[*i].tokval == T_SHORT || tokenarray[*i].tokval == T_OFFSET) && tokenarray[(*i) + 1].token == T_DOT && tokenarray[(*i) + 2].token == T_ID)
 	{
+		SetVariant();
 		// check that T_ID is a label
 		sprintf(clabel, "%s%s", ".", tokenarray[(*i) + 2].string_ptr);
 		labelsym = SymFind(clabel);
@@ -4137,6 +4294,7 @@ static ret_code evaluate( struct expr *opnd1, int *i, struct asm_tok tokenarray[
 						{
 							if (InitRecordVar(opnd1, curr_operator, tokenarray, recordsym) != ERROR)
 								rc = NOT_ERROR;
+							SetVariant();
 							return(rc);
 						}
 						else
@@ -4241,6 +4399,7 @@ static ret_code evaluate( struct expr *opnd1, int *i, struct asm_tok tokenarray[
               if (0 == _memicmp(tokenarray[1].string_ptr, "xmm", 3)) {
                 if (GetMask128(opnd1, 3, tokenarray) != ERROR)
                   rc = NOT_ERROR;
+                SetVariant();
                 opnd2.kind = EXPR_ADDR;
                 opnd2.mem_type = MT_OWORD;
               }
@@ -4336,6 +4495,116 @@ static int noEmitErr( int msg, ... )
  * start_tok: index of first token of expression
  * end_tok:   index of last  token of expression
  */
+#if FASTPASS
+
+/* signature of an expression's tokens; used to verify that a
+ * cache entry belongs to the expression which is evaluated.
+ */
+
+static uint_32 TokenSignature( const struct asm_tok *tok, int cnt )
+/*****************************************************************/
+{
+    uint_32 h = 2166136261u; /* FNV-1a */
+    const unsigned char *p;
+
+    for ( ; cnt; cnt--, tok++ ) {
+        h = ( h ^ tok->token ) * 16777619u;
+        h = ( h ^ (unsigned char)tok->bytval ) * 16777619u;
+        h = ( h ^ tok->tokval ) * 16777619u;
+        for ( p = (const unsigned char *)tok->string_ptr; *p; p++ )
+            h = ( h ^ *p ) * 16777619u;
+    }
+    return( h );
+}
+
+/* store an invariant result in a cache entry. Token pointers are
+ * stored as indices, since the token buffer may differ between passes.
+ */
+
+static void CacheStore( struct expr_cache *ec, const struct expr *opnd, int end_tok )
+/**********************************************************************************/
+{
+    const struct asm_tok *tok[5];
+    int i;
+
+    tok[0] = opnd->quoted_string; /* or float_tok */
+    tok[1] = opnd->base_reg;
+    tok[2] = opnd->idx_reg;
+    tok[3] = opnd->label_tok;     /* or type_tok */
+    tok[4] = opnd->override;
+    for ( i = 0; i < 5; i++ ) {
+        if ( tok[i] == NULL )
+            ec->tok[i] = -1;
+        else if ( tok[i] >= cache_tokens && tok[i] < cache_tokens + end_tok )
+            ec->tok[i] = tok[i] - cache_tokens;
+        else
+            return;
+    }
+    ec->opnd = LclAlloc( sizeof( struct expr ) );
+    memcpy( ec->opnd, opnd, sizeof( struct expr ) );
+}
+
+static void CacheRestore( const struct expr_cache *ec, struct expr *opnd, struct asm_tok tokenarray[] )
+/****************************************************************************************************/
+{
+    memcpy( opnd, ec->opnd, sizeof( struct expr ) );
+    opnd->quoted_string = ( ec->tok[0] >= 0 ? &tokenarray[ec->tok[0]] : NULL );
+    opnd->base_reg      = ( ec->tok[1] >= 0 ? &tokenarray[ec->tok[1]] : NULL );
+    opnd->idx_reg       = ( ec->tok[2] >= 0 ? &tokenarray[ec->tok[2]] : NULL );
+    opnd->label_tok     = ( ec->tok[3] >= 0 ? &tokenarray[ec->tok[3]] : NULL );
+    opnd->override      = ( ec->tok[4] >= 0 ? &tokenarray[ec->tok[4]] : NULL );
+}
+
+/* evaluate an expression of a stored line.
+ * the result is taken from the line's cache if possible.
+ */
+
+static ret_code CachedEvaluate( struct expr *result, int *start_tok, struct asm_tok tokenarray[], int end_tok, uint_8 flags )
+/***************************************************************************************************************************/
+{
+    struct expr_cache *ec = *cache_pos;
+    uint_32 sig = TokenSignature( &tokenarray[*start_tok], end_tok - *start_tok );
+    ret_code rc;
+
+    if ( Parse_Pass > PASS_1 )
+        cntLookup++;
+    if ( ec ) {
+        if ( ec->sig != sig || ec->start != *start_tok || ec->end != end_tok || ec->flags != flags ) {
+            DebugMsg1(("CachedEvaluate: sequence of expressions has changed, cache of line disabled\n" ));
+            cache_line = NULL;
+            return( evaluate( result, start_tok, tokenarray, end_tok, flags ) );
+        }
+        cache_pos = &ec->next;
+        if ( ec->opnd ) {
+            CacheRestore( ec, result, tokenarray );
+            *start_tok = ec->next_tok;
+            cntHit++;
+            return( NOT_ERROR );
+        }
+    } else {
+        ec = LclAlloc( sizeof( struct expr_cache ) );
+        ec->next = NULL;
+        ec->opnd = NULL;
+        ec->sig = sig;
+        ec->start = *start_tok;
+        ec->end = end_tok;
+        ec->flags = flags;
+        *cache_pos = ec;
+        cache_pos = &ec->next;
+    }
+    rc = evaluate( result, start_tok, tokenarray, end_tok, flags );
+    /* an entry which was variant in pass one (i.e. due to a forward
+     * reference) may become invariant in pass two.
+     */
+    if ( rc == NOT_ERROR && eval_variant == FALSE && result->kind != EXPR_ERROR ) {
+        ec->next_tok = *start_tok;
+        CacheStore( ec, result, end_tok );
+    }
+    return( rc );
+}
+
+#endif
+
 ret_code EvalOperand( int *start_tok, struct asm_tok tokenarray[], int end_tok, struct expr *result, uint_8 flags )
 /*****************************************************************************************************************/
 {
@@ -4344,6 +4613,9 @@ ret_code EvalOperand( int *start_tok, struct asm_tok tokenarray[], int end_tok,
     DebugMsg1(("EvalOperand(start=%u, end=%u, flags=%X) enter: >%s<\n", *start_tok, end_tok, flags, tokenarray[*start_tok].tokpos ));
 
     init_expr( result );
+#if FASTPASS
+    eval_variant = FALSE;
+#endif
 
     for( i = *start_tok; ( i < end_tok ) && is_expr_item( &tokenarray[i] ); i++ );
     if ( i == *start_tok )
@@ -4351,9 +4623,62 @@ ret_code EvalOperand( int *start_tok, struct asm_tok tokenarray[], int end_tok,
 
     /* v2.10: global flag 'error_msg' replaced by 'fnEmitErr()' */
     fnEmitErr = ( ( flags & EXPF_NOERRMSG ) ? noEmitErr : EmitErr );
+#if FASTPASS
+    if ( cache_line && tokenarray == cache_tokens && ModuleInfo.GeneratedCode == 0 )
+        return( CachedEvaluate( result, start_tok, tokenarray, i, flags ) );
+#endif
     return ( evaluate( result, start_tok, tokenarray, i, flags ) );
 }
 
+#if FASTPASS
+
+/* is the result of the last EvalOperand() call the same in all passes? */
+
+bool ExprIsInvariant( void )
+/**************************/
+{
+    return( !eval_variant );
+}
+
+/* set the stored line whose operands are to be cached;
+ * NULL disables the cache.
+ */
+
+void EvalCacheLine( struct line_item *line, struct asm_tok tokenarray[] )
+/***********************************************************************/
+{
+    cache_line = line;
+    cache_tokens = tokenarray;
+    if ( line )
+        cache_pos = &line->ecache;
+}
+
+#if FASTMEM==0
+void EvalCacheFree( struct expr_cache *ec )
+/*****************************************/
+{
+    struct expr_cache *next;
+    for ( ; ec; ec = next ) {
+        next = ec->next;
+        if ( ec->opnd )
+            LclFree( ec->opnd );
+        LclFree( ec );
+    }
+}
+#endif
+
+/* display operand cache hit rate ( -stats ) */
+
+void EvalCacheStats( void )
+/*************************/
+{
+    if ( cntLookup )
+        printf( "FASTPASS: %" I32_SPEC "u of %" I32_SPEC "u expressions reused from operand cache (%u%%)\n",
+               cntHit, cntLookup, (unsigned)( (uint_64)cntHit * 100 / cntLookup ) );
+}
+
+#endif
+
 ret_code EmitConstError( const struct expr *opnd )
 /************************************************/
 {
@@ -4372,4 +4697,9 @@ void ExprEvalInit( void )
     thissym = NULL;
     nullstruct = NULL;
     nullmbr = NULL;
+#if FASTPASS
+    cache_line = NULL;
+    cntLookup = 0;
+    cntHit = 0;
+#endif
 }
@@ -24,6 +24,7 @@
 #include "parser.h"
 #include "input.h"
 #include "segment.h"
+#include "expreval.h"
 #include "fastpass.h"
 
 #if FASTPASS
@@ -39,6 +40,42 @@ struct line_item *LineStoreCurr; /* must be global! */
 bool StoreState;
 bool UseSavedState;
 
+/* reason why the line store was abandoned ( see -stats ) */
+static struct {
+    bool active;
+    enum fastpass_skip reason;
+    unsigned srcfile;
+    uint_32 lineno;
+    char name[MAX_ID_LEN+1];
+} SkipInfo;
+static uint_32 cntRescan; /* stored lines flagged for text macro re-expansion */
+
+/* names which were unknown in lines that aren't stored as they were
+ * expanded ( macro lines, conditional assembly ); see TextMacroFwdRef().
+ */
+#define UNSTORED_HASH_SIZE 1021
+
+struct unstored_name {
+    struct unstored_name *next;
+    uint_8 len;
+    char name[1];
+};
+static struct unstored_name *unstored_table[UNSTORED_HASH_SIZE];
+
+static const char * const skiptext[] = {
+    "text macro used prior to definition",
+    "PRIVATE PROC was declared PUBLIC",
+    "invalid PUBLIC",
+    "undefined segment",
+    ".SAFESEH item isn't an internal PROC",
+    "ALIAS target isn't PUBLIC or external",
+    "invalid alternate name of external",
+    "-hllopt with listing of generated code",
+};
+
+/* reasons which are detected in PassOneChecks() have no source line */
+#define SKIP_HAS_LINE( x ) ( x == FPS_TMACRO_FWDREF || x == FPS_PROC_PRIVATE || x == FPS_HLLOPT_LIST )
+
 /*
  * save the current status (happens in pass one only) and
  * switch to "save precompiled lines" mode.
@@ -49,6 +86,8 @@ bool UseSavedState;
 static void SaveState( void )
 /***************************/
 {
+    struct dsym *curr;
+
     DebugMsg1(("SaveState enter\n" ));
     StoreState = TRUE;
     UseSavedState = TRUE;
@@ -61,6 +100,12 @@ static void SaveState( void )
     AssumeSaveState();
     ContextSaveState(); /* save pushcontext/popcontext stack */
 
+    /* forward references which occured so far are in lines that
+     * are not stored; see TextMacroFwdRef().
+     */
+    for ( curr = SymTables[TAB_UNDEF].head; curr; curr = curr->next )
+        curr->sym.prestore = TRUE;
+
     DebugMsg(( "SaveState exit\n" ));
 }
 
@@ -76,6 +121,8 @@ void StoreLine( const char *srcline, int flags, uint_32 lst_position )
 #endif
     if ( ModuleInfo.GeneratedCode ) /* don't store generated lines! */
         return;
+    if ( Options.preprocessor_stdout ) /* v2.52: -EP runs one pass only */
+        return;
     if ( StoreState == FALSE ) /* line store already started? */
         SaveState();
 
@@ -83,6 +130,7 @@ void StoreLine( const char *srcline, int flags, uint_32 lst_position )
     j = ( ( ( flags & 1 ) && ModuleInfo.CurrComment ) ? strlen( ModuleInfo.CurrComment ) : 0 );
     LineStoreCurr = LclAlloc( i + j + sizeof( struct line_item ) );
     LineStoreCurr->next = NULL;
+    LineStoreCurr->ecache = NULL;
     LineStoreCurr->lineno = GetLineNumber();
     if ( MacroLevel ) {
         LineStoreCurr->srcfile = 0xfff;
@@ -90,6 +138,7 @@ void StoreLine( const char *srcline, int flags, uint_32 lst_position )
         LineStoreCurr->srcfile = get_curr_srcfile();
     }
     LineStoreCurr->list_pos = ( lst_position ? lst_position : list_pos );
+    LineStoreCurr->rescan = FALSE;
     if ( j ) {
         memcpy( LineStoreCurr->line, srcline, i );
         memcpy( LineStoreCurr->line + i, ModuleInfo.CurrComment, j + 1 );
@@ -118,13 +167,125 @@ void StoreLine( const char *srcline, int flags, uint_32 lst_position )
  reported in pass 2, so ensure that a full source scan is done then
  */
 
-void SkipSavedState( void )
-/*************************/
+void SkipSavedState( enum fastpass_skip reason, const char *name )
+/****************************************************************/
 {
-    DebugMsg(("SkipSavedState enter\n"));
+    DebugMsg(("SkipSavedState(%u, %s) enter\n", reason, name ? name : "" ));
+    /* just the first reason is displayed */
+    if ( SkipInfo.active == FALSE ) {
+        SkipInfo.active = TRUE;
+        SkipInfo.reason = reason;
+        if ( SKIP_HAS_LINE( reason ) ) {
+            SkipInfo.srcfile = get_curr_srcfile();
+            SkipInfo.lineno = GetLineNumber();
+        }
+        if ( name ) {
+            strncpy( SkipInfo.name, name, MAX_ID_LEN );
+            SkipInfo.name[MAX_ID_LEN] = NULLC;
+        } else
+            SkipInfo.name[0] = NULLC;
+    }
     UseSavedState = FALSE;
 }
 
+/* does a stored line contain identifier <name>? */
+
+static bool LineHasName( const char *line, const char *name, int len )
+/********************************************************************/
+{
+    const char *p;
+
+    for ( p = line; *p; p++ ) {
+        if ( SymCmpFunc( p, name, len ) == 0 &&
+            ( p == line || !is_valid_id_char( *(p-1) ) ) &&
+            !is_valid_id_char( *(p+len) ) )
+            return( TRUE );
+    }
+    return( FALSE );
+}
+
+static struct unstored_name **UnstoredFind( const char *name, int len )
+/*********************************************************************/
+{
+    unsigned h;
+    int i;
+    struct unstored_name **pp;
+
+    for ( h = 0, i = 0; i < len; i++ )
+        h = h * 31 + ( name[i] | ' ' );
+    for ( pp = &unstored_table[h % UNSTORED_HASH_SIZE]; *pp; pp = &(*pp)->next )
+        if ( (*pp)->len == len && SymCmpFunc( (*pp)->name, name, len ) == 0 )
+            break;
+    return( pp );
+}
+
+/* an unknown name has been found in a line that isn't stored as it was
+ * expanded ( called by ExpandToken() in pass one ).
+ */
+
+void UnstoredName( const char *name )
+/***********************************/
+{
+    int len = strlen( name );
+    struct unstored_name **pp;
+
+    if ( len > MAX_ID_LEN || *( pp = UnstoredFind( name, len ) ) )
+        return;
+    *pp = LclAlloc( sizeof( struct unstored_name ) + len );
+    (*pp)->next = NULL;
+    (*pp)->len = len;
+    memcpy( (*pp)->name, name, len + 1 );
+}
+
+/* a text macro has been defined after it was referenced.
+ * If the line store did exist already when the first
+ * reference occured, the stored lines containing the name
+ * are flagged to be re-expanded in further passes. Else,
+ * or if the name was also referenced in a macro line or by
+ * conditional assembly, which may now generate other lines,
+ * further passes must be full passes.
+ */
+
+void TextMacroFwdRef( struct asym *sym )
+/**************************************/
+{
+    struct line_item *curr;
+    uint_32 cnt = 0;
+
+    if ( StoreState && UseSavedState && sym->prestore == FALSE &&
+        *UnstoredFind( sym->name, sym->name_size ) == NULL ) {
+        for ( curr = LineStore.head; curr; curr = curr->next ) {
+            if ( LineHasName( curr->line, sym->name, sym->name_size ) ) {
+                curr->rescan = TRUE;
+                cnt++;
+            }
+        }
+    }
+    DebugMsg(("TextMacroFwdRef(%s): %u stored lines flagged\n", sym->name, cnt ));
+    if ( cnt == 0 )
+        SkipSavedState( FPS_TMACRO_FWDREF, sym->name );
+    cntRescan += cnt;
+}
+
+/* display FASTPASS status ( -stats ) */
+
+void FastpassStats( void )
+/************************/
+{
+    if ( SkipInfo.active ) {
+        printf( "FASTPASS disabled: %s", skiptext[SkipInfo.reason] );
+        if ( SkipInfo.name[0] )
+            printf( ": %s", SkipInfo.name );
+        if ( SKIP_HAS_LINE( SkipInfo.reason ) )
+            printf( " [%s(%" I32_SPEC "u)]", GetFName( SkipInfo.srcfile )->fname, SkipInfo.lineno );
+        printf( "\n" );
+    } else if ( modstate.init )
+        printf( "FASTPASS active\n" );
+    if ( cntRescan )
+        printf( "FASTPASS: %" I32_SPEC "u stored lines re-expanded for forward-referenced text macros\n", cntRescan );
+    EvalCacheStats();
+}
+
 /* for FASTPASS, just pass 1 is a full pass, the other passes
  don't start from scratch and they just assemble the preprocessed
  source. To be able to restart the assembly process from a certain
@@ -212,6 +373,7 @@ void FreeLineStore( void )
     struct line_item *next;
     for ( LineStoreCurr = LineStore.head; LineStoreCurr; ) {
         next = LineStoreCurr->next;
+        EvalCacheFree( LineStoreCurr->ecache );
         LclFree( LineStoreCurr );
         LineStoreCurr = next;
     }
@@ -226,6 +388,9 @@ void FastpassInit( void )
     LineStore.head = NULL;
     LineStore.tail = NULL;
     UseSavedState = FALSE;
+    SkipInfo.active = FALSE;
+    cntRescan = 0;
+    memset( unstored_table, 0, sizeof( unstored_table ) );
 }
 
 #endif
@@ -290,6 +290,9 @@ void store_fixup( struct fixup *fixup, struct dsym *seg, int_32 *pdata )
         }
 #endif
     }
+    /* v2.52: code of a folded proc has the fixups of the proc it's folded to */
+    if ( seg->e.seginfo->overlay )
+        return;
     if( seg->e.seginfo->FixupList.head == NULL ) {
         seg->e.seginfo->FixupList.tail = seg->e.seginfo->FixupList.head = fixup;
     } else {
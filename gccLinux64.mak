@@ -2,6 +2,7 @@
 # This makefile creates the UASM Elf binary for Linux/FreeBSD.
 
 TARGET1=uasm
+TARGET2=libuasm.so
 
 ifndef DEBUG
 DEBUG=0
@@ -45,6 +46,30 @@ else
 	$(CC) -D __UNIX__ $(OUTD)/main.o $(proj_obj) -o $@ -Wl,-Map,$(OUTD)/$(TARGET1).map
 endif
 
+# shared library, see H/libuasm.h. Objects are compiled as PIC in a subdirectory.
+pic_obj = $(proj_obj:$(OUTD)/%=$(OUTD)/pic/%) $(OUTD)/pic/libuasm.o
+
+$(OUTD)/pic/%.o: %.c
+	$(CC) -D __UNIX__ -c $(inc_dirs) $(c_flags) -fPIC -fvisibility=hidden -o $@ $<
+
+lib: $(OUTD)/pic $(OUTD)/$(TARGET2)
+
+$(OUTD)/pic:
+	mkdir -p $(OUTD)/pic
+
+$(OUTD)/$(TARGET2) : $(pic_obj)
+	$(CC) -D __UNIX__ -shared $(pic_obj) -o $@ -lpthread
+
+# library test, see regress/lib; H/malloc.h must not hide the system header.
+libtest: lib
+	$(CC) -iquote H regress/lib/libtest.c -o $(OUTD)/libtest -L$(OUTD) -luasm -Wl,-rpath,'$$ORIGIN'
+	$(OUTD)/libtest
+
+# JIT test, x86-64 only.
+jittest: lib
+	$(CC) -iquote H regress/lib/jittest.c -o $(OUTD)/jittest -L$(OUTD) -luasm -Wl,-rpath,'$$ORIGIN'
+	$(OUTD)/jittest
+
 $(OUTD)/msgtext.o: msgtext.c H/msgdef.h
 	$(CC) -D __UNIX__ -c $(inc_dirs) $(c_flags) -o $*.o msgtext.c
 
@@ -53,7 +78,22 @@ $(OUTD)/reswords.o: reswords.c H/instruct.h H/special.h H/directve.h H/opndcls.h
 
 ######
 
+# encoder benchmark, results are written to regress/encbench.tsv
+bench: all
+	cd regress && sh encbench.sh ../$(OUTD)/$(TARGET1)
+
+# float conversion test and benchmark, see regress/float; "-x" tests all REAL4 values.
+$(OUTD)/fltconv: regress/float/fltconv.c $(OUTD)/atofloat.o
+	$(CC) $(inc_dirs) $(c_flags) regress/float/fltconv.c $(OUTD)/atofloat.o -o $@ -lm
+
+flttest: $(OUTD)/fltconv
+	$(OUTD)/fltconv
+
+fltbench: $(OUTD)/fltconv
+	$(OUTD)/fltconv -b
+
 clean:
 	rm $(OUTD)/$(TARGET1)
 	rm $(OUTD)/*.o
 	rm $(OUTD)/*.map
+	rm -rf $(OUTD)/pic $(OUTD)/$(TARGET2) $(OUTD)/libtest $(OUTD)/jittest $(OUTD)/fltconv
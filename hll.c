@@ -1461,6 +1461,334 @@ static ret_code ForInitAndNext(struct asm_tok tokenarray[], int cnt, char *buff)
   return(NOT_ERROR);
 }
 
+/* v2.52: jump optimization of the generated code ( option -hllopt ).
+* The jumps and labels at the end of a directive's code are kept back until
+* the next source line is parsed. If this line is another hll directive, its
+* code is appended and the jumps are optimized across both:
+* - jumps to a label which is followed by a JMP are threaded to the JMP's target
+* - a JMP or Jcc to the label immediately following is removed, and so is
+*   a JMP or Jcc followed by a JMP to the same target
+* - a Jcc over a JMP is replaced by the inverted Jcc
+* - a JMP or Jcc behind a JMP is removed ( unreachable )
+* For jumps to labels that are already emitted or not yet generated, the
+* targets found in the previous pass are used. If a label's target differs
+* from the previous pass, another pass is forced.
+*/
+
+enum hll_line_kind {
+  HLN_DELETED,
+  HLN_OTHER,
+  HLN_LABEL,
+  HLN_JMP,
+  HLN_JCC,
+};
+
+struct hll_line {
+  char    *text;    /* generated line, MemAlloc'd */
+  uint_32 label;    /* label defined or jump target */
+  uint_8  kind;     /* HLN_ value */
+  uint_8  cc;       /* Jcc: index in jcc_cond[], cc ^ 1 is the inverted condition */
+};
+
+static const char * const jcc_cond[] = {
+  "z", "nz", "e", "ne", "c", "nc", "s", "ns", "p", "np", "o", "no",
+  "a", "na", "b", "nb", "g", "ng", "l", "nl",
+  "ae", "nae", "be", "nbe", "ge", "nge", "le", "nle", "pe", "po"
+};
+
+static struct hll_line *hlines; /* generated lines not yet run */
+static unsigned hlinecnt;
+static unsigned hlinemax;
+static uint_32 *jmpalias;      /* label targets of this pass */
+static uint_32 *prevalias;     /* label targets of the previous pass */
+static uint_32 jmpaliascnt;
+static uint_32 prevaliascnt;
+static unsigned cntJmpRemoved;
+static unsigned cntJmpInverted;
+static unsigned cntJmpThreaded;
+
+/* classify a generated line */
+
+static void ScanHllLine(struct hll_line *ln)
+/********************************************/
+{
+  char *p = ln->text;
+  char *q;
+  char word[8];
+  int i;
+
+  ln->kind = HLN_OTHER;
+  while (isspace(*p)) p++;
+  if (*p == 'j' || *p == 'J') {
+    for (i = 0; isalpha(*p) && i < sizeof(word) - 1; i++, p++)
+      word[i] = tolower(*p);
+    word[i] = NULLC;
+    if (!isspace(*p))
+      return;
+    while (isspace(*p)) p++;
+    if (strcmp(word, "jmp") == 0)
+      ln->kind = HLN_JMP;
+    else {
+      for (i = 0; i < sizeof(jcc_cond) / sizeof(jcc_cond[0]); i++)
+        if (strcmp(word + 1, jcc_cond[i]) == 0) {
+          ln->kind = HLN_JCC;
+          ln->cc = i;
+          break;
+        }
+      if (ln->kind == HLN_OTHER)
+        return;
+    }
+  }
+  if (*p != '@' || *(p + 1) != 'C' || !isxdigit(*(p + 2))) {
+    ln->kind = HLN_OTHER;
+    return;
+  }
+  ln->label = strtoul(p + 2, &q, 16);
+  if (ln->kind == HLN_OTHER) {
+    if (*q != ':')
+      return;
+    for (q++; *q == ':'; q++);
+    ln->kind = HLN_LABEL;
+  }
+  while (isspace(*q)) q++;
+  if (*q != NULLC)
+    ln->kind = HLN_OTHER;
+}
+
+/* get the line index following <i>, skipping deleted lines and optionally labels */
+
+static unsigned NextHllLine(unsigned i, bool skiplabels)
+/********************************************************/
+{
+  for (i++; i < hlinecnt; i++)
+    if (hlines[i].kind != HLN_DELETED && (skiplabels == FALSE || hlines[i].kind != HLN_LABEL))
+      break;
+  return(i);
+}
+
+/* check if label <label> is defined in the run of labels starting at <i> */
+
+static bool IsHllLabelAt(unsigned i, uint_32 label)
+/***************************************************/
+{
+  for (; i < hlinecnt && (hlines[i].kind == HLN_LABEL || hlines[i].kind == HLN_DELETED); i++)
+    if (hlines[i].kind == HLN_LABEL && hlines[i].label == label)
+      return(TRUE);
+  return(FALSE);
+}
+
+/* get the target of a jump to <label>. Returns <label> if the label isn't
+* followed by a JMP.
+*/
+
+static uint_32 GetJmpTarget(uint_32 label)
+/******************************************/
+{
+  unsigned i;
+
+  for (i = 0; i < hlinecnt; i++)
+    if (hlines[i].kind == HLN_LABEL && hlines[i].label == label) {
+      i = NextHllLine(i, TRUE);
+      if (i < hlinecnt)
+        return(hlines[i].kind == HLN_JMP ? hlines[i].label : label);
+      break;
+    }
+  if (label < jmpaliascnt && jmpalias[label])
+    return(jmpalias[label]);
+  if (label < prevaliascnt && prevalias[label])
+    return(prevalias[label]);
+  return(label);
+}
+
+/* a label is emitted: store the target of jumps to it */
+
+static void SetJmpAlias(unsigned i)
+/***********************************/
+{
+  uint_32 label = hlines[i].label;
+  uint_32 target = label;
+  uint_32 *p;
+
+  i = NextHllLine(i, TRUE);
+  if (i < hlinecnt && hlines[i].kind == HLN_JMP)
+    target = hlines[i].label;
+  if (label >= jmpaliascnt) {
+    p = MemAlloc((ModuleInfo.hll_label + 64) * sizeof(uint_32));
+    memset(p, 0, (ModuleInfo.hll_label + 64) * sizeof(uint_32));
+    if (jmpalias) {
+      memcpy(p, jmpalias, jmpaliascnt * sizeof(uint_32));
+      MemFree(jmpalias);
+    }
+    jmpalias = p;
+    jmpaliascnt = ModuleInfo.hll_label + 64;
+  }
+  jmpalias[label] = target;
+  if (Parse_Pass > PASS_1 && target != (label < prevaliascnt && prevalias[label] ? prevalias[label] : label)) {
+    DebugMsg(("SetJmpAlias(%X): target changed, phase error\n", label));
+    ModuleInfo.PhaseError = TRUE;
+  }
+}
+
+static void DeleteHllLine(unsigned i)
+/*************************************/
+{
+  hlines[i].kind = HLN_DELETED;
+  cntJmpRemoved++;
+}
+
+static void SetHllJump(struct hll_line *ln, uint_32 label)
+/**********************************************************/
+{
+  char buff[16];
+
+  MemFree(ln->text);
+  ln->label = label;
+  GetLabelStr(label, buff);
+  ln->text = MemAlloc(strlen(buff) + 6);
+  if (ln->kind == HLN_JMP)
+    sprintf(ln->text, "jmp %s", buff);
+  else
+    sprintf(ln->text, "j%s %s", jcc_cond[ln->cc], buff);
+}
+
+static void OptimizeHllLines(void)
+/**********************************/
+{
+  unsigned i;
+  unsigned j;
+  unsigned k;
+  uint_32 target;
+  bool changed;
+
+  /* thread jumps */
+  for (i = 0; i < hlinecnt; i++) {
+    if (hlines[i].kind != HLN_JMP && hlines[i].kind != HLN_JCC)
+      continue;
+    for (k = 0, target = hlines[i].label; k < 16; k++) {
+      uint_32 next = GetJmpTarget(target);
+      if (next == target || next == hlines[i].label)
+        break;
+      target = next;
+    }
+    if (target != hlines[i].label) {
+      SetHllJump(&hlines[i], target);
+      cntJmpThreaded++;
+    }
+  }
+
+  do {
+    changed = FALSE;
+    for (i = 0; i < hlinecnt; i++) {
+      if (hlines[i].kind != HLN_JMP && hlines[i].kind != HLN_JCC)
+        continue;
+      j = NextHllLine(i, FALSE);
+      k = NextHllLine(i, TRUE);
+      if (IsHllLabelAt(j, hlines[i].label) ||
+          (k < hlinecnt && hlines[k].kind == HLN_JMP && hlines[k].label == hlines[i].label)) {
+        DeleteHllLine(i);
+        changed = TRUE;
+      } else if (hlines[i].kind == HLN_JMP) {
+        for (; j < hlinecnt && (hlines[j].kind == HLN_JMP || hlines[j].kind == HLN_JCC); j = NextHllLine(j, FALSE)) {
+          DeleteHllLine(j);
+          changed = TRUE;
+        }
+      } else if (j < hlinecnt && hlines[j].kind == HLN_JMP && IsHllLabelAt(NextHllLine(j, FALSE), hlines[i].label)) {
+        hlines[i].cc ^= 1;
+        SetHllJump(&hlines[i], hlines[j].label);
+        hlines[j].kind = HLN_DELETED;
+        cntJmpInverted++;
+        changed = TRUE;
+      }
+    }
+  } while (changed);
+}
+
+/* move the first <cnt> lines to the line queue */
+
+static void QueueHllLines(unsigned cnt)
+/***************************************/
+{
+  unsigned i;
+
+  for (i = 0; i < cnt; i++) {
+    if (hlines[i].kind == HLN_LABEL)
+      SetJmpAlias(i);
+    if (hlines[i].kind != HLN_DELETED)
+      AddLineQueue(hlines[i].text);
+  }
+  for (i = 0; i < cnt; i++)
+    MemFree(hlines[i].text);
+  hlinecnt -= cnt;
+  memmove(hlines, hlines + cnt, hlinecnt * sizeof(struct hll_line));
+}
+
+/* end of an hll directive: optimize its code and run the line queue.
+* the trailing jumps and labels are kept back if the directive is in the source.
+*/
+
+static void RunHllLines(void)
+/*****************************/
+{
+  char buffer[MAX_LINE_LEN];
+  unsigned i;
+
+  if (Options.hll_optimize) {
+    /* the jumps may change in later passes, and so may the number of
+    * generated lines. If they are listed, the source must be read again
+    * in each pass, since the saved line positions can't be used.
+    */
+    if (Parse_Pass == PASS_1 && UseSavedState && ModuleInfo.list && ModuleInfo.list_generated_code && CurrFile[LST])
+      SkipSavedState(FPS_HLLOPT_LIST, NULL);
+    while (PopLineQueue(buffer)) {
+      if (hlinecnt == hlinemax) {
+        struct hll_line *p = MemAlloc((hlinemax + 32) * sizeof(struct hll_line));
+        if (hlines) {
+          memcpy(p, hlines, hlinecnt * sizeof(struct hll_line));
+          MemFree(hlines);
+        }
+        hlines = p;
+        hlinemax += 32;
+      }
+      hlines[hlinecnt].text = MemAlloc(strlen(buffer) + 1);
+      strcpy(hlines[hlinecnt].text, buffer);
+      ScanHllLine(&hlines[hlinecnt]);
+      hlinecnt++;
+    }
+    OptimizeHllLines();
+    for (i = hlinecnt; i && hlines[i - 1].kind != HLN_OTHER; i--);
+    QueueHllLines(ModuleInfo.GeneratedCode ? hlinecnt : i);
+  }
+  if (is_linequeue_populated())
+    RunLineQueue();
+}
+
+/* run the code kept back by the last hll directive.
+* called after a source line has been tokenized, before it is processed;
+* nothing is done if the line is another hll directive.
+* returns TRUE if code has been run; the caller tokenizes the line again then.
+*/
+
+bool HllFlush(struct asm_tok tokenarray[])
+/******************************************/
+{
+  if (hlinecnt && ModuleInfo.GeneratedCode == 0 &&
+      (tokenarray[0].token != T_DIRECTIVE || tokenarray[0].dirtype < DRT_HLLSTART || tokenarray[0].dirtype > DRT_HLLEND)) {
+    QueueHllLines(hlinecnt);
+    RunLineQueue();
+    return(TRUE);
+  }
+  return(FALSE);
+}
+
+/* display jump optimization counts ( -stats ) */
+
+void HllStats(void)
+/*******************/
+{
+  if (Options.hll_optimize)
+    printf("hllopt: %u jumps removed, %u inverted, %u threaded\n", cntJmpRemoved, cntJmpInverted, cntJmpThreaded);
+}
+
 /* .IF, .WHILE, .REPEAT or .FOR directive */
 
 ret_code HllStartDir(int i, struct asm_tok tokenarray[])
@@ -1816,8 +2144,7 @@ ret_code HllStartDir(int i, struct asm_tok tokenarray[])
   if (ModuleInfo.list)
     LstWrite(LSTTYPE_DIRECTIVE, GetCurrOffset(), NULL);
 
-  if (is_linequeue_populated()) /* might be NULL! (".if 1") */
-    RunLineQueue();
+  RunHllLines(); /* line queue might be empty! (".if 1") */
 
   return(rc);
 }
@@ -2850,8 +3177,7 @@ ret_code HllEndDir(int i, struct asm_tok tokenarray[])
       LstWrite(LSTTYPE_DIRECTIVE, GetCurrOffset(), NULL);
     
   /* v2.11: always run line-queue if it's not empty. */
-  if (is_linequeue_populated())
-    RunLineQueue();
+  RunHllLines();
 
   return(rc);
 }
@@ -3145,8 +3471,7 @@ ret_code HllExitDir(int i, struct asm_tok tokenarray[])
     LstWrite(LSTTYPE_DIRECTIVE, GetCurrOffset(), NULL);
 
   /* v2.11: always run line-queue if it's not empty. */
-  if (is_linequeue_populated())
-    RunLineQueue();
+  RunHllLines();
 
   return(rc);
 }
@@ -3189,6 +3514,29 @@ void HllInit(int pass)
 
   //HllStack = NULL; /* empty stack of open hll directives */
   ModuleInfo.hll_label = 0; /* init hll label counter */
+  /* v2.52: -hllopt, the label targets of the last pass become the previous ones */
+  if (pass == PASS_1) {
+    MemFree(jmpalias);
+    MemFree(prevalias);
+    jmpalias = NULL;
+    jmpaliascnt = 0;
+    prevalias = NULL;
+    prevaliascnt = 0;
+  } else {
+    uint_32 *p = prevalias;
+    uint_32 cnt = prevaliascnt;
+    prevalias = jmpalias;
+    prevaliascnt = jmpaliascnt;
+    jmpalias = p;
+    jmpaliascnt = cnt;
+    if (jmpalias)
+      memset(jmpalias, 0, jmpaliascnt * sizeof(uint_32));
+  }
+  for (; hlinecnt; hlinecnt--)
+    MemFree(hlines[hlinecnt - 1].text);
+  cntJmpRemoved = 0;
+  cntJmpInverted = 0;
+  cntJmpThreaded = 0;
 #ifdef DEBUG_OUT
   evallvl = 0;
   if (pass == PASS_1) {
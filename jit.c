@@ -0,0 +1,443 @@
+/****************************************************************************
+*
+*  This code is Public Domain.
+*
+*  ========================================================================
+*
+* Description:  JIT mode of the library interface ( see H/libuasm.h ).
+*               The module is assembled with the -bin rules. Instead of
+*               writing a file, the segments are placed in memory of the
+*               running process: code segments first, the other segments
+*               start on a new page. The fixups are resolved like in
+*               bin.c, but with the final addresses; externals are
+*               resolved by a callback. Calls and jumps to externals out
+*               of rel32 range go through stubs behind the code. Finally
+*               the code pages are made read/execute.
+*
+****************************************************************************/
+
+#include <stddef.h>
+
+#include "globals.h"
+#include "memalloc.h"
+#include "parser.h"
+#include "fixup.h"
+#include "jit.h"
+#include "libuasm.h"
+
+#if defined(__UNIX__)
+#include <unistd.h>
+#include <sys/mman.h>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOGDI    /* wingdi.h defines ERROR */
+#include <windows.h>
+#endif
+
+#define STUBSIZE 16 /* jmp qword ptr [rip+0] ( 6 bytes ), followed by the address */
+
+/* externals, indexed by sym.ext_idx */
+struct jit_ext {
+    uint_64 address;
+    uint_8  *stub;    /* stub, NULL if not written yet */
+};
+
+static struct jit_info *jit;
+
+static uint_32 GetPageSize( void )
+/********************************/
+{
+#if defined(__UNIX__)
+    return( sysconf( _SC_PAGESIZE ) );
+#elif defined(_WIN32)
+    SYSTEM_INFO si;
+    GetSystemInfo( &si );
+    return( si.dwPageSize );
+#else
+    return( 0x1000 );
+#endif
+}
+
+static uint_8 *AllocImage( uint_32 size )
+/***************************************/
+{
+#if defined(__UNIX__)
+    void *p = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    return( p == MAP_FAILED ? NULL : p );
+#elif defined(_WIN32)
+    return( VirtualAlloc( NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE ) );
+#else
+    return( NULL );
+#endif
+}
+
+static void FreeImage( void *base, size_t size )
+/**********************************************/
+{
+#if defined(__UNIX__)
+    munmap( base, size );
+#elif defined(_WIN32)
+    VirtualFree( base, 0, MEM_RELEASE );
+#endif
+}
+
+/* make code pages read/execute */
+
+static bool ProtectCode( uint_8 *base, uint_32 size )
+/***************************************************/
+{
+#if defined(__UNIX__)
+    return( mprotect( base, size, PROT_READ | PROT_EXEC ) == 0 );
+#elif defined(_WIN32)
+    DWORD old;
+    if ( VirtualProtect( base, size, PAGE_EXECUTE_READ, &old ) == 0 )
+        return( FALSE );
+    FlushInstructionCache( GetCurrentProcess(), base, size );
+    return( TRUE );
+#else
+    return( FALSE );
+#endif
+}
+
+/* address of a segment's location 0 */
+
+static uint_64 SegAddr( uint_8 *base, struct dsym *seg )
+/******************************************************/
+{
+    if ( seg->e.seginfo->segtype == SEGTYPE_ABS )
+        return( seg->e.seginfo->abs_frame << 4 );
+    return( (uint_64)(size_t)base + seg->e.seginfo->fileoffset - seg->e.seginfo->start_loc );
+}
+
+/* set image offsets ( fileoffset ) of the segments.
+ * returns size of image; code segments, followed by the stubs,
+ * are in the first <codesize> bytes.
+ */
+
+static uint_32 jit_layout( uint_32 numext, uint_32 *stubofs, uint_32 *codesize )
+/******************************************************************************/
+{
+    struct dsym *curr;
+    uint_32 offset = 0;
+    uint_32 align;
+    uint_32 pagesize = GetPageSize();
+    int code;
+
+    for ( code = 1; code >= 0; code-- ) {
+        for( curr = SymTables[TAB_SEG].head; curr; curr = curr->next ) {
+            if ( curr->e.seginfo->segtype == SEGTYPE_ABS || curr->e.seginfo->info ||
+                ( curr->e.seginfo->segtype == SEGTYPE_CODE ) != code )
+                continue;
+            align = 1 << curr->e.seginfo->alignment;
+            offset = ( offset + ( align - 1 ) ) & ( -align );
+            curr->e.seginfo->fileoffset = offset;
+            offset += curr->sym.max_offset - curr->e.seginfo->start_loc;
+            DebugMsg(("jit_layout(%s): ofs=%" I32_SPEC "Xh size=%" I32_SPEC "Xh\n",
+                      curr->sym.name, curr->e.seginfo->fileoffset, curr->sym.max_offset - curr->e.seginfo->start_loc ));
+        }
+        if ( code ) {
+            offset = ( offset + ( STUBSIZE - 1 ) ) & ~( STUBSIZE - 1 );
+            *stubofs = offset;
+            offset += numext * STUBSIZE;
+            offset = ( offset + ( pagesize - 1 ) ) & ~( pagesize - 1 );
+            *codesize = offset;
+        }
+    }
+    return( offset );
+}
+
+/* is the rel32 fixup the displacement of a CALL, JMP or Jcc? */
+
+static bool IsBranch( struct dsym *curr, struct fixup *fixup, uint_8 *codeptr )
+/*****************************************************************************/
+{
+    uint_32 idx = fixup->locofs - curr->e.seginfo->start_loc;
+
+#if AMD64_SUPPORT
+    if ( curr->e.seginfo->Ofssize == USE64 && fixup->addbytes != 4 )
+        return( FALSE );
+#endif
+    if ( idx >= 1 && ( *(codeptr-1) == 0xE8 || *(codeptr-1) == 0xE9 ) )
+        return( TRUE );
+    if ( idx >= 2 && *(codeptr-2) == 0x0F && ( *(codeptr-1) & 0xF0 ) == 0x80 )
+        return( TRUE );
+    return( FALSE );
+}
+
+/* get stub of an external; jmp qword ptr [rip+0] */
+
+static uint_8 *GetStub( struct jit_ext *ext, uint_8 *stub )
+/*********************************************************/
+{
+    if ( ext->stub == NULL ) {
+        ext->stub = stub;
+        stub[0] = 0xFF;
+        stub[1] = 0x25;
+        memset( stub + 2, 0, 4 );
+        memcpy( stub + 6, &ext->address, sizeof( uint_64 ) );
+    }
+    return( ext->stub );
+}
+
+/* handle the fixups contained in a segment */
+
+static void jit_fixups( struct dsym *curr, uint_8 *base, uint_8 *stubs, struct jit_ext *exts )
+/********************************************************************************************/
+{
+    union {
+        uint_8  *db;
+        uint_16 *dw;
+        uint_32 *dd;
+        uint_64 *dq;
+    } codeptr;
+    struct dsym *seg;
+    struct fixup *fixup;
+    struct jit_ext *ext;
+    uint_64 value; /* target address */
+    uint_64 loc;   /* address of fixup location */
+    uint_64 end;   /* end of instruction for relative fixups */
+    uint_32 offset;
+    int_64 diff;
+
+    for ( fixup = curr->e.seginfo->FixupList.head; fixup; fixup = fixup->nextrlc ) {
+        codeptr.db = base + curr->e.seginfo->fileoffset + ( fixup->locofs - curr->e.seginfo->start_loc );
+        loc = SegAddr( base, curr ) + fixup->locofs;
+        seg = NULL;
+        ext = NULL;
+        offset = 0;
+        if ( fixup->sym && fixup->sym->state == SYM_EXTERNAL ) {
+            ext = &exts[fixup->sym->ext_idx];
+            value = ext->address + fixup->offset;
+        } else if ( fixup->sym && ( fixup->sym->segment || fixup->sym->variable ) ) {
+            /* assembly time variable (also $ symbol) in reloc? */
+            if ( fixup->sym->variable ) {
+                seg = (struct dsym *)fixup->segment_var;
+            } else {
+                seg = (struct dsym *)fixup->sym->segment;
+                offset = fixup->sym->offset;
+            }
+            value = SegAddr( base, seg ) + fixup->offset + offset;
+        } else
+            value = 0;
+
+        switch ( fixup->type ) {
+        case FIX_RELOFF8:
+            diff = (int_8)*codeptr.db + (int_64)( value - ( loc + 1 ) );
+            *codeptr.db = diff;
+            if ( diff != (int_8)diff )
+                break;
+            continue;
+        case FIX_RELOFF16:
+            diff = (int_16)*codeptr.dw + (int_64)( value - ( loc + 2 ) );
+            *codeptr.dw = diff;
+            if ( diff != (int_16)diff )
+                break;
+            continue;
+        case FIX_RELOFF32:
+            end = loc + 4;
+#if AMD64_SUPPORT
+            /* for EIP-related offsets in USE64, the instruction may continue */
+            if ( curr->e.seginfo->Ofssize == USE64 )
+                end = loc + fixup->addbytes;
+#endif
+            diff = (int_32)*codeptr.dd + (int_64)( value - end );
+            if ( diff != (int_32)diff && ext && fixup->offset == 0 && IsBranch( curr, fixup, codeptr.db ) ) {
+                DebugMsg(("jit_fixups(%s, %04" I32_SPEC "X): stub for %s\n", curr->sym.name, fixup->locofs, fixup->sym->name ));
+                value = (uint_64)(size_t)GetStub( ext, stubs + fixup->sym->ext_idx * STUBSIZE );
+                diff = (int_32)*codeptr.dd + (int_64)( value - end );
+            }
+            *codeptr.dd = diff;
+            if ( diff != (int_32)diff )
+                break;
+            continue;
+        case FIX_OFF8:
+            *codeptr.db = value & 0xff;
+            continue;
+        case FIX_OFF16:
+            *codeptr.dw = value & 0xffff;
+            continue;
+        case FIX_HIBYTE:
+            *codeptr.db = (value >> 8) & 0xff;
+            continue;
+        case FIX_OFF32:
+            *codeptr.dd = value;
+            /* in 64-bit code, a 32-bit address is sign-extended */
+            if ( curr->e.seginfo->Ofssize == USE64 ? ( (int_64)value != (int_32)value ) : ( value > 0xFFFFFFFF ) )
+                break;
+            continue;
+        case FIX_OFF32_IMGREL:
+            *codeptr.dd = value - (uint_64)(size_t)base;
+            continue;
+        case FIX_OFF32_SECREL:
+            if ( seg )
+                *codeptr.dd = ( fixup->offset + offset ) - seg->e.seginfo->start_loc;
+            continue;
+#if AMD64_SUPPORT
+        case FIX_OFF64:
+            *codeptr.dq = value;
+            continue;
+#endif
+        default:
+            DebugMsg(("jit_fixups(%s, %04" I32_SPEC "X): invalid fixup %u\n", curr->sym.name, fixup->locofs, fixup->type ));
+            EmitErr( INVALID_FIXUP_TYPE, ModuleInfo.fmtopt->formatname, fixup->type, curr->sym.name, fixup->locofs );
+            continue;
+        }
+        DebugMsg(("jit_fixups(%s, %04" I32_SPEC "X): target %" I64_SPEC "Xh out of range\n", curr->sym.name, fixup->locofs, value ));
+        EmitErr( JIT_TARGET_OUT_OF_RANGE, fixup->sym ? fixup->sym->name : "", curr->sym.name, fixup->locofs );
+    }
+}
+
+static int compare_syms( const void *p1, const void *p2 )
+/*******************************************************/
+{
+    return( strcmp( ((struct uasm_symbol *)p1)->name, ((struct uasm_symbol *)p2)->name ) );
+}
+
+/* create the symbol table of the image: labels, procedures and
+ * data items. The table and the names are in one malloc'd block.
+ */
+
+static ret_code jit_symbols( struct uasm_image *image, uint_8 *base )
+/*******************************************************************/
+{
+    struct asym *sym;
+    struct uasm_symbol *table;
+    char *names;
+    size_t cnt = 0;
+    size_t size = 0;
+    int i;
+
+#define IS_LABEL( sym ) ( sym->state == SYM_INTERNAL && sym->segment && sym->isequate == FALSE && sym->predefined == FALSE )
+
+    for ( sym = NULL, i = 0; sym = SymEnum( sym, &i ); )
+        if ( IS_LABEL( sym ) ) {
+            cnt++;
+            size += sym->name_size + 1;
+        }
+    if ( cnt == 0 )
+        return( NOT_ERROR );
+    table = malloc( cnt * sizeof( struct uasm_symbol ) + size );
+    if ( table == NULL )
+        return( EmitError( OUT_OF_MEMORY ) );
+    names = (char *)( table + cnt );
+    image->symbols = table;
+    image->num_symbols = cnt;
+    for ( sym = NULL, i = 0; sym = SymEnum( sym, &i ); )
+        if ( IS_LABEL( sym ) ) {
+            memcpy( names, sym->name, sym->name_size + 1 );
+            table->name = names;
+            table->address = (void *)(size_t)( SegAddr( base, (struct dsym *)sym->segment ) + sym->offset );
+            names += sym->name_size + 1;
+            table++;
+        }
+    qsort( image->symbols, cnt, sizeof( struct uasm_symbol ), compare_syms );
+    return( NOT_ERROR );
+}
+
+/* "write" the module: copy it to memory and resolve the fixups */
+
+static ret_code jit_write_module( struct module_info *modinfo )
+/*************************************************************/
+{
+    struct dsym *curr;
+    struct jit_ext *exts = NULL;
+    struct uasm_image *image = jit->image;
+    uint_32 numext = 0;
+    uint_32 stubofs;
+    uint_32 codesize;
+    uint_32 size;
+    uint_8 *base;
+
+    DebugMsg(("jit_write_module: enter\n" ));
+
+    for( curr = SymTables[TAB_EXT].head; curr; curr = curr->next )
+        curr->sym.ext_idx = numext++;
+
+    size = jit_layout( numext, &stubofs, &codesize );
+    image->size = size;
+    if ( size == 0 )
+        return( NOT_ERROR );
+
+    if ( jit->memory ) {
+        if ( jit->memsize < size || ( (size_t)jit->memory & ( GetPageSize() - 1 ) ) )
+            return( EmitErr( JIT_MEMORY_ERROR, size, "too small or not page-aligned" ) );
+        base = jit->memory;
+    } else if ( ( base = AllocImage( size ) ) == NULL )
+        return( EmitErr( JIT_MEMORY_ERROR, size, ErrnoStr() ) );
+    memset( base, 0, size );
+
+    for( curr = SymTables[TAB_SEG].head; curr; curr = curr->next ) {
+        if ( curr->e.seginfo->segtype == SEGTYPE_ABS || curr->e.seginfo->info || curr->e.seginfo->CodeBuffer == NULL )
+            continue;
+        memcpy( base + curr->e.seginfo->fileoffset, curr->e.seginfo->CodeBuffer, curr->sym.max_offset - curr->e.seginfo->start_loc );
+    }
+
+    /* resolve the externals that are used */
+    if ( numext ) {
+        exts = LclAlloc( numext * sizeof( struct jit_ext ) );
+        for( curr = SymTables[TAB_EXT].head; curr; curr = curr->next ) {
+            struct jit_ext *ext = &exts[curr->sym.ext_idx];
+            ext->stub = NULL;
+            ext->address = 0;
+            if ( curr->sym.used ) {
+                if ( jit->resolver )
+                    ext->address = (uint_64)(size_t)jit->resolver( jit->user, curr->sym.name );
+                DebugMsg(("jit_write_module: extern %s=%" I64_SPEC "Xh\n", curr->sym.name, ext->address ));
+                if ( ext->address == 0 )
+                    EmitErr( SYMBOL_NOT_DEFINED, curr->sym.name );
+            }
+        }
+    }
+
+    if ( modinfo->g.error_count == 0 )
+        for( curr = SymTables[TAB_SEG].head; curr; curr = curr->next )
+            if ( curr->e.seginfo->segtype != SEGTYPE_ABS )
+                jit_fixups( curr, base, base + stubofs, exts );
+    if ( exts )
+        LclFree( exts );
+
+    if ( modinfo->g.error_count == 0 && codesize && ProtectCode( base, codesize ) == FALSE )
+        EmitErr( JIT_MEMORY_ERROR, size, ErrnoStr() );
+    if ( modinfo->g.error_count == 0 )
+        jit_symbols( image, base );
+    if ( modinfo->g.error_count ) {
+        if ( jit->memory == NULL )
+            FreeImage( base, size );
+        return( ERROR );
+    }
+    image->base = base;
+    image->code_size = codesize;
+    image->mapped = ( jit->memory == NULL );
+    DebugMsg(("jit_write_module: exit, base=%p size=%" I32_SPEC "Xh code=%" I32_SPEC "Xh\n", base, size, codesize ));
+    return( NOT_ERROR );
+}
+
+/* free the symbol table and the memory, if allocated by JIT */
+
+void JitFree( struct uasm_image *image )
+/**************************************/
+{
+    free( image->symbols );
+    if ( image->mapped )
+        FreeImage( image->base, image->size );
+    memset( image, 0, sizeof( struct uasm_image ) );
+}
+
+void JitSetParams( struct jit_info *info )
+/****************************************/
+{
+    jit = info;
+}
+
+/* called by bin_init(). In JIT mode, the module isn't written
+ * and externals are allowed.
+ */
+bool jit_init( struct module_info *modinfo )
+/******************************************/
+{
+    if ( jit == NULL )
+        return( FALSE );
+    modinfo->g.WriteModule = jit_write_module;
+    modinfo->g.Pass1Checks = NULL;
+    return( TRUE );
+}
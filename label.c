@@ -37,6 +37,7 @@
 #include "types.h"
 #include "label.h"
 #include "listing.h"
+#include "mca.h"
 
 /* LABELARRAY: syntax extension to LABEL directive:
  *  <label> LABEL <qualified type>[: index]
@@ -195,6 +196,9 @@ struct asym *CreateLabel( const char *name, enum memtype mem_type, struct qualif
 #endif
         ModuleInfo.PhaseError = TRUE;
     }
+    /* v2.52: a code label starts a new basic block for -Sc */
+    if ( Options.mca_cpu && CurrProc && ( mem_type & MT_SPECIAL_MASK ) == MT_ADDRESS )
+        McaLabel();
     BackPatch( sym );
     return( sym );
 }
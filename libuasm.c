@@ -0,0 +1,279 @@
+/****************************************************************************
+*
+*  This code is Public Domain.
+*
+*  ========================================================================
+*
+* Description:  library interface ( see H/libuasm.h ).
+*               The assembler keeps its state in globals, which are
+*               initialized for each module by AssembleModule(). A
+*               context stores the global options ( and the few module
+*               fields set by cmdline options ) after parsing; they are
+*               installed for each assembly and reset afterwards. So
+*               contexts are independent, but assemblies are serialized.
+*               Source and output files are memory files with name "-",
+*               see memfile.c. For JIT mode, see jit.c.
+*
+****************************************************************************/
+
+#include "globals.h"
+#include "memalloc.h"
+#include "cmdline.h"
+#include "memfile.h"
+#include "codegenv2.h"
+#include "jit.h"
+#include "libuasm.h"
+
+#include <setjmp.h>
+
+#if defined(__UNIX__)
+#include <pthread.h>
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK()   pthread_mutex_lock( &lock )
+#define UNLOCK() pthread_mutex_unlock( &lock )
+#elif defined(_WIN32)
+#include <windows.h>
+static SRWLOCK lock = SRWLOCK_INIT;
+#define LOCK()   AcquireSRWLockExclusive( &lock )
+#define UNLOCK() ReleaseSRWLockExclusive( &lock )
+#else
+#define LOCK()
+#define UNLOCK()
+#endif
+
+extern char banner_printed;
+extern char library_mode;
+extern jmp_buf jmpenv;
+
+struct uasm_ctx {
+    struct global_options options;
+    struct module_info    modinfo;  /* fields set by cmdline options */
+    unsigned char         arch;
+};
+
+static bool initialized;
+static struct global_options dflt_options;
+static struct module_info    dflt_modinfo;
+static unsigned char         dflt_arch;
+static char                  stdio_name[] = "-";
+
+/* save default state and build the tables needed once only */
+
+static void LibInit( void )
+/*************************/
+{
+    if ( initialized == FALSE ) {
+        initialized = TRUE;
+        dflt_options = Options;
+        dflt_modinfo = ModuleInfo;
+        dflt_arch = MODULEARCH;
+        BuildInstructionTable();
+    }
+}
+
+static void SetDefaults( void )
+/*****************************/
+{
+    Options = dflt_options;
+    ModuleInfo = dflt_modinfo;
+    MODULEARCH = dflt_arch;
+}
+
+UASMAPI struct uasm_ctx *UasmCreate( const char *options )
+/********************************************************/
+{
+    struct uasm_ctx *ctx;
+    const char *cmdline[2];
+    int cnt = 0;
+    char *name;
+
+    LOCK();
+    LibInit();
+    SetDefaults();
+    banner_printed = TRUE;
+    Options.no_error_disp = TRUE;
+
+    cmdline[0] = ( options ? options : "" );
+    cmdline[1] = NULL;
+    /* a fatal error ( out of memory ) must not exit(); Fatal() jumps back here */
+    library_mode = TRUE;
+    if ( setjmp( jmpenv ) ) {
+        DebugMsg(("UasmCreate(%s): fatal error\n", cmdline[0] ));
+        library_mode = FALSE;
+        CmdlineFini();
+        SetDefaults();
+        UNLOCK();
+        return( NULL );
+    }
+    name = ParseCmdline( cmdline, &cnt );
+    /* invalid options are warnings; a context is created for valid options only */
+    if ( name || ModuleInfo.g.error_count || ModuleInfo.g.warning_count ) {
+        DebugMsg(("UasmCreate(%s): invalid options\n", cmdline[0] ));
+        library_mode = FALSE;
+        CmdlineFini();
+        SetDefaults();
+        UNLOCK();
+        return( NULL );
+    }
+    ctx = MemAlloc( sizeof( struct uasm_ctx ) );
+    library_mode = FALSE;
+    ctx->options = Options;
+    ctx->options.no_error_disp = dflt_options.no_error_disp;
+    ctx->modinfo = ModuleInfo;
+    ctx->arch = MODULEARCH;
+    /* the option's names and queues are owned by the context now */
+    SetDefaults();
+    UNLOCK();
+    return( ctx );
+}
+
+/* move contents of a memory file to a malloc'd buffer and close the file */
+
+static void *GetContents( FILE *file, size_t *psize )
+/***************************************************/
+{
+    char *p = NULL;
+    long size;
+
+    fseek( file, 0, SEEK_END );
+    size = ftell( file );
+    *psize = 0;
+    if ( size > 0 && ( p = malloc( size + 1 ) ) ) {
+        rewind( file );
+        *psize = fread( p, 1, size, file );
+        p[*psize] = NULLC;
+    }
+    MemFileClose( file, NULL );
+    return( p );
+}
+
+/* assemble a source; if jit isn't NULL, in JIT mode */
+
+static int Assemble( struct uasm_ctx *ctx, const char *source, size_t size, struct uasm_result *result, struct jit_info *jit )
+/***************************************************************************************************************************/
+{
+    int rc;
+    int i;
+    FILE *files[NUM_FILE_TYPES];
+
+    memset( result, 0, sizeof( struct uasm_result ) );
+
+    LOCK();
+    Options = ctx->options;
+    ModuleInfo = ctx->modinfo;
+    MODULEARCH = ctx->arch;
+    /* all files are "-"; nothing is displayed */
+    Options.names[OBJ] = Options.names[LST] = Options.names[ERR] = stdio_name;
+    Options.quiet = TRUE;
+    Options.no_error_disp = TRUE;
+    banner_printed = TRUE;
+    if ( jit ) {
+        Options.output_format = OFORMAT_BIN;
+        Options.sub_format = SFORMAT_NONE;
+    }
+
+    for ( i = 0; i < NUM_FILE_TYPES; i++ ) {
+        files[i] = MemFileOpen( NULL );
+        if ( files[i] == NULL ) {
+            for ( ; i; i-- )
+                MemFileClose( files[i-1], NULL );
+            SetDefaults();
+            UNLOCK();
+            return( 0 );
+        }
+        MemFileSetStream( i, files[i] );
+    }
+    if ( size )
+        fwrite( source, 1, size, files[ASM] );
+    rewind( files[ASM] );
+
+    JitSetParams( jit );
+    rc = AssembleModule( stdio_name );
+    JitSetParams( NULL );
+
+    result->errors = ModuleInfo.g.error_count;
+    result->warnings = ModuleInfo.g.warning_count;
+    for ( i = 0; i < NUM_FILE_TYPES; i++ )
+        MemFileSetStream( i, NULL );
+    MemFileClose( files[ASM], NULL );
+    result->object = GetContents( files[OBJ], &result->object_size );
+    result->listing = GetContents( files[LST], &result->listing_size );
+    result->messages = GetContents( files[ERR], &result->messages_size );
+
+    SetDefaults();
+    UNLOCK();
+    return( rc );
+}
+
+UASMAPI int UasmAssemble( struct uasm_ctx *ctx, const char *source, size_t size, struct uasm_result *result )
+/*********************************************************************************************************/
+{
+    return( Assemble( ctx, source, size, result, NULL ) );
+}
+
+UASMAPI int UasmJit( struct uasm_ctx *ctx, const char *source, size_t size,
+                    void *memory, size_t memsize, uasm_resolver resolver, void *user,
+                    struct uasm_result *result, struct uasm_image *image )
+/**************************************************************************/
+{
+    struct jit_info jit;
+
+    memset( image, 0, sizeof( struct uasm_image ) );
+    jit.memory = memory;
+    jit.memsize = memsize;
+    jit.resolver = resolver;
+    jit.user = user;
+    jit.image = image;
+    if ( Assemble( ctx, source, size, result, &jit ) && ( image->base || image->size == 0 ) )
+        return( 1 );
+    /* on errors, the image size is kept ( size needed ) */
+    size = image->size;
+    JitFree( image );
+    image->size = size;
+    return( 0 );
+}
+
+static int compare_name( const void *p1, const void *p2 )
+/*******************************************************/
+{
+    return( strcmp( (const char *)p1, ((struct uasm_symbol *)p2)->name ) );
+}
+
+UASMAPI void *UasmSymbol( const struct uasm_image *image, const char *name )
+/**************************************************************************/
+{
+    struct uasm_symbol *sym;
+
+    if ( image->symbols == NULL )
+        return( NULL );
+    sym = bsearch( name, image->symbols, image->num_symbols, sizeof( struct uasm_symbol ), compare_name );
+    return( sym ? sym->address : NULL );
+}
+
+UASMAPI void UasmFreeImage( struct uasm_image *image )
+/****************************************************/
+{
+    JitFree( image );
+}
+
+UASMAPI void UasmFreeResult( struct uasm_result *result )
+/*******************************************************/
+{
+    free( result->object );
+    free( result->listing );
+    free( result->messages );
+    memset( result, 0, sizeof( struct uasm_result ) );
+}
+
+UASMAPI void UasmDestroy( struct uasm_ctx *ctx )
+/**********************************************/
+{
+    if ( ctx == NULL )
+        return;
+    LOCK();
+    Options = ctx->options;
+    CmdlineFini();
+    SetDefaults();
+    MemFree( ctx );
+    UNLOCK();
+}
@@ -24,6 +24,7 @@
 #include "msgtext.h"
 #include "types.h"
 #include "omfspec.h"
+#include "mca.h"
 
 #define CODEBYTES 9
 #define OFSSIZE 8
@@ -144,8 +145,10 @@ void LstWrite(enum lsttype type, uint_32 oldofs, void* value)
     int     len;
     int     i;
     int     len2;
+    int     len3;
     int     idx;
     int     srcfile;
+    const char* pMca;
     char* p1;
     char* p2;
     char* pSrcline;
@@ -204,6 +207,9 @@ void LstWrite(enum lsttype type, uint_32 oldofs, void* value)
         newofs = GetCurrOffset();
         sprintf( ll.buffer, "%08" I32_SPEC "X", oldofs );
         ll.buffer[OFSSIZE] = ' ';
+        /* v2.52: mark instructions rewritten by OPTION OPTIMIZE */
+        if ( ModuleInfo.line_flags & LOF_OPTIMIZED )
+            ll.buffer[OFSSIZE+1] = '~';
 
         if ( CurrSeg == NULL )
             break;
@@ -345,10 +351,24 @@ void LstWrite(enum lsttype type, uint_32 oldofs, void* value)
 
 	fwrite( ll.buffer, 1, idx, CurrFile[LST] );
 
+    /* v2.52: -Sc column between code bytes and source. It has a fixed
+     * width, so it is rewritten in each pass like the code bytes.
+     */
+    len3 = 0;
+    if ( Options.mca_cpu ) {
+#if FASTPASS
+        if ( Parse_Pass > PASS_1 && UseSavedState )
+            fseek( CurrFile[LST], list_pos + sizeof( ll.buffer ), SEEK_SET );
+#endif
+        pMca = McaListText();
+        len3 = strlen( pMca );
+        fwrite( pMca, 1, len3, CurrFile[LST] );
+    }
+
     len = strlen( pSrcline );
     len2 = ( ModuleInfo.CurrComment ? strlen( ModuleInfo.CurrComment ) : 0 );
 
-    list_pos += sizeof( ll.buffer ) + len + len2 + NLSIZ;
+    list_pos += sizeof( ll.buffer ) + len3 + len + len2 + NLSIZ;
     DebugMsg1(("LstWrite: writing (%u b) >%s< [%u/%u], new pos=%" I32_SPEC "u\n", idx, ll.buffer, len, len2, list_pos ));
 
     /* write source and comment part */
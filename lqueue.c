@@ -89,6 +89,23 @@ void AddLineQueue( const char *line )
     return;
 }
 
+/* v2.52: remove the first line of the current line queue and copy it to <buffer>.
+ * returns FALSE if the queue is empty.
+ */
+
+bool PopLineQueue( char *buffer )
+/*******************************/
+{
+    struct lq_line *curr = line_queue.head;
+
+    if ( curr == NULL )
+        return( FALSE );
+    line_queue.head = curr->next;
+    strcpy( buffer, curr->line );
+    MemFree( curr );
+    return( TRUE );
+}
+
 /* Add a line to the current line queue, "printf" format. */
 
 void AddLineQueueX( const char *fmt, ... )
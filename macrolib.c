@@ -225,7 +225,7 @@ void InitAutoMacros64(void)
 	char  *srcLines[512]; // NB: 512 is the max number of lines of macro code per macro.  
 
 	//                    1   2   3   4  5  6  7   8   9   10  11 12 13  14 15 16 17 18 19 20  21 22 23  24  25  26 27 28  29  30  31  32 33  34  35  36  37  38 39 40  41  42 43 44  45  46  47  48  49  50 51  52  53  54 55 56 57 58   59  60 61 62   63   64  65  66 67 68 69
-	uint_32 macroLen[] = {17, 11, 29, 3, 3, 8, 37, 33, 37, 33, 7, 6, 10, 6, 7, 7, 7, 8, 8, 10, 3, 7, 11, 19, 10, 2, 10, 2, 18,  9, 14, 6, 39, 39, 39, 39, 12, 5, 2, 20, 21, 2, 2, 11, 38, 38, 11, 45, 91, 6, 10, 10, 37, 1, 1, 1, 1, 256, 10, 6, 6, 106, 137, 11, 7 , 2, 9, 4, 18 }; // Count of individual lines of macro-body code.
+	uint_32 macroLen[] = {17, 11, 29, 3, 3, 8, 37, 33, 37, 33, 7, 6, 10, 6, 7, 7, 7, 8, 8, 10, 3, 7, 11, 19, 10, 2, 10, 2, 18,  9, 14, 6, 39, 39, 39, 39, 12, 5, 2, 20, 21, 2, 2, 11, 38, 38, 11, 45, 91, 6, 10, 10, 37, 2, 2, 2, 2, 256, 10, 6, 6, 106, 137, 11, 7 , 2, 9, 4, 18 }; // Count of individual lines of macro-body code.
 	char *macCode[] = {
 /*1 NOTMASK128*/		"IFNDEF GMASK",".data","GMASK OWORD 0","ENDIF","IFNDEF NOTMASK",".data","NOTMASK OWORD -1","ENDIF",".code","IF @Arch EQ 1","movups reg, MASK field","pxor reg, NOTMASK","ELSE","vmovups reg, MASK field","vpxor reg, reg, NOTMASK","ENDIF","ENDM",NULL,
 /*2 GETMASK128*/		"IFNDEF GMASK",".data","GMASK OWORD 0","ENDIF",".code","IF @Arch EQ 1","movups reg, MASK field","ELSE","vmovups reg, MASK field","ENDIF","ENDM",NULL,
@@ -280,10 +280,10 @@ void InitAutoMacros64(void)
 /*51 LOADMSS*/ 			".data", "align 4", "vname dd value", ".code", "IF @Arch EQ 0", "movss reg, vname", "ELSE", "vmovss reg, vname", "ENDIF", "ENDM", NULL,
 /*52 LOADMSD*/			".data", "align 8", "bname dq value", ".code", "IF @Arch EQ 0", "movsd reg, bname", "ELSE", "vmovsd reg, bname", "ENDIF", "ENDM", NULL,
 /*53 UINVOKE*/			"IFB <args>", "invoke func", "ELSE", "invoke func, args", "ENDIF", "IF @LastReturnType EQ 0", "EXITM <al>", "ELSEIF @LastReturnType EQ 0x40", "EXITM <al>", "ELSEIF @LastReturnType EQ 1", "EXITM <ax>", "ELSEIF @LastReturnType EQ 0x41", "EXITM <ax>", "ELSEIF @LastReturnType EQ 2", "EXITM <eax>", "ELSEIF @LastReturnType EQ 0x42", "EXITM <eax>", "ELSEIF @LastReturnType EQ 3", "EXITM <rax>", "ELSEIF @LastReturnType EQ 0x43", "EXITM <rax>", "ELSEIF @LastReturnType EQ 0xc3", "EXITM <rax>", "ELSEIF @LastReturnType EQ 6", "EXITM <xmm0>", "ELSEIF @LastReturnType EQ 7", "EXITM <ymm0>", "ELSEIF @LastReturnType EQ 8", "EXITM <zmm0>", "ELSEIF @LastReturnType EQ 0x22", "EXITM <xmm0>", "ELSEIF @LastReturnType EQ 0x23", "EXITM <xmm0>", "ELSE", "EXITM <eax>", "ENDIF", "ENDM", NULL,
-/*54 ASFLOAT*/			"EXITM <REAL4 PTR reg> ", NULL,
-/*55 ASDOUBLE*/			"EXITM <REAL8 PTR reg> ", NULL,
-/*56 R4P*/				"EXITM <REAL4 PTR reg> ", NULL,
-/*57 R8P*/				"EXITM <REAL8 PTR reg> ", NULL,
+/*54 ASFLOAT*/			"EXITM <REAL4 PTR reg> ", "ENDM", NULL,
+/*55 ASDOUBLE*/			"EXITM <REAL8 PTR reg> ", "ENDM", NULL,
+/*56 R4P*/				"EXITM <REAL4 PTR reg> ", "ENDM", NULL,
+/*57 R8P*/				"EXITM <REAL8 PTR reg> ", "ENDM", NULL,
 /*58 arginvoke*/		"LOCAL dstSize, stackPos","REGS15STORAGE","IFB <args>","invoke func","ELSE","IF invCount GE 2","IF argNo EQ 2","mov RRCX,rcx","IF @Arch EQ 0","movaps RXMM0,xmm0","ELSE","vmovaps RXMM0,xmm0","ENDIF","ELSEIF argNo EQ 3","mov RRCX,rcx","mov RRDX,rdx","IF @Arch EQ 0","movaps RXMM0,xmm0","movaps RXMM1,xmm1","ELSE","vmovaps RXMM0,xmm0","vmovaps RXMM1,xmm1","ENDIF","ELSEIF argNo EQ 4","mov RRCX,rcx","mov RRDX,rdx","mov RR8,r8","IF @Arch EQ 0","movaps RXMM0,xmm0","movaps RXMM1,xmm1","movaps RXMM2,xmm2","ELSE","vmovaps RXMM0,xmm0","vmovaps RXMM1,xmm1","vmovaps RXMM2,xmm2","ENDIF","ELSEIF argNo GE 5","mov RRCX,rcx","mov RRDX,rdx","mov RR8,r8","mov RR9,r9","IF @Arch EQ 0","movaps RXMM0,xmm0","movaps RXMM1,xmm1","movaps RXMM2,xmm2","movaps RXMM3,xmm3","ELSE","vmovaps RXMM0,xmm0","vmovaps RXMM1,xmm1","vmovaps RXMM2,xmm2","vmovaps RXMM3,xmm3","ENDIF","ENDIF","ENDIF","invoke func, args", "IF invCount GE 2","IF argNo EQ 2","mov rcx,RRCX","IF @Arch EQ 0","movaps xmm0,RXMM0","ELSE","vmovaps xmm0,RXMM0","ENDIF","ELSEIF argNo EQ 3","mov rcx,RRCX","mov rdx,RRDX","IF @Arch EQ 0","movaps xmm0,RXMM0","movaps xmm1,RXMM1","ELSE","vmovaps xmm0,RXMM0","vmovaps xmm1,RXMM1","ENDIF","ELSEIF argNo EQ 4","mov rcx,RRCX","mov rdx,RRDX","mov r8,RR8","IF @Arch EQ 0","movaps xmm0,RXMM0","movaps xmm1,RXMM1","movaps xmm2,RXMM2","ELSE","vmovaps xmm0,RXMM0","vmovaps xmm1,RXMM1","vmovaps xmm2,RXMM2","ENDIF","ELSEIF argNo GE 5","mov rcx,RRCX","mov rdx,RRDX","mov r8,RR8","mov r9,RR9","IF @Arch EQ 0","movaps xmm0,RXMM0","movaps xmm1,RXMM1","movaps xmm2,RXMM2","movaps xmm3,RXMM3","ELSE","vmovaps xmm0,RXMM0","vmovaps xmm1,RXMM1","vmovaps xmm2,RXMM2","vmovaps xmm3,RXMM3","ENDIF","ENDIF","ENDIF","ENDIF","IF @LastReturnType EQ 0","dstSize = 1","ELSEIF @LastReturnType EQ 0x40","dstSize = 1","ELSEIF @LastReturnType EQ 1","dstSize = 2","ELSEIF @LastReturnType EQ 0x41","dstSize = 2","ELSEIF @LastReturnType EQ 2","dstSize = 4","ELSEIF @LastReturnType EQ 0x42","dstSize = 4","ELSEIF @LastReturnType EQ 3","dstSize = 8","ELSEIF @LastReturnType EQ 0x43","dstSize = 8","ELSEIF @LastReturnType EQ 0xc3","dstSize = 8","ELSEIF @LastReturnType EQ 6","dstSize = 16","ELSEIF @LastReturnType EQ 7","dstSize = 32","ELSEIF @LastReturnType EQ 8","dstSize = 64","ELSEIF @LastReturnType EQ 0x22","dstSize = 16","ELSEIF @LastReturnType EQ 0x23","dstSize = 16","ELSE","dstSize = 4","ENDIF","IF argNo EQ 1","IF dstSize EQ 1","mov cl,al","EXITM<cl>","ELSEIF dstSize EQ 2","mov cx,ax","EXITM<cx>","ELSEIF dstSize EQ 4","mov ecx,eax","EXITM<ecx>","ELSEIF dstSize EQ 8","mov rcx,rax","EXITM<rcx>","ELSEIF dstSize EQ 16","EXITM<xmm0>","ELSEIF dstSize EQ 32","EXITM<ymm0>","ELSEIF dstSize EQ 64","EXITM<zmm0>","ENDIF","ELSEIF argNo EQ 2","IF dstSize EQ 1","mov dl,al","EXITM<dl>","ELSEIF dstSize EQ 2","mov dx,ax","EXITM<dx>","ELSEIF dstSize EQ 4","mov edx,eax","EXITM<edx>","ELSEIF dstSize EQ 8","mov rdx,rax","EXITM<rdx>","ELSEIF dstSize EQ 16","IF @Arch EQ 0","movdqa xmm1,xmm0","ELSE","vmovdqa xmm1,xmm0","ENDIF","EXITM<xmm1>","ELSEIF dstSize EQ 32","vmovdqa ymm1,ymm0","EXITM<ymm1>","ELSEIF dstSize EQ 64","vmovdqa zmm1,zmm0","EXITM<zmm1>","ENDIF","ELSEIF argNo EQ 3","IF dstSize EQ 1","mov r8b,al","EXITM<r8b>","ELSEIF dstSize EQ 2","mov r8w,ax","EXITM<r8w>","ELSEIF dstSize EQ 4","mov r8d,eax","EXITM<r8d>","ELSEIF dstSize EQ 8","mov r8,rax","EXITM<r8>","ELSEIF dstSize EQ 16","IF @Arch EQ 0","movdqa xmm2,xmm0","ELSE","vmovdqa xmm2,xmm0","ENDIF","EXITM<xmm2>","ELSEIF dstSize EQ 32","vmovdqa ymm2,ymm0","EXITM<ymm2>","ELSEIF dstSize EQ 64","vmovdqa zmm2,zmm0","EXITM<zmm2>","ENDIF","ELSEIF argNo EQ 4","IF dstSize EQ 1","mov r9b,al","EXITM<r9b>","ELSEIF dstSize EQ 2","mov r9w,ax","EXITM<r9w>","ELSEIF dstSize EQ 4","mov r9d,eax","EXITM<r9d>","ELSEIF dstSize EQ 8","mov r9,rax","EXITM<r9>","ELSEIF dstSize EQ 16","IF @Arch EQ 0","movdqa xmm3,xmm0","ELSE","vmovdqa xmm3,xmm0","ENDIF","EXITM<xmm3>","ELSEIF dstSize EQ 32","vmovdqa ymm3,ymm0","EXITM<ymm3>","ELSEIF dstSize EQ 64","vmovdqa zmm3,zmm0","EXITM<zmm3>","ENDIF","ELSE","IF dstSize EQ 1","mov[rsp + 0x20 + ((argNo - 5) * 8)],al","ELSEIF dstSize EQ 2","mov[rsp + 0x20 + ((argNo - 5) * 8)],ax","ELSEIF dstSize EQ 4","mov[rsp + 0x20 + ((argNo - 5) * 8)],eax","ELSEIF dstSize EQ 8","mov[rsp + 0x20 + ((argNo - 5) * 8)],rax","ELSEIF(dstSize EQ 16) OR(dstSize EQ 32) OR(dstSize EQ 64)","IF @Arch EQ 0","movsd[rsp + 0x20 + ((argNo - 5) * 8)],xmm0","ELSE","vmovsd[rsp + 0x20 + ((argNo - 5) * 8)],xmm0","ENDIF","ENDIF","EXITM<[rsp + 0x20 + ((argNo - 5) * 8)]>","ENDIF","ENDM",NULL,
 /*59 COMINTERFACE*/		"curClass TEXTEQU <CName>", "% __&CName&_size = 24", "@CatStr(CName, <vtbl COMSTRUCT >)", "ptrDefS TEXTEQU <psr>", "ptrDefS CATSTR ptrDefS, <&curClass&>, < TYPEDEF PTR >, <&curClass&>","% ptrDefS", "CVIRTUAL QueryInterface, <QWORD>, :PTR", "CVIRTUAL AddRef, <DWORD>", "CVIRTUAL Release, <DWORD>", "ENDM", NULL,
 /*60 ENDCOMINTERFACE*/	"ENDMETHODS", "curClass ENDS", ".data","% _stat&curClass&vtbl &curClass&vtbl <>","% _stat&curClass& curClass <>", "ENDM", NULL,
@@ -310,6 +310,11 @@ void InitAutoMacros64(void)
 		mac = CreateMacro(macName64[i]);
 		ModuleInfo.token_count = Tokenize(macDef64[i], 0, ModuleInfo.tokenarray, 0);
 		StoreAutoMacro(mac, 2, ModuleInfo.tokenarray, TRUE, srcLines, 0, macroLen[i]);
+		/* v2.52: the lines have been copied, release them. Since StoreAutoMacro()
+		 * stops at ENDM only, each macro body must end with it.
+		 */
+		for (j = 0; j < macroLen[i]; j++)
+			free(srcLines[j]);
 		start_pos += macroLen[i] + 1;
 	}
 }
@@ -322,7 +327,7 @@ void InitAutoMacros32(void)
 	uint_32 start_pos = 0;
 	char  *srcLines[128]; // NB: 128 is the max number of lines of macro code per macro.
 
-	uint_32 macroLen[] = {17, 11, 3, 3, 8, 54, 46, 54, 46, 7, 6, 6, 6, 7, 7, 7, 8, 10, 3, 7, 11, 19, 10, 10, 37, 1, 1, 1, 1, 37, 6, 2, 23, 54, 10, 6 }; // Count of individual lines of macro-body code.
+	uint_32 macroLen[] = {17, 11, 3, 3, 8, 54, 46, 54, 46, 7, 6, 6, 6, 7, 7, 7, 8, 10, 3, 7, 11, 19, 10, 10, 37, 2, 2, 2, 2, 37, 6, 2, 23, 54, 10, 6 }; // Count of individual lines of macro-body code.
 	char *macCode[] = {
 		"IFNDEF GMASK",".data","GMASK OWORD 0","ENDIF","IFNDEF NOTMASK",".data","NOTMASK OWORD -1","ENDIF",".code","IF @Arch EQ 1","movups reg, MASK field","pxor reg, NOTMASK","ELSE","vmovups reg, MASK field","vpxor reg, reg, NOTMASK","ENDIF","ENDM",NULL,
 		"IFNDEF GMASK",".data","GMASK OWORD 0","ENDIF",".code","IF @Arch EQ 1","movups reg, MASK field","ELSE","vmovups reg, MASK field","ENDIF","ENDM",NULL,
@@ -349,10 +354,10 @@ void InitAutoMacros32(void)
 		".data", "align 4", "vname dd value", ".code", "IF @Arch EQ 0", "movss reg, vname", "ELSE", "vmovss reg, vname", "ENDIF", "ENDM", NULL,
 		".data", "align 8", "bname dq value", ".code", "IF @Arch EQ 0", "movsd reg, bname", "ELSE", "vmovsd reg, bname", "ENDIF", "ENDM", NULL,
 		"IFB <args>", "invoke func", "ELSE", "invoke func, args", "ENDIF", "IF @LastReturnType EQ 0", "EXITM <al>", "ELSEIF @LastReturnType EQ 0x40", "EXITM <al>", "ELSEIF @LastReturnType EQ 1", "EXITM <ax>", "ELSEIF @LastReturnType EQ 0x41", "EXITM <ax>", "ELSEIF @LastReturnType EQ 2", "EXITM <eax>", "ELSEIF @LastReturnType EQ 0x42", "EXITM <eax>", "ELSEIF @LastReturnType EQ 3", "EXITM <rax>", "ELSEIF @LastReturnType EQ 0x43", "EXITM <rax>", "ELSEIF @LastReturnType EQ 0xc3", "EXITM <rax>", "ELSEIF @LastReturnType EQ 6", "EXITM <xmm0>", "ELSEIF @LastReturnType EQ 7", "EXITM <ymm0>", "ELSEIF @LastReturnType EQ 8", "EXITM <zmm0>", "ELSEIF @LastReturnType EQ 0x22", "EXITM <xmm0>", "ELSEIF @LastReturnType EQ 0x23", "EXITM <xmm0>", "ELSE", "EXITM <eax>", "ENDIF", "ENDM", NULL,
-		"EXITM <REAL4 PTR reg> ", NULL,
-		"EXITM <REAL8 PTR reg> ", NULL,
-		"EXITM <REAL4 PTR reg> ", NULL,
-		"EXITM <REAL8 PTR reg> ", NULL,
+		"EXITM <REAL4 PTR reg> ", "ENDM", NULL,
+		"EXITM <REAL8 PTR reg> ", "ENDM", NULL,
+		"EXITM <REAL4 PTR reg> ", "ENDM", NULL,
+		"EXITM <REAL8 PTR reg> ", "ENDM", NULL,
 		"arg equ <invoke func>", "FOR var, <args>", "arg CATSTR arg, <, var>", "ENDM", "arg", "IF @LastReturnType EQ 0","EXITM<al>","ELSEIF @LastReturnType EQ 0x40","EXITM<al>","ELSEIF @LastReturnType EQ 1","EXITM<ax>","ELSEIF @LastReturnType EQ 0x41","EXITM<ax>","ELSEIF @LastReturnType EQ 2","EXITM<eax>","ELSEIF @LastReturnType EQ 0x42","EXITM<eax>","ELSEIF @LastReturnType EQ 3","EXITM<rax>","ELSEIF @LastReturnType EQ 0x43","EXITM<rax>","ELSEIF @LastReturnType EQ 0xc3","EXITM<rax>","ELSEIF @LastReturnType EQ 6","EXITM<xmm0>","ELSEIF @LastReturnType EQ 7","EXITM<ymm0>","ELSEIF @LastReturnType EQ 8","EXITM<zmm0>","ELSEIF @LastReturnType EQ 0x22","EXITM<xmm0>","ELSEIF @LastReturnType EQ 0x23","EXITM<xmm0>","ELSE","EXITM<eax>","ENDIF","ENDM",NULL,
 		"curClass TEXTEQU <CName>", "@CatStr(CName, < COMSTRUCT >)", "CVIRTUAL QueryInterface, <>, :PTR", "CVIRTUAL AddRef, <>", "CVIRTUAL Release, <>", "ENDM", NULL,
 		"curClass ENDS", "ENDM", NULL,
@@ -373,6 +378,11 @@ void InitAutoMacros32(void)
 		mac = CreateMacro(macName32[i]);
 		ModuleInfo.token_count = Tokenize(macDef32[i], 0, ModuleInfo.tokenarray, 0);
 		StoreAutoMacro(mac, 2, ModuleInfo.tokenarray, TRUE, srcLines, 0, macroLen[i]);
+		/* v2.52: the lines have been copied, release them. Since StoreAutoMacro()
+		 * stops at ENDM only, each macro body must end with it.
+		 */
+		for (j = 0; j < macroLen[i]; j++)
+			free(srcLines[j]);
 		start_pos += macroLen[i] + 1;
 	}
 }
\ No newline at end of file
@@ -15,6 +15,7 @@
 #include "cmdline.h"
 #include "input.h" /* GetFNamePart() */
 #include "codegenv2.h"
+#include "memfile.h"
 
 #if defined(__UNIX__) || defined(__CYGWIN__) || defined(__DJGPP__)
 
@@ -117,6 +118,10 @@ int main(int argc, char **argv)
 		/* ParseCmdLine() returns NULL if no source file name has been found (anymore) */
 	while (ParseCmdline((const char **)argv, &numArgs)) {
 		numFiles++;
+		/* v2.52: output to stdout ( "-" ); then messages must go to stderr */
+		if ( IS_STDIO_NAME( Options.names[OPTN_OBJ_FN] ) || IS_STDIO_NAME( Options.names[OPTN_LST_FN] ) ||
+			IS_STDIO_NAME( Options.names[OPTN_ERR_FN] ) )
+			MemFileStdout();
 		write_logo();
 #if WILDCARDS
 
@@ -0,0 +1,990 @@
+/****************************************************************************
+*
+*  This code is Public Domain.
+*
+*  ========================================================================
+*
+* Description:  static throughput/latency analysis ( -Sc option ).
+*               Every instruction inside a PROC is mapped to an entry of
+*               an embedded per-CPU table. The estimate is appended to the
+*               instruction's listing line; a summary per basic block is
+*               written at the end of the listing.
+*
+*               The numbers are estimates in the spirit of llvm-mca/IACA:
+*               no caches, no branch mispredictions, no memory dependencies.
+*
+****************************************************************************/
+
+#include <string.h>
+
+#include "globals.h"
+#include "memalloc.h"
+#include "parser.h"
+#include "reswords.h"
+#include "expreval.h"
+#include "segment.h"
+#include "proc.h"
+#include "listing.h"
+#include "mca.h"
+
+#define MAXPORTS  12
+#define NUMKEYS   65   /* 16 GPRs, 32 SIMD, 8 MMX, 8 mask registers, flags */
+#define KEY_SIMD  16
+#define KEY_MMX   48
+#define KEY_MASK  56
+#define KEY_FLAGS 64
+
+#define P(x) ( 1 << (x) )
+
+/* unit of port pressure; divisible by the number of ports of a group */
+#define CYCLE 1200
+#define HUNDREDTHS( x ) ( ( (x) % CYCLE ) / ( CYCLE / 100 ) )
+
+/* "[reg]" is an EXPR_REG with the indirect flag set */
+#define IS_REGOPND( x ) ( (x).kind == EXPR_REG && (x).indirect == FALSE )
+#define IS_MEMOPND( x ) ( (x).kind == EXPR_ADDR || ( (x).kind == EXPR_REG && (x).indirect ) )
+
+/* instruction classes; index into the model's table */
+enum mca_class {
+    MC_ALU, MC_ADC, MC_SHIFT, MC_SHIFTCL, MC_IMUL, MC_MUL, MC_DIV32, MC_DIV64,
+    MC_LEA, MC_MOV, MC_PUSH, MC_POP, MC_JMP, MC_JCC, MC_CALL, MC_RET,
+    MC_CMOV, MC_SETCC, MC_BITSCAN, MC_XCHG, MC_NOP, MC_BSWAP,
+    MC_VMOV, MC_VLOGIC, MC_VIADD, MC_VIMUL, MC_VSHUF, MC_VSHIFT,
+    MC_FADD, MC_FMUL, MC_FMA, MC_FDIV, MC_FDIVD, MC_FSQRT, MC_FCVT, MC_FCMP,
+    MC_OTHER, MC_VOTHER,
+    MC_LAST
+};
+
+/* flags returned by GetClass() */
+#define MF_NODSTW  0x01 /* first operand isn't written */
+#define MF_NODSTR  0x02 /* first operand isn't read */
+#define MF_RFLAGS  0x04
+#define MF_WFLAGS  0x08
+#define MF_RAXRDX  0x10 /* implicit accumulator/rdx operands */
+#define MF_ZERO    0x20 /* zero idiom if all operands are the same register */
+#define MF_END     0x40 /* ends a basic block */
+#define MF_UNK     0x80 /* no table entry, defaults are used */
+
+struct mca_entry {
+    uint_8  uops;   /* uops of first group */
+    uint_16 ports;  /* ports the first group may use */
+    uint_8  uops2;  /* uops of second group */
+    uint_16 ports2;
+    uint_8  lat;    /* latency in cycles */
+    uint_16 busy;   /* cycles*100 a non-pipelined unit is blocked, 0=pipelined */
+};
+
+struct mca_model {
+    const char *id;        /* -Sc argument */
+    const char *alias;
+    const char *name;      /* displayed in listing */
+    const char *portnames; /* 2 chars per port */
+    uint_8  nports;
+    uint_8  width;         /* uops issued per cycle */
+    uint_8  load_lat;
+    uint_8  vload_lat;
+    uint_16 load_ports;
+    uint_16 sta_ports;     /* store address */
+    uint_16 std_ports;     /* store data */
+    uint_8  zmm_fused;     /* 512-bit ops fuse p0+p1 ( else not supported ) */
+    const struct mca_entry *table;
+};
+
+/* Skylake client */
+#define P0156 ( P(0) | P(1) | P(5) | P(6) )
+#define P06   ( P(0) | P(6) )
+#define P01   ( P(0) | P(1) )
+#define P015  ( P(0) | P(1) | P(5) )
+#define P15   ( P(1) | P(5) )
+
+static const struct mca_entry skl_table[MC_LAST] = {
+    { 1, P0156, 0, 0,      1, 0    }, /* ALU */
+    { 1, P06,   0, 0,      1, 0    }, /* ADC */
+    { 1, P06,   0, 0,      1, 0    }, /* SHIFT */
+    { 3, P06,   0, 0,      2, 0    }, /* SHIFTCL */
+    { 1, P(1),  0, 0,      3, 0    }, /* IMUL */
+    { 1, P(1),  1, P(5),   3, 0    }, /* MUL */
+    { 1, P(0),  9, P0156, 26, 600  }, /* DIV32 */
+    { 1, P(0), 35, P0156, 42, 2400 }, /* DIV64 */
+    { 1, P15,   0, 0,      1, 0    }, /* LEA */
+    { 1, P0156, 0, 0,      1, 0    }, /* MOV */
+    { 0, 0,     0, 0,      0, 0    }, /* PUSH */
+    { 0, 0,     0, 0,      0, 0    }, /* POP */
+    { 1, P(6),  0, 0,      1, 0    }, /* JMP */
+    { 1, P06,   0, 0,      1, 0    }, /* JCC */
+    { 1, P(6),  0, 0,      1, 0    }, /* CALL */
+    { 1, P(6),  0, 0,      1, 0    }, /* RET */
+    { 1, P06,   0, 0,      1, 0    }, /* CMOV */
+    { 1, P06,   0, 0,      1, 0    }, /* SETCC */
+    { 1, P(1),  0, 0,      3, 0    }, /* BITSCAN */
+    { 3, P0156, 0, 0,      2, 0    }, /* XCHG */
+    { 1, 0,     0, 0,      0, 0    }, /* NOP */
+    { 1, P15,   0, 0,      1, 0    }, /* BSWAP */
+    { 1, P015,  0, 0,      1, 0    }, /* VMOV */
+    { 1, P015,  0, 0,      1, 0    }, /* VLOGIC */
+    { 1, P015,  0, 0,      1, 0    }, /* VIADD */
+    { 1, P01,   0, 0,      5, 0    }, /* VIMUL */
+    { 1, P(5),  0, 0,      1, 0    }, /* VSHUF */
+    { 1, P01,   0, 0,      1, 0    }, /* VSHIFT */
+    { 1, P01,   0, 0,      4, 0    }, /* FADD */
+    { 1, P01,   0, 0,      4, 0    }, /* FMUL */
+    { 1, P01,   0, 0,      4, 0    }, /* FMA */
+    { 1, P(0),  0, 0,     11, 300  }, /* FDIV */
+    { 1, P(0),  0, 0,     14, 400  }, /* FDIVD */
+    { 1, P(0),  0, 0,     15, 600  }, /* FSQRT */
+    { 1, P01,   0, 0,      4, 0    }, /* FCVT */
+    { 1, P01,   0, 0,      4, 0    }, /* FCMP */
+    { 1, P0156, 0, 0,      1, 0    }, /* OTHER */
+    { 1, P015,  0, 0,      3, 0    }, /* VOTHER */
+};
+
+/* Ice Lake client: faster integer divider, 2 store ports */
+static const struct mca_entry icl_table[MC_LAST] = {
+    { 1, P0156, 0, 0,      1, 0    }, /* ALU */
+    { 1, P06,   0, 0,      1, 0    }, /* ADC */
+    { 1, P06,   0, 0,      1, 0    }, /* SHIFT */
+    { 3, P06,   0, 0,      2, 0    }, /* SHIFTCL */
+    { 1, P(1),  0, 0,      3, 0    }, /* IMUL */
+    { 1, P(1),  1, P(5),   3, 0    }, /* MUL */
+    { 1, P(0),  3, P0156, 12, 600  }, /* DIV32 */
+    { 1, P(0),  3, P0156, 15, 1000 }, /* DIV64 */
+    { 1, P15,   0, 0,      1, 0    }, /* LEA */
+    { 1, P0156, 0, 0,      1, 0    }, /* MOV */
+    { 0, 0,     0, 0,      0, 0    }, /* PUSH */
+    { 0, 0,     0, 0,      0, 0    }, /* POP */
+    { 1, P(6),  0, 0,      1, 0    }, /* JMP */
+    { 1, P06,   0, 0,      1, 0    }, /* JCC */
+    { 1, P(6),  0, 0,      1, 0    }, /* CALL */
+    { 1, P(6),  0, 0,      1, 0    }, /* RET */
+    { 1, P06,   0, 0,      1, 0    }, /* CMOV */
+    { 1, P06,   0, 0,      1, 0    }, /* SETCC */
+    { 1, P(1),  0, 0,      3, 0    }, /* BITSCAN */
+    { 3, P0156, 0, 0,      2, 0    }, /* XCHG */
+    { 1, 0,     0, 0,      0, 0    }, /* NOP */
+    { 1, P15,   0, 0,      1, 0    }, /* BSWAP */
+    { 1, P015,  0, 0,      1, 0    }, /* VMOV */
+    { 1, P015,  0, 0,      1, 0    }, /* VLOGIC */
+    { 1, P015,  0, 0,      1, 0    }, /* VIADD */
+    { 1, P01,   0, 0,      5, 0    }, /* VIMUL */
+    { 1, P15,   0, 0,      1, 0    }, /* VSHUF */
+    { 1, P01,   0, 0,      1, 0    }, /* VSHIFT */
+    { 1, P01,   0, 0,      4, 0    }, /* FADD */
+    { 1, P01,   0, 0,      4, 0    }, /* FMUL */
+    { 1, P01,   0, 0,      4, 0    }, /* FMA */
+    { 1, P(0),  0, 0,     11, 300  }, /* FDIV */
+    { 1, P(0),  0, 0,     13, 400  }, /* FDIVD */
+    { 1, P(0),  0, 0,     15, 600  }, /* FSQRT */
+    { 1, P01,   0, 0,      4, 0    }, /* FCVT */
+    { 1, P01,   0, 0,      4, 0    }, /* FCMP */
+    { 1, P0156, 0, 0,      1, 0    }, /* OTHER */
+    { 1, P015,  0, 0,      3, 0    }, /* VOTHER */
+};
+
+/* Zen 3: ports 0-3 = ALU, 4-6 = AGU, 7 = store data, 8-11 = FP pipes */
+#define I0123 ( P(0) | P(1) | P(2) | P(3) )
+#define I03   ( P(0) | P(3) )
+#define I12   ( P(1) | P(2) )
+#define L012  ( P(4) | P(5) | P(6) )
+#define F0123 ( P(8) | P(9) | P(10) | P(11) )
+#define F01   ( P(8) | P(9) )
+#define F03   ( P(8) | P(11) )
+#define F12   ( P(9) | P(10) )
+#define F23   ( P(10) | P(11) )
+
+static const struct mca_entry zen3_table[MC_LAST] = {
+    { 1, I0123, 0, 0,      1, 0    }, /* ALU */
+    { 1, I0123, 0, 0,      1, 0    }, /* ADC */
+    { 1, I12,   0, 0,      1, 0    }, /* SHIFT */
+    { 1, I12,   0, 0,      1, 0    }, /* SHIFTCL */
+    { 1, P(1),  0, 0,      3, 0    }, /* IMUL */
+    { 1, P(1),  1, I0123,  3, 0    }, /* MUL */
+    { 1, P(2),  1, I0123, 10, 600  }, /* DIV32 */
+    { 1, P(2),  1, I0123, 14, 900  }, /* DIV64 */
+    { 1, I0123, 0, 0,      1, 0    }, /* LEA */
+    { 1, I0123, 0, 0,      1, 0    }, /* MOV */
+    { 0, 0,     0, 0,      0, 0    }, /* PUSH */
+    { 0, 0,     0, 0,      0, 0    }, /* POP */
+    { 1, I03,   0, 0,      1, 0    }, /* JMP */
+    { 1, I03,   0, 0,      1, 0    }, /* JCC */
+    { 1, I03,   0, 0,      1, 0    }, /* CALL */
+    { 1, I03,   0, 0,      1, 0    }, /* RET */
+    { 1, I03,   0, 0,      1, 0    }, /* CMOV */
+    { 1, I03,   0, 0,      1, 0    }, /* SETCC */
+    { 1, I0123, 0, 0,      1, 0    }, /* BITSCAN */
+    { 2, I0123, 0, 0,      1, 0    }, /* XCHG */
+    { 1, 0,     0, 0,      0, 0    }, /* NOP */
+    { 1, I0123, 0, 0,      1, 0    }, /* BSWAP */
+    { 1, F0123, 0, 0,      1, 0    }, /* VMOV */
+    { 1, F0123, 0, 0,      1, 0    }, /* VLOGIC */
+    { 1, F0123, 0, 0,      1, 0    }, /* VIADD */
+    { 1, F03,   0, 0,      3, 0    }, /* VIMUL */
+    { 1, F12,   0, 0,      1, 0    }, /* VSHUF */
+    { 1, F12,   0, 0,      1, 0    }, /* VSHIFT */
+    { 1, F23,   0, 0,      3, 0    }, /* FADD */
+    { 1, F01,   0, 0,      3, 0    }, /* FMUL */
+    { 1, F01,   0, 0,      4, 0    }, /* FMA */
+    { 1, P(9),  0, 0,     10, 300  }, /* FDIV */
+    { 1, P(9),  0, 0,     13, 450  }, /* FDIVD */
+    { 1, P(9),  0, 0,     14, 500  }, /* FSQRT */
+    { 1, F23,   0, 0,      3, 0    }, /* FCVT */
+    { 1, F01,   0, 0,      1, 0    }, /* FCMP */
+    { 1, I0123, 0, 0,      1, 0    }, /* OTHER */
+    { 1, F0123, 0, 0,      3, 0    }, /* VOTHER */
+};
+
+static const struct mca_model models[] = {
+    { "skl",  "skylake", "Skylake",  "p0p1p2p3p4p5p6p7",         8, 4, 5, 6,
+      P(2) | P(3), P(2) | P(3) | P(7), P(4), TRUE, skl_table },
+    { "icl",  "icelake", "Ice Lake", "p0p1p2p3p4p5p6p7p8p9",    10, 5, 5, 6,
+      P(2) | P(3), P(7) | P(8), P(4) | P(9), TRUE, icl_table },
+    { "zen3", "znver3",  "Zen 3",    "i0i1i2i3l0l1l2sdf0f1f2f3", 12, 6, 4, 7,
+      L012, L012, P(7), FALSE, zen3_table },
+};
+
+/* SIMD instructions, matched by name prefix ( without a leading 'v' ).
+ * The first match wins, so more specific prefixes must come first.
+ */
+static const struct {
+    const char *prefix;
+    uint_8 cls;
+} simdnames[] = {
+    { "fmadd",  MC_FMA    }, { "fmsub",  MC_FMA    },
+    { "fnmadd", MC_FMA    }, { "fnmsub", MC_FMA    },
+    { "movmsk", MC_VOTHER }, { "pmovmsk", MC_VOTHER },
+    { "movhlp", MC_VSHUF  }, { "movlhp", MC_VSHUF  },
+    { "movddup", MC_VSHUF }, { "movshdup", MC_VSHUF }, { "movsldup", MC_VSHUF },
+    { "pmovzx", MC_VSHUF  }, { "pmovsx", MC_VSHUF  },
+    { "mov",    MC_VMOV   }, { "lddqu",  MC_VMOV   },
+    { "broadcast", MC_VMOV }, { "pbroadcast", MC_VMOV },
+    { "rsqrt",  MC_FMUL   }, { "rcp",    MC_FMUL   },
+    { "sqrt",   MC_FSQRT  },
+    { "cvt",    MC_FCVT   },
+    { "cmp",    MC_FCMP   }, { "comi",   MC_FCMP   }, { "ucomi",  MC_FCMP   },
+    { "and",    MC_VLOGIC }, { "or",     MC_VLOGIC }, { "xor",    MC_VLOGIC },
+    { "pand",   MC_VLOGIC }, { "por",    MC_VLOGIC }, { "pxor",   MC_VLOGIC },
+    { "pternlog", MC_VLOGIC }, { "blend", MC_VLOGIC }, { "pblend", MC_VLOGIC },
+    { "pmul",   MC_VIMUL  }, { "pmadd",  MC_VIMUL  },
+    { "pslldq", MC_VSHUF  }, { "psrldq", MC_VSHUF  },
+    { "psll",   MC_VSHIFT }, { "psrl",   MC_VSHIFT }, { "psra",   MC_VSHIFT },
+    { "padd",   MC_VIADD  }, { "psub",   MC_VIADD  }, { "pavg",   MC_VIADD  },
+    { "pmin",   MC_VIADD  }, { "pmax",   MC_VIADD  }, { "pabs",   MC_VIADD  },
+    { "pcmp",   MC_VIADD  }, { "psign",  MC_VIADD  },
+    { "shuf",   MC_VSHUF  }, { "pshuf",  MC_VSHUF  }, { "unpck",  MC_VSHUF  },
+    { "punpck", MC_VSHUF  }, { "perm",   MC_VSHUF  }, { "pack",   MC_VSHUF  },
+    { "palignr", MC_VSHUF }, { "insert", MC_VSHUF  }, { "extract", MC_VSHUF },
+    { "pinsr",  MC_VSHUF  }, { "pextr",  MC_VSHUF  },
+    { "div",    MC_FDIV   },
+    { "mul",    MC_FMUL   },
+    { "add",    MC_FADD   }, { "sub",    MC_FADD   }, { "hadd",   MC_FADD   },
+    { "hsub",   MC_FADD   }, { "min",    MC_FADD   }, { "max",    MC_FADD   },
+    { "round",  MC_FADD   },
+};
+
+/* a basic block inside a PROC */
+struct mca_block {
+    struct mca_block *next;
+    struct dsym *proc;
+    uint_32     start;
+    uint_32     end;
+    uint_32     instrs;
+    uint_32     unknown;           /* instructions without table entry */
+    uint_32     uops;
+    uint_32     lat;               /* critical path length in cycles */
+    uint_32     press[MAXPORTS];   /* port pressure in 1/CYCLE cycles */
+};
+
+static const struct mca_model *model;
+static struct mca_block *BlockHead;
+static struct mca_block *BlockTail;
+static bool             newblock;  /* next instruction starts a new block */
+static bool             inblock;   /* current instruction belongs to BlockTail */
+static uint_32          ready[NUMKEYS]; /* cycle when a register's value is available */
+
+/* fixed width listing column: ports, uops, reciprocal throughput, latency */
+#define LISTTEXTFMT "%-17.17s %2u %3u.%02u %3u%c "
+#define LISTTEXTLEN 33
+static char ListText[LISTTEXTLEN + 1];
+static const char szEmpty[LISTTEXTLEN + 1] = "                                 ";
+static bool havetext;
+
+/* RET of a PROC: the epilogue's total is written into the RET line's column */
+static bool             epilogue;
+static long             epipos;    /* LST file pos of the RET line's column, -1 if not listed */
+static unsigned         epiuops;
+static unsigned         epilat;
+static bool             epiunk;
+static uint_32          epipress[MAXPORTS];
+
+int McaSetModel( const char *name )
+/*********************************/
+{
+    int i;
+
+    if ( name == NULL || *name == NULLC )
+        return( 1 );
+    for ( i = 0; i < sizeof( models ) / sizeof( models[0] ); i++ )
+        if ( _stricmp( name, models[i].id ) == 0 || _stricmp( name, models[i].alias ) == 0 )
+            return( i + 1 );
+    return( 0 );
+}
+
+static void FreeBlocks( void )
+/****************************/
+{
+    struct mca_block *blk;
+    struct mca_block *next;
+
+    for ( blk = BlockHead; blk; blk = next ) {
+        next = blk->next;
+        MemFree( blk );
+    }
+    BlockHead = BlockTail = NULL;
+}
+
+void McaInit( int pass )
+/**********************/
+{
+    FreeBlocks();
+    newblock = TRUE;
+    inblock = FALSE;
+    havetext = FALSE;
+    epilogue = FALSE;
+    model = ( Options.mca_cpu ? &models[Options.mca_cpu - 1] : NULL );
+}
+
+/* a code label has been defined */
+
+void McaLabel( void )
+/*******************/
+{
+    newblock = TRUE;
+}
+
+/* map a register to an index of ready[]; -1 if it isn't tracked */
+
+static int RegKey( unsigned reg )
+/*******************************/
+{
+    unsigned type = GetValueSp( reg );
+    unsigned regno = GetRegNo( reg );
+
+    if ( type == OP_BND || ( type & ( OP_RSPEC | OP_SR | OP_STI ) ) )
+        return( -1 );
+    if ( type & OP_R ) {
+        /* AH, CH, DH, BH */
+        if ( ( type & OP_R8 ) && regno >= 4 && regno < 8 && !( GetSflagsSp( reg ) & RWF_X64 ) )
+            regno -= 4;
+        return( regno & 0xF );
+    }
+    if ( type & ( OP_XMM | OP_YMM | OP_ZMM ) )
+        return( KEY_SIMD + ( regno & 0x1F ) );
+    if ( type & OP_MMX )
+        return( KEY_MMX + ( regno & 7 ) );
+    if ( type & OP_K )
+        return( KEY_MASK + ( regno & 7 ) );
+    return( -1 );
+}
+
+static enum mca_class SimdClass( const char *name, int opndCount, uint_8 *flags )
+/*******************************************************************************/
+{
+    int i;
+    bool vex = FALSE;
+    enum mca_class cls = MC_VOTHER;
+
+    if ( *name == 'v' ) {
+        vex = TRUE;
+        name++;
+    }
+    for ( i = 0; i < sizeof( simdnames ) / sizeof( simdnames[0] ); i++ ) {
+        if ( memcmp( name, simdnames[i].prefix, strlen( simdnames[i].prefix ) ) == 0 ) {
+            cls = simdnames[i].cls;
+            break;
+        }
+    }
+    if ( cls == MC_VOTHER )
+        *flags |= MF_UNK;
+    /* double precision divides are slower */
+    if ( cls == MC_FDIV && ( strstr( name, "pd" ) || strstr( name, "sd" ) ) )
+        cls = MC_FDIVD;
+    if ( memcmp( name, "comi", 4 ) == 0 || memcmp( name, "ucomi", 5 ) == 0 )
+        *flags |= MF_NODSTW | MF_WFLAGS;
+    if ( memcmp( name, "xor", 3 ) == 0 || memcmp( name, "pxor", 4 ) == 0 || memcmp( name, "psub", 4 ) == 0 )
+        *flags |= MF_ZERO;
+    /* the destination is read by 2-operand SSE forms ( and legacy SSE forms with
+     * an immediate ) except moves and conversions; AVX 3-operand forms don't read it,
+     * FMA always does.
+     */
+    switch ( cls ) {
+    case MC_FMA:
+        break;
+    case MC_VMOV:
+    case MC_FCVT:
+    case MC_FSQRT:
+        *flags |= MF_NODSTR;
+        break;
+    default:
+        if ( opndCount > 2 && ( vex || memcmp( name, "pshuf", 5 ) == 0 ) )
+            *flags |= MF_NODSTR;
+    }
+    return( cls );
+}
+
+static enum mca_class GetClass( const struct code_info *CodeInfo, const struct expr opndx[], int opndCount, bool simd, uint_8 *flags )
+/***********************************************************************************************************************************/
+{
+    char name[32];
+
+    *flags = 0;
+
+    if ( IS_JCC( CodeInfo->token ) ) {
+        *flags = MF_NODSTW | MF_RFLAGS | MF_END;
+        return( MC_JCC );
+    }
+    if ( IS_XCX_BRANCH( CodeInfo->token ) ) {
+        *flags = MF_NODSTW | MF_END;
+        return( MC_JCC );
+    }
+
+    switch ( CodeInfo->token ) {
+    case T_CMP:
+    case T_TEST:
+    case T_BT:
+        *flags = MF_NODSTW | MF_WFLAGS;
+        return( MC_ALU );
+    case T_XOR:
+    case T_SUB:
+        *flags = MF_ZERO | MF_WFLAGS;
+        return( MC_ALU );
+    case T_ADD:
+    case T_AND:
+    case T_OR:
+    case T_INC:
+    case T_DEC:
+    case T_NEG:
+    case T_NOT:
+    case T_ANDN:
+        *flags = MF_WFLAGS;
+        return( MC_ALU );
+    case T_ADC:
+    case T_SBB:
+        *flags = MF_RFLAGS | MF_WFLAGS;
+        return( MC_ADC );
+    case T_RCL:
+    case T_RCR:
+        *flags = MF_RFLAGS | MF_WFLAGS;
+        return( MC_SHIFTCL );
+    case T_SHL:
+    case T_SHR:
+    case T_SAR:
+    case T_SAL:
+    case T_ROL:
+    case T_ROR:
+        *flags = MF_WFLAGS;
+        if ( opndCount > 1 && IS_REGOPND( opndx[OPND2] ) )
+            return( MC_SHIFTCL );
+        return( MC_SHIFT );
+    case T_SHLD:
+    case T_SHRD:
+        *flags = MF_WFLAGS;
+        return( MC_SHIFTCL );
+    case T_IMUL:
+        *flags = MF_WFLAGS;
+        if ( opndCount == 1 ) {
+            *flags |= MF_RAXRDX;
+            return( MC_MUL );
+        }
+        if ( opndCount > 2 )
+            *flags |= MF_NODSTR;
+        return( MC_IMUL );
+    case T_MUL:
+        *flags = MF_WFLAGS | MF_RAXRDX;
+        return( MC_MUL );
+    case T_DIV:
+    case T_IDIV:
+        *flags = MF_WFLAGS | MF_RAXRDX;
+#if AMD64_SUPPORT
+        if ( CodeInfo->opnd[OPND1].type & ( OP_R64 | OP_M64 ) )
+            return( MC_DIV64 );
+#endif
+        return( MC_DIV32 );
+    case T_LEA:
+        *flags = MF_NODSTR;
+        return( MC_LEA );
+    case T_MOV:
+    case T_MOVZX:
+    case T_MOVSX:
+#if AMD64_SUPPORT
+    case T_MOVSXD:
+#endif
+        *flags = MF_NODSTR;
+        if ( ( CodeInfo->opnd[OPND1].type | CodeInfo->opnd[OPND2].type ) & ( OP_SR | OP_RSPEC ) ) {
+            *flags |= MF_UNK;
+            return( MC_OTHER );
+        }
+        return( MC_MOV );
+    case T_PUSH:
+        *flags = MF_NODSTW;
+        return( MC_PUSH );
+    case T_POP:
+        *flags = MF_NODSTR;
+        return( MC_POP );
+    case T_JMP:
+        *flags = MF_NODSTW | MF_END;
+        return( MC_JMP );
+    case T_CALL:
+        *flags = MF_NODSTW;
+        return( MC_CALL );
+    case T_RET:
+    case T_RETN:
+    case T_RETF:
+    case T_IRET:
+    case T_IRETD:
+#if AMD64_SUPPORT
+    case T_IRETQ:
+#endif
+        *flags = MF_NODSTW | MF_END;
+        return( MC_RET );
+    case T_BSF:
+    case T_BSR:
+    case T_LZCNT:
+    case T_TZCNT:
+    case T_POPCNT:
+        *flags = MF_NODSTR | MF_WFLAGS;
+        return( MC_BITSCAN );
+    case T_XCHG:
+        return( MC_XCHG );
+    case T_NOP:
+        *flags = MF_NODSTW;
+        return( MC_NOP );
+    case T_BSWAP:
+        return( MC_BSWAP );
+    }
+
+    GetResWName( CodeInfo->token, name );
+    if ( memcmp( name, "cmov", 4 ) == 0 ) {
+        *flags = MF_RFLAGS;
+        return( MC_CMOV );
+    }
+    if ( memcmp( name, "set", 3 ) == 0 && opndCount == 1 ) {
+        *flags = MF_NODSTR | MF_RFLAGS;
+        return( MC_SETCC );
+    }
+    if ( simd )
+        return( SimdClass( name, opndCount, flags ) );
+
+    *flags = MF_UNK;
+    return( MC_OTHER );
+}
+
+/* add a group of uops to the instruction's port pressure */
+
+static void AddUops( uint_32 *press, unsigned uops, unsigned ports, unsigned busy, char *portstr )
+/***********************************************************************************************/
+{
+    unsigned i;
+    unsigned n;
+    unsigned last = 0;
+
+    ports &= ( 1 << model->nports ) - 1;
+    for ( i = 0, n = 0; i < model->nports; i++ )
+        if ( ports & ( 1 << i ) )
+            n++;
+    if ( n == 0 )
+        return;
+    /* <busy> is given if a non-pipelined unit is blocked longer than 1 cycle */
+    busy = ( busy ? busy * ( CYCLE / 100 ) : uops * CYCLE );
+    if ( *portstr )
+        strcat( portstr, "+" );
+    portstr += strlen( portstr );
+    for ( i = 0; i < model->nports; i++ ) {
+        if ( ports & ( 1 << i ) ) {
+            press[i] += busy / n;
+            if ( model->portnames[i * 2] != last ) {
+                last = model->portnames[i * 2];
+                *portstr++ = last;
+            }
+            *portstr++ = model->portnames[i * 2 + 1];
+        }
+    }
+    *portstr = NULLC;
+}
+
+static void SetListText( char *buffer, const char *portstr, unsigned uops, uint_32 rthr, unsigned lat, bool unknown )
+/*****************************************************************************************************************/
+{
+    sprintf( buffer, LISTTEXTFMT, portstr[0] ? portstr : "-",
+            uops > 99 ? 99 : uops, rthr >= 1000 * CYCLE ? 999 : rthr / CYCLE, rthr >= 1000 * CYCLE ? 99 : HUNDREDTHS( rthr ),
+            lat > 999 ? 999 : lat, unknown ? '?' : ' ' );
+}
+
+/* called by ParseLine() before the instruction is encoded */
+
+void McaInstr( const struct code_info *CodeInfo, const struct expr opndx[], int opndCount )
+/*****************************************************************************************/
+{
+    const struct mca_entry *e;
+    struct mca_block *blk = NULL;
+    enum mca_class cls;
+    uint_8   flags;
+    int      i;
+    int      key;
+    int      dstkey = -1;
+    int      srckeys[MAX_OPND * 3 + 3];
+    int      numsrc = 0;
+    bool     simd = FALSE;
+    bool     zmm = FALSE;
+    bool     memsrc = FALSE;
+    bool     memdst = FALSE;
+    bool     load;
+    bool     store;
+    unsigned uops;
+    unsigned lat;
+    unsigned rthr;
+    uint_32  start;
+    uint_32  press[MAXPORTS];
+    char     portstr[64];
+
+    if ( model == NULL )
+        return;
+    if ( opndCount > MAX_OPND )
+        opndCount = MAX_OPND;
+
+    for ( i = 0; i < opndCount; i++ ) {
+        if ( IS_REGOPND( opndx[i] ) && opndx[i].base_reg ) {
+            unsigned type = GetValueSp( opndx[i].base_reg->tokval );
+            if ( type & ( OP_MMX | OP_XMM | OP_YMM | OP_ZMM | OP_K ) )
+                simd = TRUE;
+            if ( type & OP_ZMM )
+                zmm = TRUE;
+        }
+    }
+    cls = GetClass( CodeInfo, opndx, opndCount, simd, &flags );
+    e = &model->table[cls];
+
+    /* collect register sources and destination */
+    for ( i = 0; i < opndCount; i++ ) {
+        if ( IS_REGOPND( opndx[i] ) && opndx[i].base_reg ) {
+            key = RegKey( opndx[i].base_reg->tokval );
+            if ( key < 0 )
+                continue;
+            if ( i == OPND1 && !( flags & MF_NODSTW ) )
+                dstkey = key;
+            if ( i != OPND1 || !( flags & MF_NODSTR ) )
+                srckeys[numsrc++] = key;
+        } else if ( IS_MEMOPND( opndx[i] ) &&
+                   !( IS_ANY_BRANCH( CodeInfo->token ) && !( CodeInfo->opnd[i].type & OP_M_ANY ) ) ) {
+            /* memory operand; the address registers are sources */
+            if ( opndx[i].base_reg && ( key = RegKey( opndx[i].base_reg->tokval ) ) >= 0 )
+                srckeys[numsrc++] = key;
+            if ( opndx[i].idx_reg && ( key = RegKey( opndx[i].idx_reg->tokval ) ) >= 0 )
+                srckeys[numsrc++] = key;
+            if ( i == OPND1 && !( flags & MF_NODSTW ) ) {
+                memdst = TRUE;
+                if ( !( flags & MF_NODSTR ) )
+                    memsrc = TRUE;
+            } else
+                memsrc = TRUE;
+        }
+    }
+    /* xor reg,reg, pxor xmm,xmm, ... break the dependency */
+    if ( ( flags & MF_ZERO ) && opndCount > 1 && dstkey >= 0 ) {
+        for ( i = 1; i < opndCount; i++ )
+            if ( !IS_REGOPND( opndx[i] ) || RegKey( opndx[i].base_reg->tokval ) != dstkey )
+                break;
+        if ( i == opndCount )
+            numsrc = 0;
+    }
+    if ( flags & MF_RFLAGS )
+        srckeys[numsrc++] = KEY_FLAGS;
+    if ( flags & MF_RAXRDX ) {
+        srckeys[numsrc++] = 0;
+        if ( cls == MC_DIV32 || cls == MC_DIV64 )
+            srckeys[numsrc++] = 2;
+    }
+
+    /* uops and port pressure */
+    memset( press, 0, sizeof( press ) );
+    portstr[0] = NULLC;
+    load = memsrc;
+    store = memdst;
+    switch ( cls ) {
+    case MC_LEA:
+    case MC_NOP:
+        load = FALSE;
+        break;
+    case MC_PUSH:
+    case MC_CALL:
+        store = TRUE;
+        break;
+    case MC_POP:
+    case MC_RET:
+        load = TRUE;
+        break;
+    }
+    uops = load + store * 2;
+    lat = e->lat;
+    /* plain loads and stores don't need an ALU */
+    if ( !( ( cls == MC_MOV || cls == MC_VMOV ) && ( memsrc || memdst ) ) ) {
+        unsigned ports = e->ports;
+        unsigned uops1 = e->uops;
+        if ( zmm ) {
+            if ( model->zmm_fused ) {
+                if ( ports & ~P(1) )
+                    ports &= ~P(1);
+            } else {
+                uops1 *= 2;
+                flags |= MF_UNK;
+            }
+        }
+        AddUops( press, uops1, ports, e->busy, portstr );
+        AddUops( press, e->uops2, e->ports2, 0, portstr );
+        uops += uops1 + e->uops2;
+    } else
+        lat = 0;
+    if ( load ) {
+        AddUops( press, 1, model->load_ports, 0, portstr );
+        if ( cls != MC_RET )
+            lat += ( simd ? model->vload_lat : model->load_lat );
+    }
+    if ( store ) {
+        AddUops( press, 1, model->sta_ports, 0, portstr );
+        AddUops( press, 1, model->std_ports, 0, portstr );
+        if ( lat == 0 )
+            lat = 1;
+    }
+    rthr = uops * CYCLE / model->width;
+    for ( i = 0; i < model->nports; i++ )
+        if ( press[i] > rthr )
+            rthr = press[i];
+
+    /* the listing annotation */
+    SetListText( ListText, portstr, uops, rthr, lat, flags & MF_UNK );
+    havetext = TRUE;
+    if ( epilogue ) {
+        epiuops += uops;
+        epilat += lat;
+        if ( flags & MF_UNK )
+            epiunk = TRUE;
+        for ( i = 0; i < model->nports; i++ )
+            epipress[i] += press[i];
+    }
+
+    /* basic block data; instructions outside of procedures are ignored */
+    if ( CurrProc == NULL ) {
+        newblock = TRUE;
+        return;
+    }
+    if ( newblock || BlockTail == NULL || BlockTail->proc != CurrProc ) {
+        blk = MemAlloc( sizeof( struct mca_block ) );
+        memset( blk, 0, sizeof( struct mca_block ) );
+        blk->proc = CurrProc;
+        blk->start = blk->end = GetCurrOffset();
+        if ( BlockTail )
+            BlockTail->next = blk;
+        else
+            BlockHead = blk;
+        BlockTail = blk;
+        memset( ready, 0, sizeof( ready ) );
+        newblock = FALSE;
+    }
+    blk = BlockTail;
+    inblock = TRUE;
+    blk->instrs++;
+    if ( flags & MF_UNK )
+        blk->unknown++;
+    blk->uops += uops;
+    for ( i = 0; i < model->nports; i++ )
+        blk->press[i] += press[i];
+
+    /* critical path: an instruction starts when all sources are ready */
+    for ( i = 0, start = 0; i < numsrc; i++ )
+        if ( ready[srckeys[i]] > start )
+            start = ready[srckeys[i]];
+    start += lat;
+    if ( dstkey >= 0 )
+        ready[dstkey] = start;
+    if ( flags & MF_WFLAGS )
+        ready[KEY_FLAGS] = start;
+    if ( flags & MF_RAXRDX ) {
+        ready[0] = start;
+        ready[2] = start;
+    }
+    if ( start > blk->lat )
+        blk->lat = start;
+    if ( flags & MF_END )
+        newblock = TRUE;
+}
+
+/* called by ParseLine() after the instruction has been encoded */
+
+void McaDone( void )
+/******************/
+{
+    havetext = FALSE;
+    if ( inblock )
+        BlockTail->end = GetCurrOffset();
+    inblock = FALSE;
+}
+
+/* get the listing column of the current line; the annotation of an
+ * instruction is returned once, else the column is empty.
+ */
+
+const char *McaListText( void )
+/*****************************/
+{
+    /* the first line listed after McaEpilogue( TRUE ) is the RET line */
+    if ( epilogue && epipos < 0 )
+        epipos = ftell( CurrFile[LST] );
+    if ( havetext ) {
+        havetext = FALSE;
+        return( ListText );
+    }
+    return( szEmpty );
+}
+
+/* RetInstr() lists the RET line, then generates the epilogue.
+ * The column of the RET line is empty then; when the epilogue is done,
+ * it's replaced by the sum of the epilogue instructions: ports used,
+ * uops, reciprocal throughput and latency ( of the dependency chain ).
+ */
+
+void McaEpilogue( bool start )
+/****************************/
+{
+    char     text[LISTTEXTLEN + 1];
+    char     portstr[MAXPORTS * 2 + 2];
+    char     *p;
+    unsigned last = 0;
+    uint_32  rthr;
+    long     pos;
+    int      i;
+
+    if ( model == NULL )
+        return;
+    if ( start ) {
+        epilogue = TRUE;
+        epipos = -1;
+        epiuops = epilat = 0;
+        epiunk = FALSE;
+        memset( epipress, 0, sizeof( epipress ) );
+        return;
+    }
+    epilogue = FALSE;
+    if ( epipos < 0 || epiuops == 0 || CurrFile[LST] == NULL )
+        return;
+    rthr = epiuops * CYCLE / model->width;
+    for ( i = 0, p = portstr; i < model->nports; i++ ) {
+        if ( epipress[i] > rthr )
+            rthr = epipress[i];
+        if ( epipress[i] ) {
+            if ( model->portnames[i * 2] != last ) {
+                last = model->portnames[i * 2];
+                *p++ = last;
+            }
+            *p++ = model->portnames[i * 2 + 1];
+        }
+    }
+    *p = NULLC;
+    SetListText( text, portstr, epiuops, rthr, epilat, epiunk );
+    pos = ftell( CurrFile[LST] );
+    fseek( CurrFile[LST], epipos, SEEK_SET );
+    fwrite( text, 1, LISTTEXTLEN, CurrFile[LST] );
+    fseek( CurrFile[LST], pos, SEEK_SET );
+}
+
+static void PrintFix( const char *fmt, uint_32 value )
+/****************************************************/
+{
+    value = ( value + CYCLE / 200 ) / ( CYCLE / 100 );
+    LstPrintf( fmt, value / 100, value % 100 );
+}
+
+/* write the block summary and free the block data */
+
+void McaFini( void )
+/******************/
+{
+    struct mca_block *blk;
+    struct dsym *proc = NULL;
+    uint_32 thr;
+    uint_32 fe;
+    uint_32 cycles;
+    uint_32 total = 0;
+    uint_32 tinstrs = 0;
+    uint_32 tuops = 0;
+    unsigned blkno = 0;
+    unsigned maxport;
+    int i;
+
+    if ( model == NULL || CurrFile[LST] == NULL || BlockHead == NULL ) {
+        FreeBlocks();
+        return;
+    }
+
+    /* go to EOF */
+    fseek( CurrFile[LST], 0, SEEK_END );
+
+    LstNL();
+    LstNL();
+    LstPrintf( "Static analysis for %s, estimated cycles per basic block:", model->name );
+    LstNL();
+    LstPrintf( "( listing column: ports, uops, reciprocal throughput, latency; ? = estimated;" );
+    LstNL();
+    LstPrintf( "  a RET with epilogue shows the epilogue's total )" );
+    LstNL();
+    LstNL();
+    LstPrintf( "                Offset   Size Instrs  Uops  Thruput  Latency  Cycles  Bound" );
+    LstNL();
+    for ( blk = BlockHead; ; blk = blk->next ) {
+        if ( blk == NULL || blk->proc != proc ) {
+            if ( proc ) {
+                LstPrintf( "  total                 %6u %5u", tinstrs, tuops );
+                PrintFix( "                    %5u.%02u", total );
+                LstNL();
+            }
+            if ( blk == NULL )
+                break;
+            proc = blk->proc;
+            LstPrintf( "%s", proc->sym.name );
+            LstNL();
+            blkno = 0;
+            total = tinstrs = tuops = 0;
+        }
+        fe = blk->uops * CYCLE / model->width;
+        for ( i = 0, maxport = 0; i < model->nports; i++ )
+            if ( blk->press[i] > blk->press[maxport] )
+                maxport = i;
+        thr = ( blk->press[maxport] > fe ? blk->press[maxport] : fe );
+        cycles = ( blk->lat * CYCLE > thr ? blk->lat * CYCLE : thr );
+        total += cycles;
+        tinstrs += blk->instrs;
+        tuops += blk->uops;
+
+        LstPrintf( "  #%-4u         %08" I32_SPEC "X %6" I32_SPEC "u %6u %5u", ++blkno, blk->start, blk->end - blk->start, blk->instrs, blk->uops );
+        PrintFix( "  %4u.%02u", thr );
+        LstPrintf( "  %7u", blk->lat );
+        PrintFix( "  %3u.%02u", cycles );
+        if ( cycles == blk->lat * CYCLE && cycles > thr )
+            LstPrintf( "  latency" );
+        else if ( fe >= blk->press[maxport] )
+            LstPrintf( "  front end" );
+        else
+            LstPrintf( "  port %c%c", model->portnames[maxport * 2], model->portnames[maxport * 2 + 1] );
+        if ( blk->unknown )
+            LstPrintf( " (%u unknown)", blk->unknown );
+        LstNL();
+        /* port pressure */
+        if ( blk->press[maxport] ) {
+            LstPrintf( "       ports:" );
+            for ( i = 0; i < model->nports; i++ )
+                if ( blk->press[i] ) {
+                    LstPrintf( " %c%c ", model->portnames[i * 2], model->portnames[i * 2 + 1] );
+                    PrintFix( "%u.%02u", blk->press[i] );
+                }
+            LstNL();
+        }
+    }
+    FreeBlocks();
+}
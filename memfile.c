@@ -0,0 +1,314 @@
+/****************************************************************************
+*
+*  This code is Public Domain.
+*
+*  ========================================================================
+*
+* Description:  memory files. Used if "-" is given as file name:
+*               the source is read from stdin, the object module and
+*               listing are written to stdout. Since those files are
+*               read/written with random access and in every pass, they
+*               are held in memory and copied to/from the stream once.
+*               The memory files are standard FILE streams, so the
+*               output format writers don't need to know about them.
+*               Without fopencookie() or funopen() ( Windows ), they are
+*               temporary files.
+*
+****************************************************************************/
+
+#if defined(__UNIX__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for fopencookie() */
+#endif
+
+#include "globals.h"
+#include "memalloc.h"
+#include "memfile.h"
+
+#if defined(__UNIX__) || defined(__CYGWIN__) || defined(__DJGPP__)
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+/* COOKIES: 1=fopencookie() (glibc), 2=funopen() (BSD, OSX), 0=temporary file */
+#if defined(__GLIBC__)
+#define COOKIES 1
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+#define COOKIES 2
+#else
+#define COOKIES 0
+#endif
+
+#if COOKIES == 0 && defined(_WIN32)
+#include <windows.h>
+#include <fcntl.h>
+#endif
+
+#define MF_MINSIZE 0x10000
+
+static FILE *stdout_file; /* stdout before it was redirected to stderr */
+static FILE *streams[NUM_FILE_TYPES]; /* streams for "-", set by the library interface */
+
+#if COOKIES
+
+struct memfile {
+    char    *buffer;
+    uint_32 pos;  /* current position */
+    uint_32 size; /* size of contents */
+    uint_32 max;  /* size of buffer   */
+};
+
+static size_t mf_read( struct memfile *mf, char *buf, size_t len )
+/****************************************************************/
+{
+    if ( mf->pos >= mf->size )
+        return( 0 );
+    if ( len > mf->size - mf->pos )
+        len = mf->size - mf->pos;
+    memcpy( buf, mf->buffer + mf->pos, len );
+    mf->pos += len;
+    return( len );
+}
+
+static size_t mf_write( struct memfile *mf, const char *buf, size_t len )
+/***********************************************************************/
+{
+    char *tmp;
+
+    if ( mf->pos + len > mf->max ) {
+        mf->max = ( mf->max ? mf->max * 2 : MF_MINSIZE );
+        while ( mf->pos + len > mf->max )
+            mf->max *= 2;
+        tmp = MemAlloc( mf->max );
+        if ( mf->buffer ) {
+            memcpy( tmp, mf->buffer, mf->size );
+            MemFree( mf->buffer );
+        }
+        mf->buffer = tmp;
+    }
+    /* the position may be behind the end ( COFF: uninitialized data ) */
+    if ( mf->pos > mf->size )
+        memset( mf->buffer + mf->size, 0, mf->pos - mf->size );
+    memcpy( mf->buffer + mf->pos, buf, len );
+    mf->pos += len;
+    if ( mf->pos > mf->size )
+        mf->size = mf->pos;
+    return( len );
+}
+
+static long mf_seek( struct memfile *mf, long pos, int whence )
+/*************************************************************/
+{
+    switch ( whence ) {
+    case SEEK_CUR: pos += mf->pos;  break;
+    case SEEK_END: pos += mf->size; break;
+    }
+    if ( pos < 0 )
+        return( -1 );
+    mf->pos = pos;
+    return( pos );
+}
+
+static int mf_close( void *cookie )
+/*********************************/
+{
+    struct memfile *mf = cookie;
+
+    if ( mf->buffer )
+        MemFree( mf->buffer );
+    MemFree( mf );
+    return( 0 );
+}
+
+#if COOKIES == 1
+
+static ssize_t glibc_read( void *cookie, char *buf, size_t len )
+/**************************************************************/
+{
+    return( mf_read( cookie, buf, len ) );
+}
+static ssize_t glibc_write( void *cookie, const char *buf, size_t len )
+/*********************************************************************/
+{
+    return( mf_write( cookie, buf, len ) );
+}
+static int glibc_seek( void *cookie, off64_t *pos, int whence )
+/*************************************************************/
+{
+    long rc = mf_seek( cookie, *pos, whence );
+    if ( rc < 0 )
+        return( -1 );
+    *pos = rc;
+    return( 0 );
+}
+
+#else
+
+static int bsd_read( void *cookie, char *buf, int len )
+/*****************************************************/
+{
+    return( mf_read( cookie, buf, len ) );
+}
+static int bsd_write( void *cookie, const char *buf, int len )
+/************************************************************/
+{
+    return( mf_write( cookie, buf, len ) );
+}
+static fpos_t bsd_seek( void *cookie, fpos_t pos, int whence )
+/************************************************************/
+{
+    return( mf_seek( cookie, pos, whence ) );
+}
+
+#endif
+
+#endif
+
+#if COOKIES == 0 && defined(_WIN32)
+
+/* v2.52: the MS CRT has no user-defined streams, and its tmpfile() creates
+ * the file in the root directory, which usually isn't writable. A file in
+ * the TEMP directory is used instead. FILE_ATTRIBUTE_TEMPORARY keeps it in
+ * the system cache as long as memory is available, and it's deleted when
+ * closed.
+ */
+static FILE *TempFile( void )
+/***************************/
+{
+    char path[MAX_PATH];
+    char name[MAX_PATH];
+    HANDLE h;
+    int fh;
+    FILE *file;
+
+    if ( GetTempPathA( sizeof( path ), path ) == 0 ||
+        GetTempFileNameA( path, "uas", 0, name ) == 0 )
+        return( NULL );
+    h = CreateFileA( name, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                    FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL );
+    if ( h == INVALID_HANDLE_VALUE ) {
+        DeleteFileA( name );
+        return( NULL );
+    }
+    fh = _open_osfhandle( (intptr_t)h, _O_RDWR | _O_BINARY );
+    if ( fh == -1 ) {
+        CloseHandle( h );
+        return( NULL );
+    }
+    file = _fdopen( fh, "w+b" );
+    if ( file == NULL )
+        _close( fh );
+    return( file );
+}
+
+#elif COOKIES == 0
+#define TempFile() tmpfile()
+#endif
+
+/* create a memory file.
+ * if src isn't NULL, the initial contents are read from this stream.
+ * without cookie support, an anonymous temporary file is used.
+ */
+FILE *MemFileOpen( FILE *src )
+/****************************/
+{
+    FILE *file;
+    size_t len;
+    char buffer[0x1000];
+#if COOKIES
+    struct memfile *mf;
+#if COOKIES == 1
+    static const cookie_io_functions_t iofuncs = { glibc_read, glibc_write, glibc_seek, mf_close };
+#endif
+
+    mf = MemAlloc( sizeof( struct memfile ) );
+    memset( mf, 0, sizeof( struct memfile ) );
+#if COOKIES == 1
+    file = fopencookie( mf, "w+", iofuncs );
+#else
+    file = funopen( mf, bsd_read, bsd_write, bsd_seek, mf_close );
+#endif
+    if ( file == NULL ) {
+        MemFree( mf );
+        return( NULL );
+    }
+#else
+    file = TempFile();
+    if ( file == NULL )
+        return( NULL );
+#endif
+    if ( src ) {
+        while ( ( len = fread( buffer, 1, sizeof( buffer ), src ) ) > 0 )
+            if ( fwrite( buffer, 1, len, file ) != len ) {
+                fclose( file );
+                return( NULL );
+            }
+        rewind( file );
+    }
+    DebugMsg(("MemFileOpen(%p)=%p\n", src, file ));
+    return( file );
+}
+
+/* close a memory file.
+ * if dst isn't NULL, the contents are written to this stream before.
+ */
+int MemFileClose( FILE *file, FILE *dst )
+/***************************************/
+{
+    int rc = 0;
+    size_t len;
+    char buffer[0x1000];
+
+    DebugMsg(("MemFileClose(%p, %p)\n", file, dst ));
+    if ( dst ) {
+        rewind( file );
+        while ( ( len = fread( buffer, 1, sizeof( buffer ), file ) ) > 0 )
+            if ( fwrite( buffer, 1, len, dst ) != len ) {
+                rc = EOF;
+                break;
+            }
+        if ( fflush( dst ) != 0 )
+            rc = EOF;
+    }
+    if ( fclose( file ) != 0 )
+        rc = EOF;
+    return( rc );
+}
+
+/* get the stream to write "-" output files to.
+ * on first call, stdout is duplicated and then redirected to stderr,
+ * so the assembler's messages won't be mixed with the output.
+ */
+FILE *MemFileStdout( void )
+/*************************/
+{
+    int fh;
+
+    if ( stdout_file == NULL ) {
+        fflush( stdout );
+        fh = dup( fileno( stdout ) );
+        if ( fh != -1 && ( stdout_file = fdopen( fh, "wb" ) ) != NULL )
+            dup2( fileno( stderr ), fileno( stdout ) );
+        else
+            stdout_file = stdout;
+    }
+    return( stdout_file );
+}
+
+/* get the stream for "-" as file name of type ASM, OBJ, LST or ERR.
+ * that's stdin for the source and stdout for the output files, unless
+ * the library interface has set other streams.
+ */
+FILE *MemFileStream( int type )
+/*****************************/
+{
+    if ( streams[type] )
+        return( streams[type] );
+    return( type == ASM ? stdin : MemFileStdout() );
+}
+
+void MemFileSetStream( int type, FILE *file )
+/*******************************************/
+{
+    streams[type] = file;
+}
@@ -49,7 +49,6 @@
 #include "input.h"
 #include "linnum.h"
 
-#define TRUNCATE 1
 #define MULTIHDR 1     /* write muliple THEADR records (Masm compatible) */
 #define WRITEIMPDEF 0  /* write IMPDEF coment records for OPTION DLLIMPORT */
 
@@ -60,14 +59,6 @@
 #define MAX_PUB_LENGTH 1024 /* max length of PUBDEF record */
 
 
-#if TRUNCATE
-#if defined(__UNIX__) || defined(__CYGWIN__) || defined(__DJGPP__)
-#include <unistd.h>
-#else
-#include <io.h>
-#endif
-#endif
-
 #if defined(__UNIX__) || defined(__CYGWIN__)
 #define _stat stat
 #endif
@@ -112,9 +103,9 @@ extern const char szNull[];
  */
 int_32       LastCodeBufSize;
 
-static uint_32    seg_pos;        /* file pos of SEGDEF record(s) */
-static uint_32    public_pos;     /* file pos of PUBDEF record(s) */
-static uint_32    end_of_header;  /* file pos of "end of header"  */
+static uint_32    seg_pos;        /* image pos of SEGDEF record(s) */
+static uint_32    public_pos;     /* image pos of PUBDEF record(s) */
+static uint_32    end_of_header;  /* image pos of "end of header"  */
 
 /* v2.12: moved from inside omf_write_lnames() */
 static int startitem;
@@ -623,7 +614,7 @@ void omf_set_filepos( void )
     DebugMsg1(( "omf_set_filepos: reset file pos to %X\n", end_of_header ));
 #if MULTIHDR
 #endif
-    fseek( CurrFile[OBJ], end_of_header, SEEK_SET );
+    omf_img_seek( end_of_header );
 }
 
 static void omf_write_dosseg( void )
@@ -1554,17 +1545,14 @@ static void omf_write_debug_tables( void )
 
 /* write OMF module.
  * this is called after the last pass.
- * since the OMF records are written "on the fly",
- * the "normal" section contents are already written at this time.
+ * since the OMF records are written "on the fly" to the module image,
+ * the "normal" section contents are already stored at this time.
+ * v2.52: the image is written to the object file here, in one go.
  */
 
 static ret_code omf_write_module( struct module_info *modinfo )
 /*************************************************************/
 {
-#if TRUNCATE
-    int fh;
-    uint_32 size;
-#endif
     /* -if Zi is set, write symbols and types */
     if ( Options.debug_symbols )
         omf_write_debug_tables();
@@ -1573,41 +1561,23 @@ static ret_code omf_write_module( struct module_info *modinfo )
     LclFree( modinfo->g.start_fixup );
 #endif
 
-#if TRUNCATE
     /* under some very rare conditions, the object
-     * module might become shorter! Hence the file
-     * must be truncated now. The problem is that there
-     * is no stream function for this task.
-     * the final solution will be to save the segment contents
-     * in buffers and write the object module once everything
-     * is done ( as it is done for the other formats already).
-     * v2.03: most likely no longer necessary, since the file
-     * won't become shorter anymore.
+     * module might become shorter! Hence the image
+     * must be truncated now.
      */
-    size = ftell( CurrFile[OBJ] );
-#if defined(__UNIX__) || defined(__CYGWIN__) || defined(__DJGPP__)
-    fh = fileno( CurrFile[OBJ] );
-    if ( ftruncate( fh, size ) ); /* gcc warns if return value of ftruncate() is "ignored" */
-#elif defined(__BORLANDC__)
-    fh = _fileno( CurrFile[OBJ] );
-    chsize( fh, size );
-#else
-    fh = _fileno( CurrFile[OBJ] );
-    _chsize( fh, size );
-#endif
-
-#endif
+    omf_img_truncate();
 
     /* write SEGDEF records. Since these records contain the segment's length,
      * the records have to be written again after the final assembly pass.
      */
-    fseek( CurrFile[OBJ] , seg_pos, SEEK_SET );
+    omf_img_seek( seg_pos );
     omf_write_segdef();
     /* write PUBDEF records. Since the final value of offsets isn't known after
      * the first pass, this has to be called again after the final pass.
      */
-    fseek( CurrFile[OBJ], public_pos, SEEK_SET);
+    omf_img_seek( public_pos );
     omf_write_pubdef();
+    omf_img_flush();
     return( NOT_ERROR );
 }
 
@@ -1639,7 +1609,7 @@ static ret_code omf_write_header_initial( struct module_info *modinfo )
      * the records have to be written again after the final assembly pass.
      * hence the start position of those records has to be saved.
      */
-    seg_pos = ftell( CurrFile[OBJ] );
+    seg_pos = omf_img_tell();
     omf_write_segdef();
     omf_write_grpdef(); /* write GRPDEF records */
     ext_idx = omf_write_extdef(); /* write EXTDEF records */
@@ -1649,7 +1619,7 @@ static ret_code omf_write_header_initial( struct module_info *modinfo )
     /* write PUBDEF records. Since the final value of offsets isn't known after
      * the first pass, this has to be called again after the final pass.
      */
-    public_pos = ftell( CurrFile[OBJ] );
+    public_pos = omf_img_tell();
     omf_write_pubdef();
     omf_write_export(); /* write export COMENT records */
 
@@ -1661,7 +1631,7 @@ static ret_code omf_write_header_initial( struct module_info *modinfo )
      */
     if ( !ModuleInfo.g.start_fixup )
         omf_end_of_pass1();
-    end_of_header = ftell( CurrFile[OBJ] );
+    end_of_header = omf_img_tell();
     return( NOT_ERROR );
 }
 
@@ -1679,5 +1649,6 @@ void omf_init( struct module_info *modinfo )
     ln_srcfile = modinfo->srcfile;
 #endif
     ln_size = 0;
+    omf_img_free(); /* image of a previous module with errors */
     return;
 }
@@ -31,6 +31,7 @@
 #include <stddef.h>
 
 #include "globals.h"
+#include "memalloc.h"
 #include "omfint.h"
 #include "omfspec.h"
 #include "myassert.h"
@@ -51,11 +52,83 @@ struct outbuff {
 };
 #pragma pack( pop )
 
-static void safeWrite( FILE *file, const uint_8 *buf, unsigned len )
-/******************************************************************/
+/* v2.52: the records are no longer written to the file "on the fly".
+ * They are stored in a memory image of the object module, which is
+ * written once, after the final pass. Since the "pass 2" records are
+ * generated in every pass, the image position is reset to the end of
+ * the header when a new pass starts ( see omf_set_filepos() ).
+ */
+static struct {
+    uint_8  *buffer;
+    uint_32 pos;  /* current position */
+    uint_32 size; /* size of module   */
+    uint_32 max;  /* size of buffer   */
+} img;
+
+#define IMG_MINSIZE 0x10000
+
+static void safeWrite( const uint_8 *buf, unsigned len )
+/******************************************************/
+{
+    uint_8 *tmp;
+
+    if ( img.pos + len > img.max ) {
+        img.max = ( img.max ? img.max * 2 : IMG_MINSIZE );
+        while ( img.pos + len > img.max )
+            img.max *= 2;
+        tmp = MemAlloc( img.max );
+        if ( img.buffer ) {
+            memcpy( tmp, img.buffer, img.size );
+            MemFree( img.buffer );
+        }
+        img.buffer = tmp;
+    }
+    memcpy( img.buffer + img.pos, buf, len );
+    img.pos += len;
+    if ( img.pos > img.size )
+        img.size = img.pos;
+}
+
+/* get/set position in module image */
+
+uint_32 omf_img_tell( void )
+/**************************/
+{
+    return( img.pos );
+}
+
+void omf_img_seek( uint_32 pos )
+/******************************/
 {
-    if( fwrite( buf, 1, len, file ) != len )
+    img.pos = pos;
+}
+
+/* cut the module image at the current position.
+ * the module might have become shorter than in a previous pass.
+ */
+void omf_img_truncate( void )
+/***************************/
+{
+    img.size = img.pos;
+}
+
+/* write the module image to the object file and release it */
+
+void omf_img_flush( void )
+/************************/
+{
+    DebugMsg1(( "omf_img_flush: %" I32_SPEC "u bytes\n", img.size ));
+    if ( img.size && fwrite( img.buffer, 1, img.size, CurrFile[OBJ] ) != img.size )
         WriteError();
+    omf_img_free();
+}
+
+void omf_img_free( void )
+/***********************/
+{
+    if ( img.buffer )
+        MemFree( img.buffer );
+    memset( &img, 0, sizeof( img ) );
 }
 
 #if 0
@@ -104,7 +177,7 @@ static void WEndRec( struct outbuff *out )
     *p = checksum; /* store chksum in buffer */
 
     /* write buffer + 4 extra bytes (1 cmd, 2 length, 1 chksum) */
-    safeWrite( CurrFile[OBJ], &out->cmd, out->in_buf + 4 );
+    safeWrite( &out->cmd, out->in_buf + 4 );
 
 #if 0 //def DEBUG_OUT
     p = &out->cmd;
@@ -0,0 +1,259 @@
+/****************************************************************************
+*
+*  This code is Public Domain.
+*
+*  ========================================================================
+*
+* Description:  size optimizing instruction selection ( OPTION OPTIMIZE ).
+*               The operands of an instruction are rewritten before they
+*               are passed to CodeGenV2() and codegen(), so both code
+*               generators select the shorter, equivalent encoding:
+*               - MOV r64, imm with 0 <= imm <= 0FFFFFFFFh uses the
+*                 zero-extending 32-bit register form.
+*               - MOV reg, 0 becomes XOR reg, reg if the flags are dead.
+*               - commutative VEX instructions swap their source
+*                 operands if this allows the 2-byte VEX prefix.
+*               Each rewritten line is marked with '~' in the listing.
+*
+*               Whether the flags are dead is known only after the next
+*               instruction has been parsed. The result is kept per
+*               instruction ( numbered in source order ) and used in the
+*               next pass; if it changes, another pass is enforced.
+*
+****************************************************************************/
+
+#include <string.h>
+
+#include "globals.h"
+#include "memalloc.h"
+#include "parser.h"
+#include "reswords.h"
+#include "expreval.h"
+#include "segment.h"
+#include "optimize.h"
+
+/* flags in marks[] */
+#define OPT_XOR   0x01 /* MOV reg, 0: flags are dead, emit XOR */
+#define OPT_NOXOR 0x02 /* flags turned out to be live, don't try again */
+
+#define IS_REGOPND( x ) ( (x).kind == EXPR_REG && (x).indirect == FALSE )
+
+static uint_8       *marks;     /* one entry per instruction */
+static uint_32      marksize;
+static uint_32      seq;        /* instruction number in current pass */
+static uint_32      cand;       /* seq+1 of pending MOV reg, 0; 0 if none */
+static struct dsym  *cand_seg;
+static uint_32      cand_end;   /* offset behind the pending MOV */
+static bool         is_cand;    /* current instruction is a MOV reg, 0 */
+static unsigned     changed;    /* marks[] modified in this pass */
+
+/* instructions which write all status flags without reading them */
+
+static bool KillsFlags( unsigned token )
+/**************************************/
+{
+    switch ( token ) {
+    case T_ADD:
+    case T_SUB:
+    case T_CMP:
+    case T_TEST:
+    case T_AND:
+    case T_OR:
+    case T_XOR:
+    case T_NEG:
+        return( TRUE );
+    }
+    return( FALSE );
+}
+
+/* VEX instructions of map 0F whose source operands may be exchanged.
+ * Scalar forms ( upper bits come from the first source ), MIN/MAX
+ * ( result depends on the order for NaNs ) and ANDN aren't included.
+ */
+
+static bool IsCommutative( unsigned token )
+/*****************************************/
+{
+    switch ( token ) {
+    case T_VADDPS:
+    case T_VADDPD:
+    case T_VMULPS:
+    case T_VMULPD:
+    case T_VANDPS:
+    case T_VANDPD:
+    case T_VORPS:
+    case T_VORPD:
+    case T_VXORPS:
+    case T_VXORPD:
+    case T_VPADDB:
+    case T_VPADDW:
+    case T_VPADDD:
+    case T_VPADDQ:
+    case T_VPADDSB:
+    case T_VPADDSW:
+    case T_VPADDUSB:
+    case T_VPADDUSW:
+    case T_VPAND:
+    case T_VPOR:
+    case T_VPXOR:
+    case T_VPMULLW:
+    case T_VPMULHW:
+    case T_VPMULHUW:
+    case T_VPMULUDQ:
+    case T_VPMADDWD:
+    case T_VPCMPEQB:
+    case T_VPCMPEQW:
+    case T_VPCMPEQD:
+    case T_VPMINUB:
+    case T_VPMINSW:
+    case T_VPMAXUB:
+    case T_VPMAXSW:
+    case T_VPAVGB:
+    case T_VPAVGW:
+    case T_VPSADBW:
+        return( TRUE );
+    }
+    return( FALSE );
+}
+
+/* store the result for the pending MOV reg, 0 */
+
+static void SetMark( bool dead )
+/******************************/
+{
+    uint_32 i = cand - 1;
+    uint_8  *p;
+
+    cand = 0;
+    if ( i >= marksize ) {
+        if ( dead == FALSE )
+            return;
+        p = MemAlloc( ( i + 1 ) * 2 );
+        memset( p, 0, ( i + 1 ) * 2 );
+        if ( marks ) {
+            memcpy( p, marks, marksize );
+            MemFree( marks );
+        }
+        marks = p;
+        marksize = ( i + 1 ) * 2;
+    }
+    if ( dead ) {
+        if ( marks[i] == 0 ) {
+            marks[i] = OPT_XOR;
+            changed++;
+        }
+    } else if ( marks[i] & OPT_XOR ) {
+        DebugMsg(("SetMark(%u): flags are live, XOR withdrawn\n", i ));
+        marks[i] = OPT_NOXOR;
+        changed++;
+    }
+}
+
+void OptimizeInit( int pass )
+/***************************/
+{
+    if ( pass == PASS_1 )
+        OptimizeFini();
+    else if ( cand )
+        SetMark( FALSE );
+    seq = 0;
+    cand = 0;
+    changed = 0;
+}
+
+/* called for each instruction after its operands have been evaluated */
+
+void OptimizeInstr( struct code_info *CodeInfo, struct expr opndx[], int opndCount, const char **instr )
+/******************************************************************************************************/
+{
+    unsigned reg;
+    unsigned regno;
+    struct expr tmp;
+
+    seq++;
+    is_cand = FALSE;
+
+    /* the flags set by the previous MOV reg, 0 are dead if this
+     * instruction overwrites them and follows it immediately.
+     */
+    if ( cand )
+        SetMark( KillsFlags( CodeInfo->token ) && CurrSeg == cand_seg && GetCurrOffset() == cand_end );
+
+    if ( ModuleInfo.optimize == FALSE || opndCount < 2 )
+        return;
+
+    if ( CodeInfo->token == T_MOV && IS_REGOPND( opndx[OPND1] ) &&
+        opndx[OPND2].kind == EXPR_CONST && opndx[OPND2].hlvalue == 0 &&
+        opndx[OPND2].llvalue <= 0xFFFFFFFF ) {
+        reg = opndx[OPND1].base_reg->tokval;
+        if ( ( GetValueSp( reg ) & ( OP_R16 | OP_R32 | OP_R64 ) ) == 0 )
+            return;
+        /* writing a 32-bit register clears bits 32-63 */
+        if ( GetValueSp( reg ) & OP_R64 ) {
+            regno = GetRegNo( reg );
+            opndx[OPND1].base_reg->tokval = ( regno < 8 ? T_EAX + regno : T_R8D + regno - 8 );
+            ModuleInfo.line_flags |= LOF_OPTIMIZED;
+        }
+        if ( opndx[OPND2].llvalue == 0 ) {
+            is_cand = TRUE;
+            if ( seq <= marksize && ( marks[seq-1] & OPT_XOR ) ) {
+                DebugMsg1(("OptimizeInstr(%u): MOV reg, 0 -> XOR\n", seq ));
+                CodeInfo->token = T_XOR;
+                CodeInfo->pinstr = &InstrTable[IndexFromToken( T_XOR )];
+                *instr = "xor";
+                opndx[OPND2] = opndx[OPND1];
+                ModuleInfo.line_flags |= LOF_OPTIMIZED;
+            }
+        }
+        return;
+    }
+
+    /* VEX.B/VEX.X require the 3-byte prefix, VEX.R doesn't */
+    if ( opndCount == 3 && CodeInfo->evex_flag == FALSE && IsCommutative( CodeInfo->token ) &&
+        IS_REGOPND( opndx[OPND1] ) && IS_REGOPND( opndx[OPND2] ) && IS_REGOPND( opndx[OPND3] ) &&
+        GetRegNo( opndx[OPND1].base_reg->tokval ) < 16 &&
+        GetRegNo( opndx[OPND2].base_reg->tokval ) < 8 &&
+        GetRegNo( opndx[OPND3].base_reg->tokval ) >= 8 &&
+        GetRegNo( opndx[OPND3].base_reg->tokval ) < 16 ) {
+        DebugMsg1(("OptimizeInstr(%u): VEX source operands exchanged\n", seq ));
+        tmp = opndx[OPND2];
+        opndx[OPND2] = opndx[OPND3];
+        opndx[OPND3] = tmp;
+        CodeInfo->reg3 = GetRegNo( opndx[OPND3].base_reg->tokval );
+        ModuleInfo.line_flags |= LOF_OPTIMIZED;
+    }
+}
+
+/* the instruction has been encoded; remember where a MOV reg, 0 ends */
+
+void OptimizeDone( void )
+/***********************/
+{
+    ModuleInfo.line_flags &= ~LOF_OPTIMIZED;
+    if ( is_cand ) {
+        is_cand = FALSE;
+        cand = seq;
+        cand_seg = CurrSeg;
+        cand_end = GetCurrOffset();
+    }
+}
+
+/* end of pass: a MOV reg, 0 at the very end has no successor. */
+
+unsigned OptimizeCheck( void )
+/****************************/
+{
+    if ( cand )
+        SetMark( FALSE );
+    DebugMsg(("OptimizeCheck: %u changes\n", changed ));
+    return( changed );
+}
+
+void OptimizeFini( void )
+/***********************/
+{
+    if ( marks )
+        MemFree( marks );
+    marks = NULL;
+    marksize = 0;
+}
@@ -252,6 +252,53 @@ OPTFUNC(SetFPS)
     return(NOT_ERROR);
 }
 
+/* v2.52: OPTION OPTIMIZE:SIZE | NONE(default) */
+OPTFUNC(SetOptimize)
+/******************/
+{
+    int i = *pi;
+
+    /* SIZE is an operator, so the token type isn't checked */
+    if (0 == _stricmp(tokenarray[i].string_ptr, "SIZE")) {
+        ModuleInfo.optimize = TRUE;
+    }
+    else if (0 == _stricmp(tokenarray[i].string_ptr, "NONE")) {
+        ModuleInfo.optimize = FALSE;
+    }
+    else {
+        return(EmitErr(SYNTAX_ERROR_EX, tokenarray[i].tokpos));
+    }
+    DebugMsg1(("SetOptimize(%s) ok\n", tokenarray[i].string_ptr));
+    i++;
+    *pi = i;
+    return(NOT_ERROR);
+}
+
+/* v2.52: OPTION RIPRELATIVE:ON | OFF ( default is ON if -pie is set ) */
+OPTFUNC(SetRipRelative)
+/*********************/
+{
+    int i = *pi;
+    if (tokenarray[i].token == T_ID) {
+        if (0 == _stricmp(tokenarray[i].string_ptr, "ON")) {
+            ModuleInfo.riprelative = TRUE;
+        }
+        else if (0 == _stricmp(tokenarray[i].string_ptr, "OFF")) {
+            ModuleInfo.riprelative = FALSE;
+        }
+        else {
+            return(EmitErr(SYNTAX_ERROR_EX, tokenarray[i].tokpos));
+        }
+        DebugMsg1(("SetRipRelative(%s) ok\n", tokenarray[i].string_ptr));
+        i++;
+    }
+    else {
+        return(EmitErr(SYNTAX_ERROR_EX, tokenarray[i].tokpos));
+    }
+    *pi = i;
+    return(NOT_ERROR);
+}
+
 /* OPTION HLCall:ON | OFF(default) */
 OPTFUNC(SetHLCall)
 /*******************/
@@ -1349,7 +1396,9 @@ static const struct asm_option optiontab[] = {
   { "LITERALS",         SetLiterals },   /* LITERALS:ON or OFF */
   { "VTABLE",           SetVTable },     /* VTABLE:ON or OFF */
   { "HLCALL",           SetHLCall },     /* HLCALL:ON or OFF */
-  { "FRAMEPRESERVEFLAGS", SetFPS }       /* FRAMEPRESERVEFLAGS:ON or OFF */
+  { "FRAMEPRESERVEFLAGS", SetFPS },      /* FRAMEPRESERVEFLAGS:ON or OFF */
+  { "OPTIMIZE",         SetOptimize },   /* OPTIMIZE:SIZE or NONE */
+  { "RIPRELATIVE",      SetRipRelative } /* RIPRELATIVE:ON or OFF */
 };
 
 #define TABITEMS sizeof( optiontab) / sizeof( optiontab[0] )
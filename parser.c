@@ -29,6 +29,7 @@
 ****************************************************************************/
 #include <ctype.h>
 #include <limits.h>
+#include <time.h>
 #include "globals.h"
 #include "memalloc.h"
 #include "parser.h"
@@ -54,6 +55,17 @@
 #include "condasm.h"
 #include "extern.h"
 #include "atofloat.h"
+#include "mca.h"
+#include "optimize.h"
+#include "riprel.h"
+
+/* v2.52: QueryPerformanceCounter() for the encoder timing */
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOGDI    /* wingdi.h defines ERROR */
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 
 #if defined(WINDOWSDDK)
@@ -131,6 +143,11 @@ bool IsSimdReg(struct asm_tok *regTok)
 	return result;
 }
 
+/* v2.52: number of items added to TAB_EXT. Lazy declarations ( -lazyinc )
+ * reserve a number when they are indexed, see LazyDeclSortExt().
+ */
+uint_32 ExtOrder;
+
 /* add item to linked list of symbols */
 void sym_add_table( struct symbol_queue *queue, struct dsym *item )
 /*****************************************************************/
@@ -139,6 +156,8 @@ void sym_add_table( struct symbol_queue *queue, struct dsym *item )
     if ( queue == &SymTables[TAB_UNDEF] )
         item->sym.fwdref = TRUE;
 #endif
+    if ( queue == &SymTables[TAB_EXT] )
+        item->sym.ext_order = ++ExtOrder;
     if( queue->head == NULL ) {
         queue->head = queue->tail = item;
         item->next = item->prev = NULL;
@@ -650,8 +669,123 @@ void set_frame2( const struct asym *sym )
     SetFixupFrame( SegOverride ? SegOverride : sym, TRUE );
 }
 
-static ret_code set_rm_sib(struct code_info *CodeInfo, unsigned CurrOpnd, char ss, int index, int base, const struct asym *sym)
-/*******************************************************************************************************************************/
+/* v2.52: displacements which are label differences with a forward
+ * referenced label in pass 1 are relaxable: they are assumed to fit in a
+ * byte ( disp8 or EVEX disp8*N ) in pass 1 and grow in later passes if the
+ * value requires it. A single forward referenced label isn't relaxed, since
+ * it usually needs a fixup and hence a full-size displacement. Like short
+ * jumps, a displacement with a base register never shrinks again once it
+ * has grown after it was short, so the passes converge ( a span like
+ * [rbx+(L2-L1)*8] might otherwise toggle between disp8*N and disp32 ).
+ * The memory operands are numbered in source order to find them in the
+ * later passes.
+ */
+
+#define DISP_FWD   0x01 /* unknown label difference in pass 1 */
+#define DISP_SHORT 0x02 /* was less than full size */
+#define DISP_FULL  0x04 /* has grown to full size afterwards */
+
+static uint_8  *disp_flags; /* one entry per memory operand */
+static uint_32 disp_max;
+static uint_32 disp_seq;    /* memory operand number in current pass */
+static uint_32 disp_last;   /* disp_seq of last DispSized() call */
+static struct {
+    uint_32 relaxable;      /* unknown label differences in pass 1 */
+    uint_32 relaxed;        /* ... which are less than full size now */
+    uint_32 compressed;     /* ... which are EVEX disp8*N */
+    uint_32 saved;          /* bytes less than full-size displacements */
+} disp_stat;
+
+void DispRelaxInit( int pass )
+/****************************/
+{
+    if ( pass == PASS_1 )
+        DispRelaxFini();
+    disp_seq = 0;
+    disp_last = 0;
+    memset( &disp_stat, 0, sizeof( disp_stat ) );
+}
+
+void DispRelaxFini( void )
+/************************/
+{
+    if ( disp_flags )
+        MemFree( disp_flags );
+    disp_flags = NULL;
+    disp_max = 0;
+}
+
+/* number a memory operand; var: displacement size depends on its value,
+ * fwd: it is an unknown label difference ( pass 1 only ).
+ * Sets CodeInfo->relax_var, relax_disp and relax_full.
+ */
+static void DispRelax( struct code_info *CodeInfo, bool var, bool fwd )
+/*********************************************************************/
+{
+    uint_32 i = disp_seq++;
+    uint_8 *p;
+
+    CodeInfo->relax_var = var;
+    if ( var == FALSE )
+        return;
+    if ( i >= disp_max ) {
+        p = MemAlloc( ( i + 1 ) * 2 );
+        memset( p, 0, ( i + 1 ) * 2 );
+        if ( disp_flags ) {
+            memcpy( p, disp_flags, disp_max );
+            MemFree( disp_flags );
+        }
+        disp_flags = p;
+        disp_max = ( i + 1 ) * 2;
+    }
+    if ( Parse_Pass == PASS_1 )
+        disp_flags[i] = ( fwd ? DISP_FWD : 0 );
+    CodeInfo->relax_disp = ( ( disp_flags[i] & DISP_FWD ) != 0 );
+    CodeInfo->relax_full = ( ( disp_flags[i] & DISP_FULL ) != 0 );
+}
+
+/* a displacement has been sized by CodeGenV2() or codegen().
+ * size: bytes emitted; full: size of a full displacement ( 2 or 4 ).
+ */
+void DispSized( const struct code_info *CodeInfo, unsigned size, unsigned full )
+/******************************************************************************/
+{
+    uint_8 *p;
+
+    if ( CodeInfo->relax_var == FALSE || disp_seq == 0 || disp_seq > disp_max )
+        return;
+    p = &disp_flags[disp_seq - 1];
+    if ( size < full )
+        *p |= DISP_SHORT;
+    else if ( Parse_Pass > PASS_1 && ( *p & DISP_SHORT ) && ( *p & DISP_FULL ) == 0 ) {
+        DebugMsg(("DispSized(%" I32_SPEC "u): displacement has grown, locked\n", disp_seq - 1 ));
+        *p |= DISP_FULL;
+    }
+    /* CodeGenV2() may fail after the operand has been sized */
+    if ( CodeInfo->relax_disp == FALSE || disp_last == disp_seq )
+        return;
+    disp_last = disp_seq;
+    disp_stat.relaxable++;
+    if ( size < full ) {
+        disp_stat.relaxed++;
+        disp_stat.saved += full - size;
+        if ( CodeInfo->evex_flag && size )
+            disp_stat.compressed++;
+    }
+}
+
+/* display displacement relaxation ( -stats ); numbers are those of the last pass */
+
+void DispRelaxStats( void )
+/*************************/
+{
+    if ( disp_stat.relaxable )
+        printf( "displacements: %" I32_SPEC "u forward label differences, %" I32_SPEC "u relaxed (%" I32_SPEC "u EVEX disp8*N), %" I32_SPEC "u bytes below disp32/disp16\n",
+               disp_stat.relaxable, disp_stat.relaxed, disp_stat.compressed, disp_stat.saved );
+}
+
+static ret_code set_rm_sib(struct code_info *CodeInfo, unsigned CurrOpnd, char ss, int index, int base, const struct asym *sym, bool span)
+/*****************************************************************************************************************************************/
 /*
  * encode ModRM and SIB byte for memory addressing.
  * called by memory_operand().
@@ -659,6 +793,7 @@ static ret_code set_rm_sib(struct code_info *CodeInfo, unsigned CurrOpnd, char s
  *   index = index register (T_DI, T_ESI, ...)
  *    base = base register (T_EBP, ... )
  *     sym = symbol (direct addressing, displacement)
+ *    span = displacement is a label difference which isn't known yet
  * out: CodeInfo->rm_byte, CodeInfo->sib, CodeInfo->prefix.rex
  */
   {
@@ -683,7 +818,17 @@ static ret_code set_rm_sib(struct code_info *CodeInfo, unsigned CurrOpnd, char s
   bit3_idx = 0;
   rex = 0;
 #endif
+  /* v2.52: displacement with a GPR base is relaxable. In pass 1, just a
+   * label difference is assumed to become a constant; a single forward
+   * referenced label will most likely need a fixup and keep full size.
+   * A scaled difference ( [rbx+(L2-L1)*8] ) is a constant already.
+   */
+  DispRelax( CodeInfo, base != EMPTY && base != T_RIP && ( GetValueSp( base ) & ( OP_R16 | OP_R32 | OP_R64 ) ),
+            span );
   if (CodeInfo->opnd[CurrOpnd].InsFixup != NULL) { /* symbolic displacement given? */
+    mod_field = ( CodeInfo->relax_disp && Parse_Pass == PASS_1 ) ? MOD_01 : MOD_10;
+    }
+  else if (CodeInfo->relax_full) { /* v2.52: don't shrink again */
     mod_field = MOD_10;
     }
   else if ((CodeInfo->opnd[CurrOpnd].data32l == 0) || (base == T_RIP)) { /* no displacement (or 0) */
@@ -1919,7 +2064,7 @@ static ret_code memory_operand( struct code_info *CodeInfo, unsigned CurrOpnd, s
             CodeInfo->opnd[CurrOpnd].InsFixup = CreateFixup( sym, fixup_type, OPTJ_NONE );
     }
 
-    if( set_rm_sib( CodeInfo, CurrOpnd, ss, index, base, sym ) == ERROR ) 
+    if( set_rm_sib( CodeInfo, CurrOpnd, ss, index, base, sym, opndx->is_span ) == ERROR ) 
         return( ERROR );
     
     /* set frame type/data in fixup if one was created */
@@ -3031,6 +3176,137 @@ static struct asym *IsType( const char *name )
     return( NULL );
 }
 
+/* v2.52: encoder timing ( -stats ).
+ * The time spent in CodeGenV2() and codegen() is measured per instruction
+ * and summed up per ISA family. CodeGenV2() calls that fall back to
+ * codegen() are counted separately.
+ */
+
+enum enc_family {
+    ENCF_LEGACY,    /* general purpose, x87 */
+    ENCF_SSE,       /* MMX, 3DNow, SSE1-4 */
+    ENCF_AVX,       /* VEX encoded */
+    ENCF_AVX512,    /* EVEX encoded */
+    ENCF_COUNT
+};
+
+enum enc_kind {
+    ENCK_V2,        /* encoded by CodeGenV2() */
+    ENCK_V1,        /* encoded by codegen() */
+    ENCK_V2MISS,    /* CodeGenV2() returned EMPTY */
+    ENCK_COUNT
+};
+
+struct enc_stat {
+    uint_32 count;
+    uint_32 bytes;
+    uint_64 ticks;
+};
+
+static struct enc_stat enc_stats[ENCK_COUNT][ENCF_COUNT];
+static const char * const enc_family_names[ENCF_COUNT] = { "legacy", "sse", "avx", "avx512" };
+static const char * const enc_kind_names[ENCK_COUNT] = { "codegenv2", "codegen", "codegenv2-miss" };
+
+/* return a timestamp; unit is 1 ns on Unix, the performance counter tick on Windows */
+
+static uint_64 EncTicks( void )
+/*****************************/
+{
+#ifdef _WIN32
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter( &ticks );
+    return( ticks.QuadPart );
+#else
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( (uint_64)ts.tv_sec * 1000000000 + ts.tv_nsec );
+#endif
+}
+
+static enum enc_family EncFamily( const struct code_info *CodeInfo )
+/******************************************************************/
+{
+    if ( CodeInfo->evex_flag )
+        return( ENCF_AVX512 );
+    if ( CodeInfo->token >= VEX_START )
+        return( ENCF_AVX );
+    if ( InstrTable[IndexFromToken( CodeInfo->token )].cpu & P_EXT_MASK )
+        return( ENCF_SSE );
+    return( ENCF_LEGACY );
+}
+
+static void EncAdd( enum enc_kind kind, enum enc_family family, uint_32 bytes, uint_64 ticks )
+/********************************************************************************************/
+{
+    enc_stats[kind][family].count++;
+    enc_stats[kind][family].bytes += bytes;
+    enc_stats[kind][family].ticks += ticks;
+}
+
+/* same as the encoder calls at the end of ParseLine(), with timing */
+
+static ret_code EncodeTimed( const char *instr, struct code_info *CodeInfo, struct code_info *CodeInfoV2,
+                            uint_32 oldofs, uint_32 opCount, struct expr opExpr[] )
+/****************************************************************************************************/
+{
+    ret_code rc;
+    uint_64 start;
+    uint_64 end;
+    uint_32 ofs = GetCurrOffset();
+    enum enc_family family;
+
+    start = EncTicks();
+    if ( ModuleInfo.Ofssize == USE32 || ModuleInfo.Ofssize == USE64 ) {
+        rc = CodeGenV2( instr, CodeInfoV2, oldofs, opCount, opExpr );
+        end = EncTicks();
+        family = EncFamily( CodeInfoV2->evex_flag ? CodeInfoV2 : CodeInfo );
+        if ( rc != EMPTY ) {
+            EncAdd( ENCK_V2, family, GetCurrOffset() - ofs, end - start );
+            return( rc );
+        }
+        EncAdd( ENCK_V2MISS, family, 0, end - start );
+        start = end;
+    }
+    rc = codegen( CodeInfo, oldofs );
+    end = EncTicks();
+    EncAdd( ENCK_V1, EncFamily( CodeInfo ), GetCurrOffset() - ofs, end - start );
+    return( rc );
+}
+
+/* display encoder throughput ( -stats ). One line per encoder and family:
+ * encoder: <encoder> <family> <instructions> <bytes> <ns>
+ */
+
+void EncoderStats( void )
+/***********************/
+{
+    unsigned kind;
+    unsigned family;
+    uint_64 ns;
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency( &freq );
+#endif
+
+    for ( kind = 0; kind < ENCK_COUNT; kind++ )
+        for ( family = 0; family < ENCF_COUNT; family++ ) {
+            struct enc_stat *es = &enc_stats[kind][family];
+            if ( es->count == 0 )
+                continue;
+#ifdef _WIN32
+            ns = (uint_64)( (double)es->ticks * 1e9 / freq.QuadPart );
+#else
+            ns = es->ticks;
+#endif
+            printf( "encoder: %-14s %-6s %10" I32_SPEC "u instr %10" I32_SPEC "u bytes %12" I64_SPEC "u ns",
+                   enc_kind_names[kind], enc_family_names[family], es->count, es->bytes, ns );
+            if ( ns )
+                printf( ", %.0f instr/s, %.0f bytes/s", (double)es->count * 1e9 / ns, (double)es->bytes * 1e9 / ns );
+            printf( "\n" );
+        }
+    memset( enc_stats, 0, sizeof( enc_stats ) );
+}
+
 /*
  * ParseLine() is the main parser function.
  * It scans the tokens in tokenarray[] and does:
@@ -3073,6 +3349,9 @@ ret_code ParseLine(struct asm_tok tokenarray[]) {
 	memset(&CodeInfoV2, 0, sizeof(CodeInfo));
 
 	i = 0;
+#if FASTPASS
+	EvalCacheLine(NULL, NULL);
+#endif
   
 	/* ************************************************************** */
 	/* Support direct usage of USE16, USE32, USE64 for UASM Flat Mode */
@@ -3424,6 +3703,11 @@ dataInProc:
 	}
 
 	FStoreLine(0); /* must be placed AFTER write_prologue() */
+#if FASTPASS
+	/* v2.52: cache pass-invariant operands of the stored line */
+	if (UseSavedState && ModuleInfo.GeneratedCode == 0 && LineStoreCurr->rescan == FALSE)
+		EvalCacheLine(LineStoreCurr, tokenarray);
+#endif
 
 	CodeInfo.token = tokenarray[i].tokval;
 	opcodePtr      = tokenarray[i].string_ptr; // Copy a pointer to the mnemonic string for CodeGenV2.
@@ -3653,6 +3937,15 @@ dataInProc:
 		}
 	}
 
+	/* v2.52: OPTION RIPRELATIVE, replace absolute label addresses */
+	if (RipRelInstr(&CodeInfo, opndx, opndCount)) {
+		temp = NOT_ERROR;
+		goto nopor;
+	}
+
+	/* v2.52: OPTION OPTIMIZE, select shorter equivalent forms */
+	OptimizeInstr(&CodeInfo, opndx, opndCount, &opcodePtr);
+
 	/* ********************************************************* */
 	/* Make copy of Code Generation structures for V2 CodeGen.   */
 	/* ********************************************************* */
@@ -4039,10 +4332,16 @@ dataInProc:
 			}
 		}
 	}
+	/* v2.52: -Sc, estimate uops/throughput/latency for the listing */
+	if (Options.mca_cpu)
+		McaInstr(&CodeInfo, opndx, CodeInfo.opnd[OPND1].type == OP_NONE ? 0 : opndCount);
+
 	/* *********************************************************** */
 	/* Use the V2 CodeGen, else fallback to the standard CodeGen   */
 	/* *********************************************************** */
-	if (ModuleInfo.Ofssize == USE32 || ModuleInfo.Ofssize == USE64)
+	if (Options.stats)
+		temp = EncodeTimed(opcodePtr, &CodeInfo, &CodeInfoV2, oldofs, opndCount, opndxV2);
+	else if (ModuleInfo.Ofssize == USE32 || ModuleInfo.Ofssize == USE64)
 	{
 		temp = CodeGenV2(opcodePtr, &CodeInfoV2, oldofs, opndCount, opndxV2);
 		if (temp == EMPTY)
@@ -4051,6 +4350,13 @@ dataInProc:
 	else
 		temp = codegen(&CodeInfo, oldofs);
 
+	if (Options.mca_cpu)
+		McaDone();
+	OptimizeDone();
+	/* v2.52: -icf, remember where a RET or JMP ends */
+	if (Options.fold_procs && CurrProc)
+		FoldInstr(CodeInfo.token);
+
 nopor:
 	/* now reset EVEX maskflags for the next line */
 	decoflags  = 0;
@@ -4118,9 +4424,7 @@ void ProcessFile( struct asm_tok tokenarray[] )
 		{
 			if (PreprocessLine(CurrSource, tokenarray))
 			{
-				ParseLine(tokenarray);
-				if (Options.preprocessor_stdout == TRUE && Parse_Pass == PASS_1)
-					WritePreprocessedLine(CurrSource);
+				ParsePreprocessedLine(CurrSource, tokenarray);
 			}
 		} while (ModuleInfo.EndDirFound == FALSE && GetTextLine(CurrSource));
     }
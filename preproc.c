@@ -24,10 +24,14 @@
 #include "proc.h"
 #include "expreval.h"
 #include "assume.h"
+#include "types.h"
+#include "hll.h"
+#include "preproc.h"
 
 #define REMOVECOMENT 0 /* 1=remove comments from source       */
 
 extern ret_code (* const directive_tab[])( int, struct asm_tok[] );
+extern enum proc_status ProcStatus;
 
 #ifdef DEBUG_OUT
 int_32 cntppl0;    /* count preprocessed lines 1 */
@@ -57,8 +61,10 @@ ret_code WriteCodeLabel( char *line, struct asm_tok tokenarray[] )
     Token_Count = 2;
     tokenarray[2].token = T_FINAL;
     *tokenarray[2].tokpos = NULLC;
-    ParseLine( tokenarray );
-    if ( Options.preprocessor_stdout == TRUE )
+    /* v2.52: with -EP, the label isn't defined */
+    if ( Options.preprocessor_stdout == FALSE )
+        ParseLine( tokenarray );
+    else
         WritePreprocessedLine( line );
     Token_Count = oldcnt;
     tokenarray[2].token = oldtoken;
@@ -66,6 +72,31 @@ ret_code WriteCodeLabel( char *line, struct asm_tok tokenarray[] )
     return( NOT_ERROR );
 }
 
+/* v2.52: -EP, write the definition of a text macro. The preprocessor
+ * doesn't expand text macros inside literals ( initializers of structured
+ * variables ), so the output needs their definitions. Those of generated
+ * code ( OPTION CASEMAP ) are created again when the output is assembled.
+ */
+static void WriteTextMacro( const struct asym *sym )
+/**************************************************/
+{
+    const char *src;
+    char *dst;
+    char *buffer;
+
+    if ( ModuleInfo.GeneratedCode )
+        return;
+    buffer = myalloca( sym->name_size + 2 * strlen( sym->string_ptr ) + 12 );
+
+    dst = buffer + sprintf( buffer, "%s TEXTEQU <", sym->name );
+    for ( src = sym->string_ptr; *src; *dst++ = *src++ )
+        if ( *src == '<' || *src == '>' || *src == '!' )
+            *dst++ = '!';
+    *dst++ = '>';
+    *dst = NULLC;
+    WritePreprocessedLine( buffer );
+}
+
 /* Verify a matched pair of function call brackets, assuming initial opening bracket position
    and return the closing bracket position or -1.
 */
@@ -1024,32 +1055,12 @@ static void ExpandHllCalls(char *line, struct asm_tok tokenarray[], bool inParam
 
 static bool PossibleCallExpansion(struct asm_tok tokenarray[])
 {
-	bool result = FALSE;
-	bool gotOp = FALSE;
-	bool gotCl = FALSE;
-	int i = 0;
-	for (i = 0;i < Token_Count;i++)
-	{
-		if (tokenarray[i].token == T_POINTER)
-		{
-			result = TRUE;
-			break;
-		}
-		if (tokenarray[i].token == T_OP_BRACKET && i > 0)
-		{
-			if (tokenarray[i - 1].token == T_ID)
-			{
-				gotOp = TRUE;
-			}
-		}
-		if (tokenarray[i].token == T_CL_BRACKET)
-			gotCl = TRUE;
-	}
+	/* v2.52: the items are noted by Tokenize() */
+	uint_8 flags = tokenarray[Token_Count].bytval;
 
-	if (gotOp && gotCl)
-		result = TRUE;
-
-	return(result);
+	if (flags & TF3_POINTER)
+		return(TRUE);
+	return((flags & (TF3_IDBRACKET | TF3_CLBRACKET)) == (TF3_IDBRACKET | TF3_CLBRACKET));
 }
 
 /*
@@ -1062,6 +1073,10 @@ void EvaluatePreprocessItems(char *line, struct asm_tok tokenarray[])
 	struct dsym *recsym;
 	struct expr opndx[1];
 
+	/* v2.52: inline records are evaluated inside procedures only */
+	if (CurrProc == NULL)
+		return;
+
 	memset(&opndx, 0, sizeof(opndx));
 
 	/* pre parse inline records and c-style procedure calls UASM v2.46 */
@@ -1073,7 +1088,7 @@ void EvaluatePreprocessItems(char *line, struct asm_tok tokenarray[])
 			recsym = SymCheck(tokenarray[i].string_ptr);
 			if (recsym && recsym->sym.typekind == TYPE_RECORD && CurrProc)
 			{
-				if (CurrSeg && (strcmp(CurrSeg->sym.name, "_TEXT") == 0 || strcmp(CurrSeg->sym.name, "_flat") == 0))
+				if (CurrSeg && CurrSeg->e.seginfo->hllcode)
 				{
 					if (EvalOperand(&i, tokenarray, Token_Count, &opndx[0], 0) == ERROR)
 						EmitErr(INVALID_INSTRUCTION_OPERANDS);
@@ -1085,6 +1100,428 @@ void EvaluatePreprocessItems(char *line, struct asm_tok tokenarray[])
 	}
 }
 
+/* v2.52: lazy declarations ( option -lazyinc ).
+ * Declaration-only lines of include files ( PROTO, EXTERNDEF, TYPEDEF,
+ * numeric EQU, STRUCT/UNION ) aren't parsed when they are read. Instead,
+ * the lines are saved and indexed by the name they define. The declaration
+ * is parsed when the name is first found in a line. Thus a module pays only
+ * for the declarations it actually references, and unused EXTERNDEF/PROTO
+ * items never become symbols that PassOneChecks() has to remove again.
+ * The segment and the options that affect a declaration ( language,
+ * offset size, OPTION DLLIMPORT, FIELDALIGN, RADIX, CASEMAP, DOTNAME,
+ * M510 ) are restored when it is parsed, and TAB_EXT is sorted in
+ * declaration order, so the object module is the same as without the
+ * option. Just equates with a plain number are indexed; the value of an
+ * expression may depend on symbols that are redefined later.
+ */
+
+#define LAZY_HASH_SIZE 4093
+
+struct lazy_line {
+    struct lazy_line *next;
+    char line[1];
+};
+
+/* context of a declaration */
+struct lazy_state {
+    struct dsym *seg;
+#if DLLIMPORT
+    struct dll_desc *dll;
+#endif
+    uint_8  Ofssize;
+    uint_8  langtype;
+    uint_8  fieldalign;
+    uint_8  radix;
+    uint_8  case_sensitive:1;
+    uint_8  convert_uppercase:1;
+    uint_8  dotname:1;
+    uint_8  m510:1;
+};
+
+struct lazy_decl {
+    struct lazy_decl *nextitem; /* next item in hash chain */
+    struct lazy_line *head;     /* lines of the declaration */
+    struct lazy_line *tail;
+    uint_32 lineno;             /* location of the declaration */
+    uint_16 srcfile;
+    struct lazy_state state;    /* context of the declaration */
+    uint_32 ext_order;          /* TAB_EXT order of PROTO/EXTERNDEF */
+    uint_8  done;               /* declaration has been parsed */
+    uint_8  name_size;
+    char    name[1];
+};
+
+static struct lazy_decl *lazy_table[LAZY_HASH_SIZE];
+static struct lazy_decl *lazy_capture; /* STRUCT/UNION whose lines are collected */
+static int  lazy_level;                /* nesting level of STRUCT/UNION */
+static bool lazy_skip;                 /* pass > 1: struct lines are just skipped */
+static uint_32 cntLazyDecl;            /* number of indexed declarations */
+static uint_32 cntLazyDone;            /* number of parsed declarations */
+static bool lazy_ext;                  /* an external has been created */
+static struct lazy_decl *lazy_last;    /* declaration indexed by LazyDeclIndex() */
+
+static struct lazy_decl *LazyDeclFind( const char *name )
+/*******************************************************/
+{
+    unsigned h;
+    int len;
+    const char *p;
+    struct lazy_decl *ld;
+
+    for ( h = 0, p = name; *p; p++ )
+        h = h * 31 + ( *p | ' ' );
+    len = p - name;
+    for ( ld = lazy_table[h % LAZY_HASH_SIZE]; ld; ld = ld->nextitem )
+        if ( ld->name_size == len && SymCmpFunc( ld->name, name, len ) == 0 )
+            return( ld );
+    return( NULL );
+}
+
+static void LazyStateGet( struct lazy_state *ls )
+/**********************************************/
+{
+    ls->seg = CurrSeg;
+#if DLLIMPORT
+    ls->dll = ModuleInfo.CurrDll;
+#endif
+    ls->Ofssize = ModuleInfo.Ofssize;
+    ls->langtype = ModuleInfo.langtype;
+    ls->fieldalign = ModuleInfo.fieldalign;
+    ls->radix = ModuleInfo.radix;
+    ls->case_sensitive = ModuleInfo.case_sensitive;
+    ls->convert_uppercase = ModuleInfo.convert_uppercase;
+    ls->dotname = ModuleInfo.dotname;
+    ls->m510 = ModuleInfo.m510;
+}
+
+static void LazyStateSet( const struct lazy_state *ls )
+/*****************************************************/
+{
+    CurrSeg = ls->seg;
+#if DLLIMPORT
+    ModuleInfo.CurrDll = ls->dll;
+#endif
+    ModuleInfo.Ofssize = ls->Ofssize;
+    ModuleInfo.langtype = ls->langtype;
+    ModuleInfo.fieldalign = ls->fieldalign;
+    ModuleInfo.radix = ls->radix;
+    if ( ModuleInfo.case_sensitive != ls->case_sensitive ) {
+        ModuleInfo.case_sensitive = ls->case_sensitive;
+        SymSetCmpFunc();
+    }
+    ModuleInfo.convert_uppercase = ls->convert_uppercase;
+    ModuleInfo.dotname = ls->dotname;
+    ModuleInfo.m510 = ls->m510;
+}
+
+static void LazyDeclAddLine( struct lazy_decl *ld, const char *line )
+/*******************************************************************/
+{
+    int i = strlen( line );
+    struct lazy_line *ll = LclAlloc( sizeof( struct lazy_line ) + i );
+
+    ll->next = NULL;
+    memcpy( ll->line, line, i + 1 );
+    if ( ld->head )
+        ld->tail->next = ll;
+    else
+        ld->head = ll;
+    ld->tail = ll;
+}
+
+static struct lazy_decl *LazyDeclAdd( const char *name )
+/******************************************************/
+{
+    unsigned h;
+    int len = strlen( name );
+    const char *p;
+    struct lazy_decl *ld = LclAlloc( sizeof( struct lazy_decl ) + len );
+
+    for ( h = 0, p = name; *p; p++ )
+        h = h * 31 + ( *p | ' ' );
+    ld->head = NULL;
+    ld->tail = NULL;
+    ld->lineno = GetLineNumber();
+    ld->srcfile = get_curr_srcfile();
+    LazyStateGet( &ld->state );
+    ld->ext_order = 0;
+    ld->done = FALSE;
+    ld->name_size = len;
+    memcpy( ld->name, name, len + 1 );
+    ld->nextitem = lazy_table[h % LAZY_HASH_SIZE];
+    lazy_table[h % LAZY_HASH_SIZE] = ld;
+    cntLazyDecl++;
+    return( ld );
+}
+
+/* parse the lines of a declaration.
+ * this is done like RunLineQueue() does it, but without using the
+ * line queue, which may contain lines of the current statement.
+ */
+
+static void LazyDeclParse( struct lazy_decl *ld )
+/***********************************************/
+{
+    struct input_status oldstat;
+    struct asm_tok *tokenarray;
+    struct dsym *oldstruct = CurrStruct;
+    enum proc_status oldstatus = ProcStatus;
+    struct lazy_state oldstate;
+    struct lazy_line *ll;
+    struct asym *sym;
+
+    DebugMsg1(("LazyDeclParse(%s) enter\n", ld->name ));
+    ld->done = TRUE;
+    cntLazyDone++;
+    tokenarray = PushInputStatus( &oldstat );
+    ModuleInfo.GeneratedCode++;
+    /* the declaration isn't part of a struct that's currently defined,
+     * and it must not trigger the prologue of the current procedure.
+     */
+    CurrStruct = NULL;
+    ProcStatus = 0;
+    LazyStateGet( &oldstate );
+    LazyStateSet( &ld->state );
+    for ( ll = ld->head; ll; ll = ll->next ) {
+        strcpy( CurrSource, ll->line );
+        if ( PreprocessLine( CurrSource, tokenarray ) )
+            ParseLine( tokenarray );
+    }
+    CurrStruct = oldstruct;
+    ProcStatus = oldstatus;
+    LazyStateSet( &oldstate );
+    ModuleInfo.GeneratedCode--;
+    PopInputStatus( &oldstat );
+
+    /* the external takes the place it had without -lazyinc */
+    if ( ld->ext_order && ( sym = SymSearch( ld->name ) ) && sym->state == SYM_EXTERNAL ) {
+        sym->ext_order = ld->ext_order;
+        lazy_ext = TRUE;
+    }
+}
+
+/* parse pending declarations of names used in a line */
+
+static void LazyDeclScan( struct asm_tok tokenarray[] )
+/*****************************************************/
+{
+    int i;
+    struct lazy_decl *ld;
+
+    for ( i = 0; i < Token_Count && cntLazyDone < cntLazyDecl; i++ )
+        if ( tokenarray[i].token == T_ID &&
+            ( ld = LazyDeclFind( tokenarray[i].string_ptr ) ) && ld->done == FALSE )
+            LazyDeclParse( ld );
+}
+
+/* is token a STRUCT/UNION or ENDS directive? */
+
+static int LazyStructLevel( const struct asm_tok *tok )
+/*****************************************************/
+{
+    if ( tok->token == T_DIRECTIVE )
+        switch ( tok->tokval ) {
+        case T_STRUC:
+        case T_STRUCT:
+        case T_UNION:
+            return( 1 );
+        case T_ENDS:
+            return( -1 );
+        }
+    return( 0 );
+}
+
+/* index the declaration of name in line; ext: the line may create an
+ * external. returns TRUE if the line has been consumed.
+ */
+
+static bool LazyDeclIndex( const char *name, const char *line, bool ext )
+/***********************************************************************/
+{
+    struct lazy_decl *ld;
+
+    if ( ld = LazyDeclFind( name ) ) {
+        /* another declaration of the same name is handled as usual,
+         * after the first one has been parsed. In pass one, this is
+         * also true if the file is included once more.
+         */
+        if ( Parse_Pass == PASS_1 || ld->srcfile != get_curr_srcfile() || ld->lineno != GetLineNumber() ) {
+            if ( ld->done == FALSE )
+                LazyDeclParse( ld );
+            return( FALSE );
+        }
+        /* pass > 1: the declaration has been indexed already */
+        lazy_skip = TRUE;
+    } else {
+        if ( Parse_Pass != PASS_1 || SymSearch( name ) )
+            return( FALSE );
+        DebugMsg1(("LazyDeclIndex(%s): declaration indexed\n", name ));
+        ld = LazyDeclAdd( name );
+        LazyDeclAddLine( ld, line );
+        if ( ext )
+            ld->ext_order = ++ExtOrder;
+        lazy_skip = FALSE;
+    }
+    lazy_last = ld;
+    return( TRUE );
+}
+
+/* check if a line is a declaration that is to be indexed.
+ * returns TRUE if the line has been consumed.
+ */
+
+static bool LazyDeclLine( const char *line, struct asm_tok tokenarray[] )
+/***********************************************************************/
+{
+    int i;
+    struct lazy_decl *ld;
+    const char *name;
+    enum lang_type langtype;
+
+    /* collecting the lines of a STRUCT/UNION? */
+    if ( lazy_capture ) {
+        if ( lazy_skip == FALSE )
+            LazyDeclAddLine( lazy_capture, line );
+        lazy_level += LazyStructLevel( &tokenarray[0] );
+        if ( Token_Count > 1 )
+            lazy_level += LazyStructLevel( &tokenarray[1] );
+        if ( lazy_level == 0 )
+            lazy_capture = NULL;
+        return( TRUE );
+    }
+    if ( ModuleInfo.GeneratedCode || MacroLevel || CurrIfState != BLOCK_ACTIVE ||
+        CurrStruct || Options.preprocessor_stdout || Token_Count < 2 ||
+        get_curr_srcfile() == ModuleInfo.srcfile )
+        return( FALSE );
+
+    /* EXTERNDEF [lang] name:type with a single name */
+    if ( tokenarray[0].token == T_DIRECTIVE && tokenarray[0].tokval == T_EXTERNDEF ) {
+        i = 1;
+        GetLangType( &i, tokenarray, &langtype );
+        if ( tokenarray[i].token != T_ID || tokenarray[i+1].token != T_COLON )
+            return( FALSE );
+        name = tokenarray[i].string_ptr;
+        if ( tokenarray[i+2].token != T_DIRECTIVE || tokenarray[i+2].tokval != T_PROTO )
+            for ( i += 2; i < Token_Count; i++ )
+                if ( tokenarray[i].token == T_COMMA )
+                    return( FALSE );
+        return( LazyDeclIndex( name, line, TRUE ) );
+    }
+
+    if ( tokenarray[0].token != T_ID || tokenarray[1].token != T_DIRECTIVE )
+        return( FALSE );
+
+    switch ( tokenarray[1].tokval ) {
+    case T_PROTO:
+    case T_TYPEDEF:
+        break;
+    case T_STRUC:
+    case T_STRUCT:
+    case T_UNION:
+        /* with OLDSTRUCTS, struct fields are global names */
+        if ( ModuleInfo.oldstructs )
+            return( FALSE );
+        break;
+    case T_EQU:
+        /* just equates with a plain, optionally signed, number */
+        i = 2;
+        if ( tokenarray[i].token == '+' || tokenarray[i].token == '-' )
+            i++;
+        if ( tokenarray[i].token != T_NUM || i + 1 != Token_Count )
+            return( FALSE );
+        break;
+    default:
+        return( FALSE );
+    }
+    if ( LazyDeclIndex( tokenarray[0].string_ptr, line, tokenarray[1].tokval == T_PROTO ) == FALSE )
+        return( FALSE );
+    if ( LazyStructLevel( &tokenarray[1] ) > 0 ) {
+        lazy_capture = lazy_last;
+        lazy_level = 1;
+    }
+    return( TRUE );
+}
+
+void LazyDeclInit( void )
+/***********************/
+{
+    memset( lazy_table, 0, sizeof( lazy_table ) );
+    lazy_capture = NULL;
+    lazy_ext = FALSE;
+    cntLazyDecl = 0;
+    cntLazyDone = 0;
+}
+
+/* sort TAB_EXT by ext_order ( called by PassOneChecks() ).
+ * externals of lazy declarations are added when they are first
+ * referenced; here they get the position of their declaration.
+ */
+
+void LazyDeclSortExt( void )
+/**************************/
+{
+    struct dsym *curr;
+    struct dsym *next;
+    struct dsym *p;
+    struct symbol_queue sorted = { NULL, NULL };
+
+    if ( lazy_ext == FALSE )
+        return;
+    lazy_ext = FALSE;
+    for ( curr = SymTables[TAB_EXT].head; curr; curr = next ) {
+        next = curr->next;
+        /* items are mostly in order, so search from the tail */
+        for ( p = sorted.tail; p && p->sym.ext_order > curr->sym.ext_order; p = p->prev );
+        curr->prev = p;
+        if ( p ) {
+            curr->next = p->next;
+            p->next = curr;
+        } else {
+            curr->next = sorted.head;
+            sorted.head = curr;
+        }
+        if ( curr->next )
+            curr->next->prev = curr;
+        else
+            sorted.tail = curr;
+    }
+    SymTables[TAB_EXT] = sorted;
+}
+
+/* display number of declarations parsed ( -stats ) */
+
+void LazyDeclStats( void )
+/************************/
+{
+    if ( cntLazyDecl )
+        printf( "lazy declarations: %" I32_SPEC "u indexed, %" I32_SPEC "u parsed\n", cntLazyDecl, cntLazyDone );
+}
+
+/* v2.52: -hllopt, check if a line may be stored for further passes. Lines
+ * which are handled by the preprocessor only, and macro calls, don't end
+ * the jump optimization, since it must not depend on whether pass two
+ * reads the stored lines ( FASTPASS ) or the source.
+ */
+static bool IsStoredLine( struct asm_tok tokenarray[] )
+/*****************************************************/
+{
+    struct asym *sym;
+
+    if ( CurrIfState != BLOCK_ACTIVE )
+        return( FALSE );
+    if ( tokenarray[0].token == T_DIRECTIVE && tokenarray[0].dirtype <= DRT_INCLUDE )
+        return( FALSE );
+    if ( tokenarray[0].token == T_ID ) {
+        if ( tokenarray[1].token == T_DIRECTIVE &&
+            ( tokenarray[1].dirtype == DRT_MACRO || tokenarray[1].dirtype == DRT_CATSTR || tokenarray[1].dirtype == DRT_SUBSTR ) )
+            return( FALSE );
+        sym = SymSearch( tokenarray[0].string_ptr );
+        if ( sym && sym->state == SYM_MACRO && sym->isfunc == FALSE )
+            return( FALSE );
+    }
+    return( TRUE );
+}
+
 /* PreprocessLine() is the "preprocessor".
  * 1. the line is tokenized with Tokenize(), Token_Count set
  * 2. (text) macros are expanded by ExpandLine()
@@ -1123,16 +1560,33 @@ int PreprocessLine( char *line, struct asm_tok tokenarray[] )
     if ( Token_Count == 0 )
         return( 0 );
 
+    /* v2.52: -hllopt, run the code kept back by a preceding hll directive
+     * and tokenize the line again; the generated lines must not run while
+     * the line is processed ( a code label preceding a macro call is parsed
+     * separately ).
+     */
+    if ( Options.hll_optimize && IsStoredLine( tokenarray ) && HllFlush( tokenarray ) )
+        Token_Count = Tokenize( line, 0, tokenarray, TOK_DEFAULT );
+
 #ifdef DEBUG_OUT
     /* option -np, skip preprocessor? */
     if ( Options.skip_preprocessor )
         return( Token_Count );
 #endif
 
+    /* v2.52: index declarations, parse those that are referenced */
+    if ( Options.lazy_include ) {
+        if ( LazyDeclLine( line, tokenarray ) )
+            return( 0 );
+        if ( cntLazyDone < cntLazyDecl )
+            LazyDeclScan( tokenarray );
+    }
+
 	if (!Options.nomlib && Options.hlcall)
 	{
 		// Hll and Object style call expansion is only valid inside a code section, AND if the line contains ( ) or ->.
-		if (CurrSeg && (strcmp(CurrSeg->sym.name, "_TEXT") == 0 || strcmp(CurrSeg->sym.name, "_flat") == 0) && PossibleCallExpansion( tokenarray ))
+		// v2.52: not with -EP, the variables and procs aren't known then.
+		if (CurrSeg && CurrSeg->e.seginfo->hllcode && !Options.preprocessor_stdout && PossibleCallExpansion( tokenarray ))
 		{
 			strcpy(&cline, line);
 			ExpandStaticObjCalls(&cline, tokenarray);
@@ -1165,6 +1619,9 @@ int PreprocessLine( char *line, struct asm_tok tokenarray[] )
 	{
         if ( ( tokenarray[Token_Count].bytval & TF3_EXPANSION ? ExpandText( line, tokenarray, TRUE ) : ExpandLine( line, tokenarray ) ) < NOT_ERROR )
             return( 0 );
+        /* v2.52: names may have been introduced by the expansion */
+        if ( cntLazyDone < cntLazyDecl )
+            LazyDeclScan( tokenarray );
     }
 
     DebugCmd( cntppl1++ );
@@ -1216,7 +1673,8 @@ int PreprocessLine( char *line, struct asm_tok tokenarray[] )
 #endif
                     if ( Options.preprocessor_stdout == TRUE )
                         WritePreprocessedLine( line );
-                }
+                } else if ( Options.preprocessor_stdout == TRUE )
+                    WriteTextMacro( sym );
                 /* v2.03: LstWrite() must be called AFTER StoreLine()! */
                 if ( ModuleInfo.list == TRUE ) {
                     LstWrite( sym->state == SYM_INTERNAL ? LSTTYPE_EQUATE : LSTTYPE_TMACRO, 0, sym );
@@ -1224,9 +1682,14 @@ int PreprocessLine( char *line, struct asm_tok tokenarray[] )
             }
             return( 0 );
         case DRT_MACRO:
+            directive_tab[tokenarray[1].dirtype]( 1, tokenarray );
+            return( 0 );
         case DRT_CATSTR: /* CATSTR + TEXTEQU directives */
         case DRT_SUBSTR:
-            directive_tab[tokenarray[1].dirtype]( 1, tokenarray );
+            if ( directive_tab[tokenarray[1].dirtype]( 1, tokenarray ) == NOT_ERROR &&
+                Options.preprocessor_stdout == TRUE &&
+                ( sym = SymSearch( tokenarray[0].string_ptr ) ) && sym->state == SYM_TMACRO )
+                WriteTextMacro( sym );
             return( 0 );
         }
     }
@@ -1235,3 +1698,86 @@ int PreprocessLine( char *line, struct asm_tok tokenarray[] )
     return( Token_Count );
 }
 
+/* v2.52: handle a line which has passed the preprocessor.
+ * If -EP is set, the line is written to the output at once. No code or
+ * data is generated and code or data labels aren't defined; of the
+ * directives which aren't handled by PreprocessLine(), just those are
+ * executed which may affect conditional assembly or expansion: types,
+ * externals, segments, LABEL and data labels are declared, so SIZEOF,
+ * TYPE or IFDEF know them. Thus one pass is sufficient and nothing has to be stored
+ * for further passes.
+ */
+void ParsePreprocessedLine( char *line, struct asm_tok tokenarray[] )
+/*******************************************************************/
+{
+    int i;
+    struct asym *sym;
+
+    if ( Options.preprocessor_stdout == FALSE ) {
+        ParseLine( tokenarray );
+        return;
+    }
+    /* the members of a STRUCT/UNION are defined */
+    if ( CurrStruct ) {
+        ParseLine( tokenarray );
+        WritePreprocessedLine( line );
+        return;
+    }
+    /* USE16, USE32 and USE64 change the offset size of the current segment */
+    if ( tokenarray[0].token == T_ID && Token_Count == 1 &&
+        ( _stricmp( tokenarray[0].string_ptr, "use16" ) == 0 ||
+         _stricmp( tokenarray[0].string_ptr, "use32" ) == 0 ||
+         _stricmp( tokenarray[0].string_ptr, "use64" ) == 0 ) ) {
+        ParseLine( tokenarray );
+        WritePreprocessedLine( line );
+        return;
+    }
+    /* a data label gets its type and size, for TYPE, SIZEOF, LENGTHOF, ... */
+    if ( CurrSeg && tokenarray[0].token == T_ID &&
+        ( ( tokenarray[1].token == T_DIRECTIVE && tokenarray[1].dirtype == DRT_DATADIR ) ||
+         tokenarray[1].token == T_STYPE ||
+         ( tokenarray[1].token == T_ID && ( sym = SymSearch( tokenarray[1].string_ptr ) ) && sym->state == SYM_TYPE ) ) ) {
+        DebugMsg1(("ParsePreprocessedLine: data label >%s<\n", tokenarray[0].string_ptr ));
+        ParseLine( tokenarray );
+        WritePreprocessedLine( line );
+        return;
+    }
+    /* a directive preceded by a code label isn't executed */
+    i = ( tokenarray[1].token == T_DIRECTIVE ? 1 : 0 );
+    if ( tokenarray[i].token == T_DIRECTIVE ) {
+        switch ( tokenarray[i].dirtype ) {
+        case DRT_END:
+            ModuleInfo.EndDirFound = TRUE;
+            break;
+        case DRT_ERRDIR:
+        case DRT_CPU:
+        case DRT_MODEL:
+        case DRT_RADIX:
+        case DRT_INSTR:
+        case DRT_SIZESTR:
+        case DRT_EQUALSGN:
+        case DRT_OPTION:
+        case DRT_DEFINE:
+        case DRT_UNDEF:
+        /* types and externals may be queried by SIZEOF, TYPE, IFDEF, ... */
+        case DRT_STRUCT:
+        case DRT_CSTRUCT:
+        case DRT_COMSTRUCT:
+        case DRT_RAWSTRUCT:
+        case DRT_RECORD:
+        case DRT_TYPEDEF:
+        case DRT_PROTO:
+        case DRT_EXTERN:
+        case DRT_EXTERNDEF:
+        /* segments are opened for LABEL, the offset is meaningless */
+        case DRT_SEGMENT:
+        case DRT_ENDS:
+        case DRT_SIMSEG:
+        case DRT_LABEL:
+            DebugMsg1(("ParsePreprocessedLine: execute >%s<\n", tokenarray[0].tokpos ));
+            ParseLine( tokenarray );
+            break;
+        }
+    }
+    WritePreprocessedLine( line );
+}
@@ -34,6 +34,7 @@
 #if AMD64_SUPPORT
 #include "win64seh.h"
 #endif
+#include "mca.h"
 
 #ifdef __I86__
 #define NUMQUAL (long)
@@ -1565,7 +1566,7 @@ ret_code ParseProc(struct dsym *proc, int i, struct asm_tok tokenarray[], bool I
 				/* error if there was a PUBLIC directive! */
 				proc->sym.scoped = TRUE;
 				if (oldpublic) {
-					SkipSavedState(); /* do a full pass-2 scan */
+					SkipSavedState( FPS_PROC_PRIVATE, proc->sym.name ); /* do a full pass-2 scan */
 				}
 #endif
 				proc->e.procinfo->isexport = FALSE;
@@ -1794,6 +1795,9 @@ struct asym *CreateProc(struct asym *sym, const char *name, enum sym_state state
 		info->localsize = 0;
 		info->prologuearg = NULL;
 		info->flags = 0;
+		info->foldto = NULL;
+		info->foldable = FALSE;
+		info->order = NULL;
 		info->ret_type = 0xff;
 		switch (sym->state) {
 		case SYM_INTERNAL:
@@ -1863,6 +1867,622 @@ void DeleteProc(struct dsym *proc)
 	return;
 }
 
+/* v2.52: identical code folding ( option -icf ).
+* Once the passes have converged, a proc whose code and fixups are identical
+* to those of a proc defined before it in the same segment is folded. In the
+* following passes, the code of a folded proc is generated at the location of
+* the other proc, so it's removed from the segment; its labels get the
+* addresses of the matching labels in the other proc. The code is compared
+* with what's already there and its fixups aren't stored. If the code turns
+* out to differ, the proc is unfolded and another pass is done.
+* Only procs ending with RET, IRET or JMP are folded, and in object modules
+* only procs that aren't public.
+*/
+
+#define FOLD_HASH_SIZE 1021
+
+struct fold_item {
+	struct fold_item    *next;      /* next item in hash chain */
+	struct dsym         *proc;
+	struct fixup        **fixups;   /* fixups inside the proc, sorted by location */
+	unsigned            numfixups;
+	uint_32             hash;
+	bool                invalid;    /* proc overlaps another proc */
+};
+
+static bool             fold_done;      /* folding is done once per module */
+static struct dsym      *xfer_seg;      /* segment of the last RET/IRET/JMP */
+static uint_32          xfer_end;       /* offset behind the last RET/IRET/JMP */
+static struct dsym      *fold_seg;      /* segment of the folded proc currently generated */
+static uint_32          fold_resume;    /* offset where code continues after ENDP */
+static uint_32          fold_size;      /* size of the proc folded to */
+static uint_8           *fold_image;    /* code of the proc folded to */
+
+/* unfold a proc; it will be generated at its own location */
+static void FoldUndo(struct dsym *proc)
+/*************************************/
+{
+	proc->e.procinfo->foldto = NULL;
+	ModuleInfo.PhaseError = TRUE;
+}
+
+/* move the labels of a folded proc to the matching addresses in the
+* proc it's folded to.
+*/
+static void FoldMoveLabels(struct dsym *proc)
+/********************************************/
+{
+	struct asym *sym;
+	uint_32 start = proc->sym.offset;
+	uint_32 end = start + proc->sym.total_size;
+	uint_32 target = proc->e.procinfo->foldto->sym.offset;
+
+	for (sym = ((struct dsym *)proc->sym.segment)->e.seginfo->label_list; sym; sym = (struct asym *)((struct dsym *)sym)->next)
+		if (sym->state == SYM_INTERNAL && sym->offset >= start && sym->offset < end)
+			sym->offset = sym->offset - start + target;
+}
+
+/* an instruction has been encoded inside a proc. A proc may be folded
+* only if its code ends with an instruction that doesn't continue with
+* the next one; else the code following the proc would be executed
+* after the code of the proc folded to.
+*/
+void FoldInstr(unsigned token)
+/******************************/
+{
+	switch (token) {
+	case T_RET:
+	case T_RETN:
+	case T_RETF:
+	case T_IRET:
+	case T_IRETD:
+#if AMD64_SUPPORT
+	case T_IRETQ:
+#endif
+	case T_JMP:
+		xfer_seg = CurrSeg;
+		xfer_end = GetCurrOffset();
+		break;
+	}
+}
+
+static int compare_fold_items(const void *p1, const void *p2)
+/************************************************************/
+{
+	const struct dsym *proc1 = ((const struct fold_item *)p1)->proc;
+	const struct dsym *proc2 = ((const struct fold_item *)p2)->proc;
+
+	if (proc1->sym.segment != proc2->sym.segment)
+		return(((struct dsym *)proc1->sym.segment)->e.seginfo->seg_idx < ((struct dsym *)proc2->sym.segment)->e.seginfo->seg_idx ? -1 : 1);
+	return(proc1->sym.offset < proc2->sym.offset ? -1 : proc1->sym.offset > proc2->sym.offset);
+}
+
+static int compare_fixups(const void *p1, const void *p2)
+/********************************************************/
+{
+	uint_32 ofs1 = (*(const struct fixup **)p1)->locofs;
+	uint_32 ofs2 = (*(const struct fixup **)p2)->locofs;
+	return(ofs1 < ofs2 ? -1 : ofs1 > ofs2);
+}
+
+static bool InsideProc(const struct asym *sym, const struct dsym *proc)
+/*********************************************************************/
+{
+	return(sym && sym->state == SYM_INTERNAL && sym->segment == proc->sym.segment &&
+		sym->offset >= proc->sym.offset &&
+		sym->offset < proc->sym.offset + proc->sym.total_size);
+}
+
+/* compare two fixups. Targets inside the procs must be at the same
+* relative position, targets outside must be the same symbol.
+*/
+static bool FixupsEqual(const struct fixup *fix1, const struct dsym *proc1, const struct fixup *fix2, const struct dsym *proc2)
+/******************************************************************************************************************************/
+{
+	if (fix1->locofs - proc1->sym.offset != fix2->locofs - proc2->sym.offset ||
+		fix1->type != fix2->type ||
+		fix1->option != fix2->option ||
+		fix1->flags != fix2->flags ||
+		fix1->offset != fix2->offset ||
+		fix1->frame_type != fix2->frame_type ||
+		fix1->frame_datum != fix2->frame_datum)
+		return(FALSE);
+	if ((fix1->sym && fix1->sym->variable) || (fix2->sym && fix2->sym->variable))
+		return(FALSE);
+	if (InsideProc(fix1->sym, proc1) || InsideProc(fix1->sym, proc2))
+		return(InsideProc(fix2->sym, proc2) &&
+			fix1->sym->offset - proc1->sym.offset == fix2->sym->offset - proc2->sym.offset);
+	return(fix1->sym == fix2->sym);
+}
+
+static bool FoldItemsEqual(const struct fold_item *item1, const struct fold_item *item2)
+/**************************************************************************************/
+{
+	const struct dsym *proc1 = item1->proc;
+	const struct dsym *proc2 = item2->proc;
+	const struct seg_info *si = ((struct dsym *)proc1->sym.segment)->e.seginfo;
+	unsigned i;
+
+	if (item1->hash != item2->hash ||
+		proc1->sym.segment != proc2->sym.segment ||
+		proc1->sym.total_size != proc2->sym.total_size ||
+		item1->numfixups != item2->numfixups)
+		return(FALSE);
+	if (memcmp(si->CodeBuffer + (proc1->sym.offset - si->start_loc),
+		si->CodeBuffer + (proc2->sym.offset - si->start_loc), proc1->sym.total_size))
+		return(FALSE);
+	for (i = 0; i < item1->numfixups; i++)
+		if (!FixupsEqual(item1->fixups[i], proc1, item2->fixups[i], proc2))
+			return(FALSE);
+	return(TRUE);
+}
+
+/* find procs with identical code, called after the passes have converged.
+* returns the number of procs that have been folded; if it's > 0,
+* more passes are needed.
+*/
+unsigned FoldProcs(void)
+/************************/
+{
+	struct dsym *proc;
+	struct dsym *seg;
+	struct seg_info *si;
+	struct fold_item *items;
+	struct fold_item *item;
+	struct fold_item *curr;
+	struct fold_item **table;
+	struct fixup **fixups;
+	struct fixup *fix;
+	unsigned numitems;
+	unsigned numfixups;
+	unsigned first;
+	unsigned folded = 0;
+	unsigned i, j;
+	uint_32 maxend;
+	uint_8 *p;
+
+	if (fold_done)
+		return(0);
+	fold_done = TRUE;
+
+	/* folding would duplicate line numbers, debug info and OMF data records */
+	if (write_to_file == FALSE || Options.output_format == OFORMAT_OMF ||
+		Options.line_numbers || Options.debug_symbols)
+		return(0);
+
+	for (numitems = 0, proc = SymTables[TAB_PROC].head; proc; proc = proc->nextproc, numitems++);
+	if (numitems < 2)
+		return(0);
+	items = MemAlloc(numitems * sizeof(struct fold_item));
+
+	/* collect the candidates */
+	for (numitems = 0, proc = SymTables[TAB_PROC].head; proc; proc = proc->nextproc) {
+		if (proc->sym.state != SYM_INTERNAL || proc->sym.isdefined == FALSE ||
+			proc->sym.segment == NULL || proc->sym.total_size == 0 ||
+			proc->e.procinfo->foldable == FALSE)
+			continue;
+		/* in object modules, the addresses of public procs may be compared */
+		if (proc->sym.ispublic && Options.output_format != OFORMAT_BIN)
+			continue;
+#if AMD64_SUPPORT
+		/* the unwind data of FRAME procs can't be shared ( COFF only, see WriteSEHData() ) */
+		if (proc->e.procinfo->isframe && Options.output_format == OFORMAT_COFF)
+			continue;
+#endif
+		si = ((struct dsym *)proc->sym.segment)->e.seginfo;
+		if (si->CodeBuffer == NULL || si->internal ||
+			proc->sym.offset < si->start_loc ||
+			proc->sym.offset + proc->sym.total_size > proc->sym.segment->max_offset)
+			continue;
+		items[numitems].proc = proc;
+		items[numitems].fixups = NULL;
+		items[numitems].numfixups = 0;
+		items[numitems].invalid = FALSE;
+		numitems++;
+	}
+	qsort(items, numitems, sizeof(struct fold_item), compare_fold_items);
+
+	/* nested procs aren't folded */
+	for (i = 0, j = 0, maxend = 0; i < numitems; i++) {
+		proc = items[i].proc;
+		if (i && proc->sym.segment == items[i - 1].proc->sym.segment && proc->sym.offset < maxend) {
+			items[i].invalid = TRUE;
+			items[j].invalid = TRUE;
+		}
+		if (i == 0 || proc->sym.segment != items[i - 1].proc->sym.segment || proc->sym.offset + proc->sym.total_size > maxend) {
+			maxend = proc->sym.offset + proc->sym.total_size;
+			j = i;
+		}
+	}
+
+	/* assign the fixups of each segment to the procs */
+	for (numfixups = 0, seg = SymTables[TAB_SEG].head; seg; seg = seg->next)
+		for (fix = seg->e.seginfo->FixupList.head; fix; fix = fix->nextrlc, numfixups++);
+	fixups = MemAlloc((numfixups + 1) * sizeof(struct fixup *));
+	for (i = 0, numfixups = 0; i < numitems; ) {
+		seg = (struct dsym *)items[i].proc->sym.segment;
+		first = numfixups;
+		for (fix = seg->e.seginfo->FixupList.head; fix; fix = fix->nextrlc)
+			fixups[numfixups++] = fix;
+		qsort(&fixups[first], numfixups - first, sizeof(struct fixup *), compare_fixups);
+		for (j = first; i < numitems && items[i].proc->sym.segment == &seg->sym; i++) {
+			proc = items[i].proc;
+			while (j < numfixups && fixups[j]->locofs < proc->sym.offset)
+				j++;
+			items[i].fixups = &fixups[j];
+			while (j < numfixups && fixups[j]->locofs < proc->sym.offset + proc->sym.total_size) {
+				items[i].numfixups++;
+				j++;
+			}
+		}
+	}
+
+	/* hash code and fixups, look for a proc with the same code */
+	table = MemAlloc(FOLD_HASH_SIZE * sizeof(struct fold_item *));
+	memset(table, 0, FOLD_HASH_SIZE * sizeof(struct fold_item *));
+	for (i = 0; i < numitems; i++) {
+		item = &items[i];
+		if (item->invalid)
+			continue;
+		proc = item->proc;
+		si = ((struct dsym *)proc->sym.segment)->e.seginfo;
+		item->hash = 2166136261u ^ proc->sym.total_size ^ (item->numfixups << 24);
+		for (p = si->CodeBuffer + (proc->sym.offset - si->start_loc), j = proc->sym.total_size; j; j--, p++)
+			item->hash = (item->hash ^ *p) * 16777619u;
+		for (curr = table[item->hash % FOLD_HASH_SIZE]; curr; curr = curr->next)
+			if (FoldItemsEqual(curr, item))
+				break;
+		if (curr) {
+			DebugMsg(("FoldProcs: %s folded to %s, size=%" I32_SPEC "u\n", proc->sym.name, curr->proc->sym.name, proc->sym.total_size));
+			proc->e.procinfo->foldto = curr->proc;
+			folded++;
+		} else {
+			item->next = table[item->hash % FOLD_HASH_SIZE];
+			table[item->hash % FOLD_HASH_SIZE] = item;
+		}
+	}
+	MemFree(table);
+	/* move the labels now, so forward references in the next pass
+	* already get the addresses inside the proc folded to.
+	*/
+	for (i = 0; i < numitems; i++)
+		if (items[i].proc->e.procinfo->foldto)
+			FoldMoveLabels(items[i].proc);
+	MemFree(fixups);
+	MemFree(items);
+	return(folded);
+}
+
+/* start to generate the code of a folded proc at the location of the
+* proc it's folded to.
+*/
+static void FoldOverlayStart(struct dsym *proc)
+/**********************************************/
+{
+	struct dsym *target = proc->e.procinfo->foldto;
+	struct seg_info *si = CurrSeg->e.seginfo;
+
+	/* the proc folded to must have been generated in this pass */
+	if (target->sym.segment != &CurrSeg->sym || target->sym.asmpass != Parse_Pass || CurrProc) {
+		FoldUndo(proc);
+		return;
+	}
+	fold_seg = CurrSeg;
+	fold_resume = si->current_loc;
+	fold_size = target->sym.total_size;
+	if (write_to_file) {
+		fold_image = MemAlloc(fold_size);
+		memcpy(fold_image, si->CodeBuffer + (target->sym.offset - si->start_loc), fold_size);
+	}
+	si->current_loc = target->sym.offset;
+	si->overlay = TRUE;
+}
+
+/* ENDP of a folded proc: check the code, continue behind the PROC directive */
+static void FoldOverlayEnd(struct dsym *proc)
+/********************************************/
+{
+	struct seg_info *si = fold_seg->e.seginfo;
+
+	if (si->current_loc - proc->sym.offset != fold_size ||
+		(write_to_file && memcmp(fold_image, si->CodeBuffer + (proc->sym.offset - si->start_loc), fold_size))) {
+		/* the code differs. The buffer contents don't matter, there's another pass. */
+		DebugMsg(("FoldOverlayEnd(%s): code differs from %s\n", proc->sym.name, proc->e.procinfo->foldto->sym.name));
+		FoldUndo(proc);
+	}
+	if (fold_image) {
+		MemFree(fold_image);
+		fold_image = NULL;
+	}
+	si->current_loc = fold_resume;
+	si->overlay = FALSE;
+	fold_seg = NULL;
+}
+
+void FoldStats(void)
+/********************/
+{
+	struct dsym *proc;
+	uint_32 folded = 0;
+	uint_32 size = 0;
+
+	for (proc = SymTables[TAB_PROC].head; proc; proc = proc->nextproc)
+		if (proc->e.procinfo->foldto) {
+			folded++;
+			size += proc->sym.total_size;
+		}
+	if (folded)
+		printf("icf: %" I32_SPEC "u procedures folded, %" I32_SPEC "u bytes removed\n", folded, size);
+}
+
+/* v2.52: procedure ordering ( option -order, -bin and -pe only ).
+* The order file lists proc names, one per line. Once the passes have
+* converged, the code of each code segment is laid out anew: the code in
+* front of the first proc stays where it is, then follow the procs listed in
+* the order file, the other procs in source order and finally the code behind
+* the last proc. Code between two procs is moved along with the second one.
+* In the following passes, the segment offset is set to the new location at
+* PROC and ENDP, so labels, fixups and line numbers are generated for the new
+* layout ( a .pdata section is sorted by bin.c ). Sizes may change with the new positions; after a few layouts the
+* space reserved for a proc only grows and is padded if the code got smaller.
+*/
+
+#define ORDER_MAX_SHRINK 4  /* layouts where reserved space may shrink */
+
+struct order_item {
+	struct order_item   *next;      /* next item in source order */
+	struct dsym         *proc;
+	uint_32             seq;        /* position in source */
+	uint_32             rank;       /* line in order file, 0 if not listed */
+	uint_32             start;      /* offset at PROC in the current pass */
+	uint_32             end;        /* offset at ENDP in the current pass */
+	uint_32             ofs;        /* new offset of proc and code in front of it */
+	uint_32             size;       /* reserved size at <ofs> */
+	uint_32             resume;     /* new offset of the code behind ENDP */
+	uint_32             lead;       /* first proc of a segment: end of code in front of it */
+	bool                first;      /* first proc of a segment */
+};
+
+static struct order_item *order_head;   /* items of all top-level procs */
+static struct order_item *order_tail;
+static uint_32          order_seq;
+static bool             order_done;     /* order file has been read */
+static bool             order_active;   /* new layout is used */
+static unsigned         order_layouts;  /* number of layouts computed */
+static uint_32          order_listed;   /* procs found in the order file */
+static uint_32          order_missing;  /* names not found */
+
+static int compare_order_seq(const void *p1, const void *p2)
+/***********************************************************/
+{
+	const struct order_item *item1 = *(const struct order_item **)p1;
+	const struct order_item *item2 = *(const struct order_item **)p2;
+
+	if (item1->proc->sym.segment != item2->proc->sym.segment)
+		return(((struct dsym *)item1->proc->sym.segment)->e.seginfo->seg_idx < ((struct dsym *)item2->proc->sym.segment)->e.seginfo->seg_idx ? -1 : 1);
+	return(item1->seq < item2->seq ? -1 : item1->seq > item2->seq);
+}
+
+static int compare_order_rank(const void *p1, const void *p2)
+/************************************************************/
+{
+	const struct order_item *item1 = *(const struct order_item **)p1;
+	const struct order_item *item2 = *(const struct order_item **)p2;
+
+	/* listed procs first, then the others in source order */
+	if (item1->rank != item2->rank) {
+		if (item1->rank == 0 || item2->rank == 0)
+			return(item1->rank == 0 ? 1 : -1);
+		return(item1->rank < item2->rank ? -1 : 1);
+	}
+	return(item1->seq < item2->seq ? -1 : item1->seq > item2->seq);
+}
+
+/* create the item of a top-level proc in pass 1 */
+static void OrderAddProc(struct dsym *proc)
+/******************************************/
+{
+	struct order_item *item = LclAlloc(sizeof(struct order_item));
+
+	memset(item, 0, sizeof(struct order_item));
+	item->proc = proc;
+	item->seq = order_seq++;
+	if (order_head == NULL)
+		order_head = item;
+	else
+		order_tail->next = item;
+	order_tail = item;
+	proc->e.procinfo->order = item;
+}
+
+/* PROC of a top-level proc: the first proc of a segment is moved */
+static void OrderProcStart(struct asym *sym)
+/*******************************************/
+{
+	struct order_item *item;
+
+	if (sym == NULL || sym->isproc == FALSE || sym->state != SYM_INTERNAL ||
+		sym->segment != &CurrSeg->sym || ((struct dsym *)sym)->e.procinfo->order == NULL)
+		return;
+	item = ((struct dsym *)sym)->e.procinfo->order;
+	item->start = GetCurrOffset();
+	if (order_active && item->first) {
+		if (item->start < item->lead)
+			fill_in_objfile_space(item->lead - item->start);
+		CurrSeg->e.seginfo->current_loc = item->ofs;
+	}
+}
+
+/* ENDP of a top-level proc: pad the reserved space, continue at the new
+* location of the code behind the proc.
+*/
+static void OrderProcEnd(struct dsym *proc)
+/******************************************/
+{
+	struct order_item *item = proc->e.procinfo->order;
+
+	item->end = GetCurrOffset();
+	if (order_active) {
+		if (item->end >= item->ofs && item->end < item->ofs + item->size)
+			fill_in_objfile_space(item->ofs + item->size - item->end);
+		CurrSeg->e.seginfo->current_loc = item->resume;
+	}
+}
+
+/* read the order file, set the rank of the procs listed */
+static void ReadOrderFile(void)
+/*******************************/
+{
+	FILE *file;
+	struct asym *sym;
+	char *p;
+	char *name;
+	uint_32 rank = 0;
+	char buffer[MAX_LINE_LEN];
+
+	file = fopen(Options.names[OPTN_ORDER_FN], "r");
+	if (file == NULL) {
+		EmitErr(CANNOT_OPEN_FILE, Options.names[OPTN_ORDER_FN], ErrnoStr());
+		return;
+	}
+	while (fgets(buffer, sizeof(buffer), file)) {
+		for (p = buffer; isspace(*p); p++);
+		/* empty lines and comments are skipped, anything behind the name is ignored */
+		if (*p == NULLC || *p == ';' || *p == '#')
+			continue;
+		for (name = p; *p && !isspace(*p); p++);
+		*p = NULLC;
+		sym = SymSearch(name);
+		if (sym && sym->isproc && sym->state == SYM_INTERNAL && ((struct dsym *)sym)->e.procinfo->order) {
+			if (((struct dsym *)sym)->e.procinfo->order->rank == 0) {
+				((struct dsym *)sym)->e.procinfo->order->rank = ++rank;
+				order_listed++;
+			}
+		}
+		else {
+			DebugMsg(("ReadOrderFile: %s not found\n", name));
+			order_missing++;
+		}
+	}
+	fclose(file);
+}
+
+/* compute the layout of the procs in a segment. items[] are in source order.
+* returns the number of changed offsets or -1 if the segment isn't reordered.
+*/
+static int OrderSegment(struct order_item **items, unsigned num, struct order_item **sorted)
+/******************************************************************************************/
+{
+	struct order_item *item;
+	unsigned i;
+	unsigned ranked = 0;
+	int changed = 0;
+	uint_32 pos;
+	uint_32 tail;
+
+	for (i = 0; i < num; i++) {
+		item = items[i];
+		if (order_active == FALSE) {
+			/* the code must have been generated in source order ( no ORG ) */
+			item->ofs = (i ? items[i - 1]->end : item->start);
+			item->resume = item->end;
+			if (item->start < item->ofs || item->end < item->start ||
+				item->proc->sym.asmpass != (Parse_Pass & 0xFF))
+				return(-1);
+		}
+		if (item->rank)
+			ranked++;
+		if (item->end >= item->ofs &&
+			(item->end - item->ofs > item->size || order_layouts < ORDER_MAX_SHRINK))
+			item->size = item->end - item->ofs;
+		sorted[i] = item;
+	}
+	if (ranked == 0)
+		return(-1);
+	if (items[0]->start > items[0]->lead || order_layouts < ORDER_MAX_SHRINK)
+		items[0]->lead = items[0]->start;
+	items[0]->first = TRUE;
+
+	qsort(sorted, num, sizeof(struct order_item *), compare_order_rank);
+	for (i = 0, pos = items[0]->lead; i < num; i++) {
+		item = sorted[i];
+		if (item->ofs != pos) {
+			DebugMsg(("OrderSegment: %s moved from %" I32_SPEC "X to %" I32_SPEC "X, size=%" I32_SPEC "X\n", item->proc->sym.name, item->ofs, pos, item->size));
+			item->ofs = pos;
+			changed++;
+		}
+		pos += item->size;
+	}
+	/* the code behind the last proc follows the last item */
+	for (i = 0, tail = pos; i < num; i++) {
+		pos = (i + 1 < num ? items[i + 1]->ofs : tail);
+		if (items[i]->resume != pos) {
+			items[i]->resume = pos;
+			changed++;
+		}
+	}
+	return(changed);
+}
+
+/* compute the layout of all segments, called after the passes have
+* converged. returns the number of changed offsets; if it's > 0,
+* more passes are needed.
+*/
+unsigned OrderProcs(void)
+/*************************/
+{
+	struct order_item *item;
+	struct order_item **items;
+	unsigned num;
+	unsigned i, j;
+	unsigned changed = 0;
+	int rc;
+
+	if (order_head == NULL || write_to_file == FALSE)
+		return(0);
+	if (order_done == FALSE) {
+		order_done = TRUE;
+		ReadOrderFile();
+	}
+
+	for (num = 0, item = order_head; item; item = item->next)
+		if (item->proc->e.procinfo->order)
+			num++;
+	if (num == 0)
+		return(0);
+	items = MemAlloc(2 * num * sizeof(struct order_item *));
+	for (num = 0, item = order_head; item; item = item->next)
+		if (item->proc->e.procinfo->order)
+			items[num++] = item;
+	qsort(items, num, sizeof(struct order_item *), compare_order_seq);
+
+	for (i = 0; i < num; i = j) {
+		for (j = i + 1; j < num && items[j]->proc->sym.segment == items[i]->proc->sym.segment; j++);
+		rc = OrderSegment(&items[i], j - i, &items[num + i]);
+		if (rc < 0) {
+			/* segment remains in source order */
+			for (; i < j; i++)
+				items[i]->proc->e.procinfo->order = NULL;
+		}
+		else {
+			((struct dsym *)items[i]->proc->sym.segment)->e.seginfo->reordered = TRUE;
+			changed += rc;
+		}
+	}
+	MemFree(items);
+	order_active = TRUE;
+	order_layouts++;
+	DebugMsg(("OrderProcs: %u offsets changed\n", changed));
+	return(changed);
+}
+
+void OrderStats(void)
+/*********************/
+{
+	if (order_done)
+		printf("order: %" I32_SPEC "u procedures listed, %" I32_SPEC "u names not found\n", order_listed, order_missing);
+}
+
 /* PROC directive. */
 ret_code ProcDir(int i, struct asm_tok tokenarray[])
 /****************************************************/
@@ -1913,6 +2533,9 @@ ret_code ProcDir(int i, struct asm_tok tokenarray[])
 		push_proc(CurrProc);
 	}
 
+	/* v2.52: -order, the first proc of a segment is moved before it's aligned */
+	if (order_head && CurrProc == NULL && Parse_Pass > PASS_1)
+		OrderProcStart(SymSearch(name));
 
 	if (ModuleInfo.procalign) {
 		AlignCurrOffset(ModuleInfo.procalign);
@@ -1971,6 +2594,9 @@ ret_code ProcDir(int i, struct asm_tok tokenarray[])
 			CurrProc = NULL;
 			return(ERROR);
 		}
+		/* v2.52: -order, create an item for top-level procs */
+		if (Options.names[OPTN_ORDER_FN] && Options.output_format == OFORMAT_BIN && ProcStack == NULL)
+			OrderAddProc((struct dsym *)sym);
 		/* v2.04: added */
 		if (is_global && Options.masm8_proc_visibility)
 			sym->ispublic = TRUE;
@@ -2013,6 +2639,13 @@ ret_code ProcDir(int i, struct asm_tok tokenarray[])
 
 		SymSetLocal(sym);
 
+		/* v2.52: the code of a folded proc is generated at the location
+		* of the proc it's folded to.
+		*/
+		xfer_seg = NULL;
+		if (((struct dsym *)sym)->e.procinfo->foldto)
+			FoldOverlayStart((struct dsym *)sym);
+
 		/* it's necessary to check for a phase error here
 		as it is done in LabelCreate() and data_dir()!
 		*/
@@ -2121,6 +2754,10 @@ static void ProcFini(struct dsym *proc)
 		EmitErr(UNMATCHED_BLOCK_NESTING, proc->sym.name);
 		proc->sym.total_size = CurrProc->sym.segment->offset - proc->sym.offset;
 	}
+	/* v2.52: -icf, the last instruction must be RET, IRET or JMP */
+	proc->e.procinfo->foldable = (xfer_seg == CurrSeg && xfer_end == GetCurrOffset());
+	if (fold_seg)
+		FoldOverlayEnd(proc);
 
 	/* v2.03: for W3+, check for unused params and locals */
 	if (Options.warning_level > 2 && Parse_Pass == PASS_1) {
@@ -2194,6 +2831,10 @@ static void ProcFini(struct dsym *proc)
 	ProcStatus = 0; /* in case there was an empty PROC/ENDP pair */
 	if (sym_ReservedStack)
 		sym_ReservedStack->value = 0;
+
+	/* v2.52: -order, continue at the new location of the code behind the proc */
+	if (proc->e.procinfo->order && proc->sym.segment == &CurrSeg->sym)
+		OrderProcEnd(proc);
 }
 
 /* ENDP directive */
@@ -5424,6 +6065,9 @@ ret_code RetInstr(int i, struct asm_tok tokenarray[], int count)
 #endif
 	}
 
+	/* v2.52: -Sc, the RET line's column shows the epilogue's total */
+	if (Options.mca_cpu)
+		McaEpilogue(TRUE);
 	if (ModuleInfo.list) {
 		LstWrite(LSTTYPE_DIRECTIVE, GetCurrOffset(), NULL);
 	}
@@ -5518,6 +6162,8 @@ ret_code RetInstr(int i, struct asm_tok tokenarray[], int count)
 	}
 	AddLineQueue(buffer);
 	RunLineQueue();
+	if (Options.mca_cpu)
+		McaEpilogue(FALSE);
 
 	DebugMsg1(("RetInstr() exit\n"));
 
@@ -5542,4 +6188,16 @@ void ProcInit(void)
 	ModuleInfo.basereg[USE32] = T_EBP;
 	ModuleInfo.basereg[USE64] = T_RBP;
 	unw_segs_defined = 0;
+	if (Parse_Pass == PASS_1) {
+		fold_done = FALSE;
+		order_head = NULL;
+		order_tail = NULL;
+		order_seq = 0;
+		order_done = FALSE;
+		order_active = FALSE;
+		order_layouts = 0;
+		order_listed = 0;
+		order_missing = 0;
+	}
+	fold_seg = NULL;
 }
\ No newline at end of file
@@ -1430,7 +1430,7 @@ ret_code ParseProc( struct dsym *proc, int i, struct asm_tok tokenarray[], bool
                 /* error if there was a PUBLIC directive! */
                 proc->sym.scoped = TRUE;
                 if ( oldpublic ) {
-                    SkipSavedState(); /* do a full pass-2 scan */
+                    SkipSavedState( FPS_PROC_PRIVATE, proc->sym.name ); /* do a full pass-2 scan */
                 }
 #endif
                 proc->e.procinfo->isexport = FALSE;
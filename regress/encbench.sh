@@ -0,0 +1,192 @@
+#!/bin/sh
+#
+# UASM encoder benchmark.
+#
+# Generates large synthetic sources for each ISA family ( legacy, SSE, AVX,
+# AVX-512 ), assembles them with -stats and saves the encoder throughput
+# reported by CodeGenV2() and codegen() in a tab separated file, one row per
+# source, encoder and family of the encoded instructions:
+#
+#   source  encoder  family  instructions  bytes  ns  instr/s  bytes/s
+#
+# usage: encbench.sh [-n lines] [-r runs] [-o result.tsv] [uasm]
+#        encbench.sh -c old.tsv new.tsv
+#
+# -n: number of instruction lines per ISA family ( default 500000 )
+# -r: number of runs; the fastest run of each row is saved ( default 3 )
+# -o: result file ( default encbench.tsv )
+# -c: compare two result files; rows are listed with the change of instr/s
+#
+
+LINES=500000
+RUNS=3
+OUT=encbench.tsv
+
+compare() {
+    awk -F'\t' '
+    FNR == 1 { next }
+    NR == FNR { old[$1 "\t" $2 "\t" $3] = $7; next }
+    {
+        key = $1 "\t" $2 "\t" $3
+        if ( key in old && old[key] > 0 )
+            printf( "%-7s %-15s %-7s %12.0f -> %12.0f instr/s %+7.1f%%\n", $1, $2, $3, old[key], $7, ( $7 - old[key] ) * 100 / old[key] )
+        else
+            printf( "%-7s %-15s %-7s %12s -> %12.0f instr/s\n", $1, $2, $3, "-", $7 )
+    }' "$1" "$2"
+}
+
+while getopts n:r:o:c opt; do
+    case $opt in
+    n) LINES=$OPTARG ;;
+    r) RUNS=$OPTARG ;;
+    o) OUT=$OPTARG ;;
+    c) shift $((OPTIND - 1)); compare "$1" "$2"; exit ;;
+    *) sed -n 12,13p "$0"; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+UASM=${1:-../GccUnixR/uasm}
+
+TMPD=${TMPDIR:-/tmp}/encbench.$$
+mkdir -p "$TMPD" || exit 1
+trap 'rm -rf "$TMPD"' EXIT
+
+# generate <family> <lines>: write a source with <lines> instructions,
+# cycling through instruction forms and all addressing modes.
+
+generate() {
+    awk -v family="$1" -v lines="$2" '
+    BEGIN {
+        n = split( "rax rbx rcx rdx rsi rdi rbp r8 r9 r10 r11 r12 r13 r14 r15", gpr, " " )
+        split( "eax ebx ecx edx esi edi ebp r8d r9d r10d r11d r12d r13d r14d r15d", gpr32, " " )
+        split( "ax bx cx dx si di bp r8w r9w r10w r11w r12w r13w r14w r15w", gpr16, " " )
+        split( "al bl cl dl sil dil bpl r8b r9b r10b r11b r12b r13b r14b r15b", gpr8, " " )
+        nbase = split( "rbx rsi rdi rbp r8 r9 r12 r13 r15", base, " " )
+        nidx = split( "rcx rdx rsi rdi r9 r10 r11 r14", idx, " " )
+
+        if ( family == "legacy" ) {
+            nins = split( "add sub and or xor cmp adc sbb mov test", alu, " " )
+            nun = split( "inc dec neg not", un, " " )
+            nsh = split( "shl shr sar rol ror", sh, " " )
+        } else if ( family == "sse" ) {
+            nins = split( "addps addpd subps mulpd divps minpd maxps andps orpd xorps paddd psubq pmulld pand por pxor pcmpeqd punpcklbw unpckhps sqrtpd", alu, " " )
+            nsc = split( "addss addsd mulss divsd sqrtss", sc, " " )
+            nmov = split( "movaps movups movdqa movdqu movapd", mv, " " )
+        } else if ( family == "avx" ) {
+            nins = split( "vaddps vaddpd vsubps vmulpd vdivps vminpd vmaxps vandps vorpd vxorps vpaddd vpsubq vpmulld vpand vpor vpxor vpcmpeqd vunpckhps vfmadd231ps vfmadd213pd", alu, " " )
+            nsc = split( "vaddss vaddsd vmulss vdivsd vsqrtss", sc, " " )
+            nmov = split( "vmovaps vmovups vmovdqa vmovdqu vmovapd", mv, " " )
+        } else {
+            nins = split( "vaddps vsubps vmulps vdivps vminps vmaxps vpaddd vpsubd vpmulld vpandd vpord vpxord vfmadd231ps vpermps", alu, " " )
+            ninq = split( "vaddpd vsubpd vmulpd vdivpd vpaddq vpsubq vpandq vporq vpxorq vfmadd213pd vpermpd", aluq, " " )
+            nmov = split( "vmovaps vmovups vmovdqa32 vmovdqu32 vmovdqa64 vmovdqu64", mv, " " )
+        }
+
+        print "option casemap:none"
+        if ( family == "avx512" )
+            print "option evex:1"
+        print ".data"
+        print "align 64"
+        print "var1 db 256 dup (0)"
+        print ".code"
+        print "start:"
+        for ( i = 0; i < lines; i++ )
+            print "    " instr( i )
+        print "    ret"
+        print "end"
+    }
+
+    # memory operand; j selects the addressing form
+    function mem( j, size,   b, x, s ) {
+        if ( size != "" )
+            size = size " ptr "
+        b = base[j % nbase + 1]
+        x = idx[int( j / 3 ) % nidx + 1]
+        s = 2 ^ ( int( j / 7 ) % 4 )
+        j = j % 8
+        if ( j == 0 ) return size "[" b "]"
+        if ( j == 1 ) return size "[" b "+" ( j * 8 ) "]"
+        if ( j == 2 ) return size "[" b "+1000h]"
+        if ( j == 3 ) return size "[" b "+" x "*" s "]"
+        if ( j == 4 ) return size "[" b "+" x "*" s "-40h]"
+        if ( j == 5 ) return size "[" b "+" x "*" s "+12345h]"
+        if ( j == 6 ) return size "[" x "*" s "+80h]"
+        return size "var1"
+    }
+
+    function instr( i,   f, k, r1, r2 ) {
+        f = i % 8
+        k = int( i / 8 )
+        r1 = k % 16
+        r2 = ( k * 7 + 3 ) % 16
+
+        if ( family == "legacy" ) {
+            if ( f == 0 ) return alu[k % nins + 1] " " gpr[r1 % n + 1] ", " gpr[r2 % n + 1]
+            if ( f == 1 ) return alu[k % 8 + 1] " " gpr32[r1 % n + 1] ", " mem( k, "dword" )
+            if ( f == 2 ) return alu[k % 8 + 1] " " mem( k, "qword" ) ", " gpr[r2 % n + 1]
+            if ( f == 3 ) return alu[k % 8 + 1] " " gpr16[r1 % n + 1] ", " ( k % 2 ? 5 : "1234h" )
+            if ( f == 4 ) return alu[k % 8 + 1] " " mem( k, "byte" ) ", " ( k % 100 )
+            if ( f == 5 ) return un[k % nun + 1] " " ( k % 2 ? gpr8[r1 % n + 1] : mem( k, "dword" ) )
+            if ( f == 6 ) return sh[k % nsh + 1] " " gpr[r1 % n + 1] ", " ( k % 63 + 1 )
+            return ( k % 2 ? "lea " gpr[r1 % n + 1] ", " mem( k, "" ) : "movzx " gpr32[r1 % n + 1] ", " mem( k, "word" ) )
+        }
+        if ( family == "sse" || family == "avx" ) {
+            v = ( family == "avx" )
+            xr = ( v && k % 2 ) ? "ymm" : "xmm"
+            if ( f < 3 ) {
+                if ( v )
+                    return alu[k % nins + 1] " " xr r1 ", " xr r2 ", " ( f == 0 ? xr ( r1 + 5 ) % 16 : mem( k, xr "word" ) )
+                return alu[k % nins + 1] " xmm" r1 ", " ( f == 0 ? "xmm" r2 : mem( k, xr "word" ) )
+            }
+            if ( f == 3 ) return mv[k % nmov + 1] " " xr r1 ", " mem( k, xr "word" )
+            if ( f == 4 ) return mv[k % nmov + 1] " " mem( k, xr "word" ) ", " xr r2
+            if ( f == 5 ) return mv[k % nmov + 1] " " xr r1 ", " xr r2
+            if ( f == 6 ) return v ? sc[k % nsc + 1] " xmm" r1 ", xmm" r2 ", xmm" ( r1 + 1 ) % 16 : sc[k % nsc + 1] " xmm" r1 ", xmm" r2
+            return v ? "vshufps " xr r1 ", " xr r2 ", " mem( k, xr "word" ) ", " ( k % 256 ) : "shufps xmm" r1 ", " mem( k, xr "word" ) ", " ( k % 256 )
+        }
+        # avx512: all zmm registers, masking, zeroing, broadcast and disp8*N
+        r1 = k % 32
+        r2 = ( k * 7 + 3 ) % 32
+        mk = "{k" ( k % 7 + 1 ) "}"
+        if ( f == 0 ) return alu[k % nins + 1] " zmm" r1 ", zmm" r2 ", zmm" ( r1 + 9 ) % 32
+        if ( f == 1 ) return alu[k % nins + 1] " zmm" r1 " " mk ", zmm" r2 ", " mem( k, "zmmword" )
+        if ( f == 2 ) return alu[k % nins + 1] " zmm" r1 " " mk "{z}, zmm" r2 ", [" base[k % nbase + 1] "+" ( k % 4 ) * 4 "]{1to16}"
+        if ( f == 3 ) return aluq[k % ninq + 1] " zmm" r1 ", zmm" r2 ", [" base[k % nbase + 1] "+" idx[k % nidx + 1] "*8]{1to8}"
+        if ( f == 4 ) return aluq[k % ninq + 1] " zmm" r1 " " mk ", zmm" r2 ", zmm" ( r2 + 1 ) % 32
+        if ( f == 5 ) return mv[k % nmov + 1] " zmm" r1 " " mk "{z}, " mem( k, "zmmword" )
+        if ( f == 6 ) return mv[k % nmov + 1] " " mem( k, "zmmword" ) " " mk ", zmm" r2
+        return ( k % 2 ? "vaddps ymm" : "vaddps xmm" ) r1 " " mk ", " ( k % 2 ? "ymm" : "xmm" ) r2 ", " ( k % 2 ? "ymm" : "xmm" ) ( r1 + 3 ) % 32
+    }'
+}
+
+: > "$TMPD/all.txt"
+for family in legacy sse avx avx512; do
+    generate $family $LINES > "$TMPD/$family.asm"
+    run=0
+    while [ $run -lt $RUNS ]; do
+        "$UASM" -q -elf64 -stats -Fo"$TMPD/$family.o" "$TMPD/$family.asm" > "$TMPD/out.txt" || {
+            cat "$TMPD/out.txt"
+            echo "encbench: $family.asm failed"
+            exit 1
+        }
+        sed -n "s/^encoder:/$family/p" "$TMPD/out.txt" >> "$TMPD/all.txt"
+        run=$((run + 1))
+    done
+done
+
+# keep the fastest run of each row
+awk '
+{
+    key = $1 "\t" $2 "\t" $3
+    if ( !( key in ns ) ) { order[++n] = key; ns[key] = $8 + 1; }
+    if ( $8 < ns[key] ) { ns[key] = $8; cnt[key] = $4; bytes[key] = $6 }
+}
+END {
+    print "source\tencoder\tfamily\tinstructions\tbytes\tns\tinstr/s\tbytes/s"
+    for ( i = 1; i <= n; i++ ) {
+        key = order[i]
+        printf( "%s\t%s\t%s\t%s\t%.0f\t%.0f\n", key, cnt[key], bytes[key], ns[key],
+            ns[key] ? cnt[key] * 1e9 / ns[key] : 0, ns[key] ? bytes[key] * 1e9 / ns[key] : 0 )
+    }
+}' "$TMPD/all.txt" > "$OUT"
+cat "$OUT"
@@ -0,0 +1,32 @@
+    .386
+    .model flat, c
+X   EQU 8
+S   STRUCT
+a   dd ?
+b   dd ?
+S   ENDS
+U   UNION
+w   dw ?
+d   dd ?
+U   ENDS
+R   RECORD f1:3, f2:5
+PS  TYPEDEF PTR S
+F   PROTO :DWORD
+    EXTERNDEF ext1:DWORD
+    .data
+v1  LABEL DWORD
+    dd 1
+v2  dd 1, 2, 3
+    .code
+    db "X ok"
+    db "S ok"
+    db "U ok"
+    db "R ok"
+    db "PS ok"
+    db "F ok"
+    db "ext1 ok"
+    db "v1 ok"
+    db "v2 ok"
+l1:
+    db "l1 not defined"
+    END
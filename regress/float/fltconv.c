@@ -0,0 +1,357 @@
+/****************************************************************************
+*
+* Description:  test and benchmark of the float conversion ( atofloat.c ).
+*               Linked with the assembler's atofloat.o; the C library's
+*               strtof(), strtod() and strtold() ( x86 80-bit long double )
+*               are the reference.
+*
+*               fltconv [-x] [-s stride] [-n count]
+*                 round trip: every <stride>th positive finite REAL4 bit
+*                 pattern ( all with -x ), printed with 9 digits, must be
+*                 converted back to the same bits; <count> random REAL8
+*                 ( 17 digits ) and REAL10 ( 21 digits ) patterns likewise.
+*                 Then <count> random literals and the halfway points
+*                 between neighbouring REAL4/REAL8 values ( exact, and
+*                 just above ) must match the C library.
+*               fltconv -b [-n count]
+*                 benchmark: ns per literal for REAL4, REAL8 and REAL10,
+*                 compared with the C library.
+*
+*               make -f gccLinux64.mak flttest / fltbench
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "globals.h"
+#include "atofloat.h"
+
+#define MAXBAD 10  /* mismatches listed per test */
+
+/* atofloat.o references these */
+
+unsigned int Parse_Pass;
+
+int EmitErr( int msgnum, ... )
+/****************************/
+{
+    return( ERROR );
+}
+
+void EmitWarn( int level, int msgnum, ... )
+/*****************************************/
+{
+}
+
+void myatoi128( const char *src, uint_64 dst[], int base, int size )
+/******************************************************************/
+{
+}
+
+static unsigned long bad;
+static unsigned long tested;
+
+static uint_64 Random64( void )
+/*****************************/
+{
+    static uint_64 x = 0x9E3779B97F4A7C15ULL;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return( x );
+}
+
+/* convert <s> and compare with the expected bytes, printed highest byte first.
+ * Conversions to zero or denormals are errors for REAL4 and REAL8, but the
+ * bits must still match.
+ */
+
+static void Check( const char *s, unsigned size, const void *expected, const char *test )
+/***************************************************************************************/
+{
+    unsigned char out[16];
+    int i;
+
+    memset( out, 0, sizeof( out ) );
+    atofloat( out, s, size, FALSE, 0 );
+    tested++;
+    if ( memcmp( out, expected, size ) == 0 )
+        return;
+    if ( bad++ >= MAXBAD )
+        return;
+    printf( "%s: REAL%u %.60s\n  got  ", test, size, s );
+    for ( i = size - 1; i >= 0; i-- )
+        printf( "%02X", out[i] );
+    printf( "\n  want " );
+    for ( i = size - 1; i >= 0; i-- )
+        printf( "%02X", ((const unsigned char *)expected)[i] );
+    printf( "\n" );
+}
+
+static int Result( const char *test )
+/***********************************/
+{
+    printf( "%-36s %10lu literals, %lu mismatches\n", test, tested, bad );
+    tested = 0;
+    if ( bad ) {
+        bad = 0;
+        return( 0 );
+    }
+    return( 1 );
+}
+
+/* remove trailing zeros of the mantissa printed by "%.Ne" */
+
+static void TrimZeros( char *s )
+/******************************/
+{
+    char *e = strchr( s, 'e' );
+    char *z = e;
+
+    if ( e == NULL ) /* "inf" */
+        return;
+    while ( z[-1] == '0' )
+        z--;
+    memmove( z, e, strlen( e ) + 1 );
+}
+
+/* insert a digit at the end of the mantissa: "just above" a halfway point */
+
+static void AppendDigit( char *s, char digit )
+/********************************************/
+{
+    char *e = strchr( s, 'e' );
+
+    if ( e == NULL )
+        return;
+    memmove( e + 1, e, strlen( e ) + 1 );
+    *e = digit;
+}
+
+static int RoundTrip4( uint_32 stride )
+/*************************************/
+{
+    char s[64];
+    uint_32 u;
+    float f;
+
+    for ( u = 1; u < 0x7F800000; u += stride ) {
+        memcpy( &f, &u, 4 );
+        sprintf( s, "%.8e", f );
+        Check( s, 4, &u, "round trip" );
+        if ( u > 0x7F800000 - stride )
+            break;
+    }
+    return( Result( "REAL4 round trip" ) );
+}
+
+static int RoundTrip8( unsigned long count )
+/******************************************/
+{
+    char s[64];
+    uint_64 u;
+    double d;
+
+    while ( count-- ) {
+        do {
+            u = Random64() & 0x7FFFFFFFFFFFFFFFULL;
+        } while ( u >= 0x7FF0000000000000ULL || u == 0 );
+        memcpy( &d, &u, 8 );
+        sprintf( s, "%.16e", d );
+        Check( s, 8, &u, "round trip" );
+    }
+    return( Result( "REAL8 round trip" ) );
+}
+
+static int RoundTrip10( unsigned long count )
+/*******************************************/
+{
+    char s[64];
+    unsigned char b[16];
+    long double ld;
+
+    while ( count-- ) {
+        uint_64 m = Random64() | 0x8000000000000000ULL;
+        uint_16 e = 1 + Random64() % 0x7FFE;
+
+        memset( b, 0, sizeof( b ) );
+        memcpy( b, &m, 8 );
+        memcpy( b + 8, &e, 2 );
+        memcpy( &ld, b, sizeof( ld ) );
+        sprintf( s, "%.20Le", ld );
+        Check( s, 10, b, "round trip" );
+    }
+    return( Result( "REAL10 round trip" ) );
+}
+
+/* random literals and halfway points, compared with the C library */
+
+static void CheckLibc( const char *s )
+/************************************/
+{
+    float f = strtof( s, NULL );
+    double d = strtod( s, NULL );
+    long double ld = strtold( s, NULL );
+
+    Check( s, 4, &f, "libc" );
+    Check( s, 8, &d, "libc" );
+    Check( s, 10, &ld, "libc" );
+}
+
+static int Libc( unsigned long count )
+/************************************/
+{
+    char s[2048];
+    unsigned long i;
+    int j;
+    int k;
+
+    for ( i = 0; i < count; i++ ) {
+        switch ( i % 4 ) {
+        case 0: /* up to 21 random digits, short exponent */
+            k = 0;
+            for ( j = 1 + Random64() % 21; j; j-- ) {
+                s[k++] = '0' + Random64() % 10;
+                if ( k == 1 )
+                    s[k++] = '.';
+            }
+            sprintf( s + k, "e%d", (int)( Random64() % 80 ) - 40 );
+            break;
+        case 1: { /* halfway between two REAL8 values, exact */
+            uint_64 u = Random64() & 0x7FEFFFFFFFFFFFFFULL;
+            double a;
+            memcpy( &a, &u, 8 );
+            sprintf( s, "%.780Le", ( (long double)a + nextafter( a, INFINITY ) ) / 2 );
+            TrimZeros( s );
+            if ( i % 3 == 1 )
+                AppendDigit( s, '1' );
+            break; }
+        case 2: { /* halfway between two REAL4 values */
+            uint_32 u = Random64() & 0x7F7FFFFF;
+            float a;
+            memcpy( &a, &u, 4 );
+            sprintf( s, "%.160e", ( (double)a + nextafterf( a, INFINITY ) ) / 2 );
+            TrimZeros( s );
+            if ( i % 3 == 2 )
+                AppendDigit( s, '1' );
+            break; }
+        default: /* random REAL8 value, 1 to 20 digits */
+            {
+            uint_64 u = Random64() & 0x7FEFFFFFFFFFFFFFULL;
+            double a;
+            memcpy( &a, &u, 8 );
+            sprintf( s, "%.*e", (int)( Random64() % 20 ), a );
+            }
+        }
+        CheckLibc( s );
+    }
+    return( Result( "compared with libc" ) );
+}
+
+/* benchmark */
+
+#define NLIT 4096
+
+static char lit[NLIT][32];
+
+static double Now( void )
+/***********************/
+{
+    struct timespec t;
+
+    clock_gettime( CLOCK_MONOTONIC, &t );
+    return( t.tv_sec + t.tv_nsec * 1e-9 );
+}
+
+static void Bench( unsigned long count )
+/**************************************/
+{
+    static const unsigned sizes[] = { 4, 8, 10 };
+    unsigned char out[16];
+    volatile long double sink = 0;
+    double best[2];
+    double t;
+    unsigned long i;
+    unsigned s;
+    int r;
+    int lib;
+
+    /* literals as found in sources: short decimals and 9-digit numbers */
+    for ( i = 0; i < NLIT; i++ ) {
+        double d = (double)( Random64() >> 11 ) / ( 1ULL << 53 ) - 0.5;
+        if ( i % 3 == 0 )
+            sprintf( lit[i], "%.3f", d * 1000 );
+        else
+            sprintf( lit[i], "%.9e", d * ( i % 7 == 0 ? 1e-3 : 1e6 ) );
+    }
+    printf( "size     atofloat      libc  ( ns per literal, best of 5 )\n" );
+    for ( s = 0; s < sizeof( sizes ) / sizeof( sizes[0] ); s++ ) {
+        for ( lib = 0; lib < 2; lib++ ) {
+            best[lib] = 1e9;
+            for ( r = 0; r < 5; r++ ) {
+                t = Now();
+                if ( lib == 0 )
+                    for ( i = 0; i < count; i++ ) {
+                        atofloat( out, lit[i % NLIT], sizes[s], FALSE, 0 );
+                        sink += out[0];
+                    }
+                else if ( sizes[s] == 4 )
+                    for ( i = 0; i < count; i++ )
+                        sink += strtof( lit[i % NLIT], NULL );
+                else if ( sizes[s] == 8 )
+                    for ( i = 0; i < count; i++ )
+                        sink += strtod( lit[i % NLIT], NULL );
+                else
+                    for ( i = 0; i < count; i++ )
+                        sink += strtold( lit[i % NLIT], NULL );
+                t = ( Now() - t ) * 1e9 / count;
+                if ( t < best[lib] )
+                    best[lib] = t;
+            }
+        }
+        printf( "REAL%-2u %10.1f %9.1f\n", sizes[s], best[0], best[1] );
+    }
+}
+
+int main( int argc, char **argv )
+/*******************************/
+{
+    unsigned long count = 250000;
+    uint_32 stride = 1021;
+    int bench = 0;
+    int ok = 1;
+    int i;
+
+    for ( i = 1; i < argc; i++ ) {
+        if ( strcmp( argv[i], "-b" ) == 0 )
+            bench = 1;
+        else if ( strcmp( argv[i], "-x" ) == 0 )
+            stride = 1;
+        else if ( strcmp( argv[i], "-s" ) == 0 && i + 1 < argc )
+            stride = strtoul( argv[++i], NULL, 0 );
+        else if ( strcmp( argv[i], "-n" ) == 0 && i + 1 < argc )
+            count = strtoul( argv[++i], NULL, 0 );
+        else {
+            printf( "usage: fltconv [-x] [-s stride] [-n count]\n"
+                   "       fltconv -b [-n count]\n" );
+            return( EXIT_FAILURE );
+        }
+    }
+    if ( stride == 0 )
+        stride = 1;
+    Parse_Pass = PASS_1;
+    if ( bench ) {
+        Bench( count );
+        return( EXIT_SUCCESS );
+    }
+    ok &= RoundTrip4( stride );
+    ok &= RoundTrip8( count );
+    ok &= RoundTrip10( count );
+    ok &= Libc( count );
+    printf( ok ? "fltconv: all tests passed\n" : "fltconv: FAILED\n" );
+    return( ok ? EXIT_SUCCESS : EXIT_FAILURE );
+}
@@ -0,0 +1,203 @@
+/****************************************************************************
+*
+* Description:  libuasm JIT test ( x86-64, System V ABI ): assembles code
+*               into the running process and calls it. Covers resolution
+*               of externals by the callback ( a host function, reached
+*               through a stub if out of range, and a host variable ),
+*               data labels, memory provided by the caller and the errors
+*               for too small memory and unresolved externals.
+*               Build and run: make -f gccLinux64.mak jittest
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "libuasm.h"
+
+#define PAGESIZE 0x1000
+
+typedef long (*fn2)( long, long );
+typedef long (*fn0)( void );
+
+static int failed;
+
+static void Check( int cond, const char *what )
+/*********************************************/
+{
+    printf( "%-40s %s\n", what, cond ? "ok" : "FAILED" );
+    if ( !cond )
+        failed++;
+}
+
+/* host function and variable, to be resolved by the callback */
+
+static long host_mul( long a, long b )
+/************************************/
+{
+    return( a * b );
+}
+
+static long host_var = 1000;
+
+static void *Resolve( void *user, const char *name )
+/**************************************************/
+{
+    (*(int *)user)++;
+    if ( strcmp( name, "host_mul" ) == 0 )
+        return( (void *)host_mul );
+    if ( strcmp( name, "host_var" ) == 0 )
+        return( &host_var );
+    return( NULL );
+}
+
+static const char src[] =
+    ".x64\n"
+    ".model flat\n"
+    "option casemap:none\n"
+    "host_mul proto\n"
+    "extern host_var:qword\n"
+    ".data\n"
+    "factor dq 3\n"
+    "counter dd 0\n"
+    ".code\n"
+    "add2 proc\n"
+    " lea rax, [rdi+rsi]\n"
+    " ret\n"
+    "add2 endp\n"
+    "mul3 proc\n"
+    " mov rax, rdi\n"
+    " imul rax, factor\n"
+    " inc counter\n"
+    " ret\n"
+    "mul3 endp\n"
+    "callhost proc\n"
+    " sub rsp, 8\n"
+    " call host_mul\n"
+    " add rsp, 8\n"
+    " ret\n"
+    "callhost endp\n"
+    "gethost proc\n"
+    " mov rax, offset host_var\n"
+    " mov rax, [rax]\n"
+    " ret\n"
+    "gethost endp\n"
+    "end\n";
+
+static const char srcunres[] =
+    ".x64\n"
+    ".model flat\n"
+    "nothere proto\n"
+    ".code\n"
+    "f proc\n"
+    " call nothere\n"
+    " ret\n"
+    "f endp\n"
+    "end\n";
+
+/* image in memory mapped by UasmJit() */
+
+static void TestMapped( struct uasm_ctx *ctx )
+/********************************************/
+{
+    struct uasm_result r;
+    struct uasm_image img;
+    int calls = 0;
+    int ok;
+
+    ok = UasmJit( ctx, src, strlen( src ), NULL, 0, Resolve, &calls, &r, &img );
+    Check( ok && r.errors == 0, "assemble into mapped memory" );
+    if ( !ok ) {
+        printf( "%s", r.messages ? r.messages : "" );
+        UasmFreeResult( &r );
+        return;
+    }
+    Check( img.mapped && img.base && img.code_size && img.size > img.code_size, "image layout" );
+    Check( calls >= 2, "callback called for externals" );
+    Check( ((fn2)UasmSymbol( &img, "add2" ))( 2, 40 ) == 42, "add2(2,40)" );
+    Check( ((fn2)UasmSymbol( &img, "mul3" ))( 7, 0 ) == 21, "mul3(7) with data label" );
+    *(long *)UasmSymbol( &img, "factor" ) = 10;
+    Check( ((fn2)UasmSymbol( &img, "mul3" ))( 5, 0 ) == 50, "mul3(5) after data label was written" );
+    Check( *(int *)UasmSymbol( &img, "counter" ) == 2, "data label written by code" );
+    /* the host executable is usually more than 2 GB away from mapped memory */
+    if ( (char *)host_mul - (char *)img.base > 0x7FFFFFFFL || (char *)img.base - (char *)host_mul > 0x7FFFFFFFL )
+        Check( ((fn2)UasmSymbol( &img, "callhost" ))( 6, 7 ) == 42, "call of host function through stub" );
+    else
+        Check( ((fn2)UasmSymbol( &img, "callhost" ))( 6, 7 ) == 42, "call of host function" );
+    Check( ((fn0)UasmSymbol( &img, "gethost" ))() == host_var, "address of host variable" );
+    Check( UasmSymbol( &img, "nothere" ) == NULL, "unknown label" );
+    UasmFreeImage( &img );
+    UasmFreeResult( &r );
+}
+
+/* image in memory of the caller; first too small, then large enough */
+
+static void TestCallerMemory( struct uasm_ctx *ctx )
+/**************************************************/
+{
+    struct uasm_result r;
+    struct uasm_image img;
+    void *mem = NULL;
+    size_t needed;
+    int calls = 0;
+    int ok;
+
+    if ( posix_memalign( &mem, PAGESIZE, 16 * PAGESIZE ) ) {
+        Check( 0, "allocate memory" );
+        return;
+    }
+    ok = UasmJit( ctx, src, strlen( src ), mem, PAGESIZE, Resolve, &calls, &r, &img );
+    needed = img.size;
+    Check( !ok && r.errors && needed > PAGESIZE, "memory too small, size needed returned" );
+    UasmFreeResult( &r );
+    UasmFreeImage( &img );
+    if ( needed > 16 * PAGESIZE ) {
+        free( mem );
+        return;
+    }
+    ok = UasmJit( ctx, src, strlen( src ), mem, 16 * PAGESIZE, Resolve, &calls, &r, &img );
+    Check( ok && img.base == mem && !img.mapped, "assemble into caller memory" );
+    if ( ok ) {
+        Check( ((fn2)UasmSymbol( &img, "add2" ))( 20, 22 ) == 42, "add2(20,22) in caller memory" );
+        Check( ((fn2)UasmSymbol( &img, "callhost" ))( 3, 5 ) == 15, "call of host function in caller memory" );
+    }
+    UasmFreeResult( &r );
+    UasmFreeImage( &img );
+    /* the code pages are read/execute now, UasmFreeImage() doesn't change that */
+    mprotect( mem, 16 * PAGESIZE, PROT_READ | PROT_WRITE );
+    free( mem );
+}
+
+static void TestUnresolved( struct uasm_ctx *ctx )
+/************************************************/
+{
+    struct uasm_result r;
+    struct uasm_image img;
+    int calls = 0;
+    int ok;
+
+    ok = UasmJit( ctx, srcunres, strlen( srcunres ), NULL, 0, Resolve, &calls, &r, &img );
+    Check( !ok && r.errors && img.base == NULL, "unresolved external is an error" );
+    Check( r.messages && strstr( r.messages, "nothere" ), "message names the external" );
+    UasmFreeResult( &r );
+    UasmFreeImage( &img );
+}
+
+int main( void )
+/**************/
+{
+    struct uasm_ctx *ctx;
+
+    ctx = UasmCreate( "-q" );
+    if ( ctx == NULL ) {
+        printf( "UasmCreate() failed\n" );
+        return( EXIT_FAILURE );
+    }
+    TestMapped( ctx );
+    TestCallerMemory( ctx );
+    TestUnresolved( ctx );
+    UasmDestroy( ctx );
+    printf( failed ? "jittest: %d tests FAILED\n" : "jittest: all tests passed\n", failed );
+    return( failed ? EXIT_FAILURE : EXIT_SUCCESS );
+}
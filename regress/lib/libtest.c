@@ -0,0 +1,164 @@
+/****************************************************************************
+*
+* Description:  libuasm test: assembles the same sources repeatedly with
+*               one context and checks that the results don't change and
+*               that the heap doesn't grow ( glibc only ).
+*               Build and run: make -f gccLinux64.mak libtest
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "libuasm.h"
+
+#define LOOPS    200
+#define MAXGROW  0x10000 /* heap may grow by this amount ( caches of the C runtime ) */
+
+static const char src64[] =
+    "S struct\n"
+    "a dd ?\n"
+    "b dq ?\n"
+    "S ends\n"
+    "M macro x\n"
+    " mov eax, x\n"
+    " endm\n"
+    ".data\n"
+    "v S <1, 2>\n"
+    ".code\n"
+    "foo proc\n"
+    " M 1\n"
+    " .if eax == 1\n"
+    "  mov rax, v.b\n"
+    " .endif\n"
+    " ret\n"
+    "foo endp\n"
+    "end\n";
+
+static const char src32[] =
+    ".386\n"
+    ".model flat, c\n"
+    ".code\n"
+    "bar proc a:dword\n"
+    " mov eax, a\n"
+    " ret\n"
+    "bar endp\n"
+    "end\n";
+
+static const char srcerr[] =
+    ".386\n"
+    ".model flat, c\n"
+    ".code\n"
+    " mov eax, undefsym\n"
+    "end\n";
+
+static size_t HeapUsed( void )
+/****************************/
+{
+#ifdef __GLIBC__
+    return( mallinfo2().uordblks );
+#else
+    return( 0 );
+#endif
+}
+
+/* compare two objects. For COFF, the time stamp in the file header
+ * ( offset 4, size 4 ) may differ.
+ */
+static int SameObject( const struct uasm_result *r1, const struct uasm_result *r2, int coff )
+/*******************************************************************************************/
+{
+    if ( r1->object_size != r2->object_size )
+        return( 0 );
+    if ( coff && r1->object_size >= 8 )
+        return( memcmp( r1->object, r2->object, 4 ) == 0 &&
+               memcmp( r1->object + 8, r2->object + 8, r1->object_size - 8 ) == 0 );
+    return( r1->object_size == 0 || memcmp( r1->object, r2->object, r1->object_size ) == 0 );
+}
+
+/* assemble a source LOOPS times; each result must match the first one */
+
+static int Repeat( const char *options, const char *source, int expect_ok )
+/*************************************************************************/
+{
+    struct uasm_ctx *ctx;
+    struct uasm_result first;
+    struct uasm_result r;
+    size_t heap = 0;
+    int i;
+    int rc = 1;
+    int coff = ( strstr( options, "-coff" ) || strstr( options, "-win64" ) );
+
+    ctx = UasmCreate( options );
+    if ( ctx == NULL ) {
+        printf( "%s: UasmCreate() failed\n", options );
+        return( 0 );
+    }
+    if ( UasmAssemble( ctx, source, strlen( source ), &first ) != expect_ok ) {
+        printf( "%s: unexpected result, messages:\n%s", options, first.messages ? first.messages : "" );
+        rc = 0;
+    }
+    for ( i = 1; i < LOOPS && rc; i++ ) {
+        /* the first runs may initialize static tables */
+        if ( i == 2 )
+            heap = HeapUsed();
+        UasmAssemble( ctx, source, strlen( source ), &r );
+        if ( !SameObject( &r, &first, coff ) ||
+            r.errors != first.errors || r.warnings != first.warnings ) {
+            printf( "%s: result of run %u differs\n", options, i + 1 );
+            rc = 0;
+        }
+        UasmFreeResult( &r );
+    }
+    if ( rc && HeapUsed() > heap + MAXGROW ) {
+        printf( "%s: heap grew by %u kB in %u runs\n", options, (unsigned)( ( HeapUsed() - heap ) / 1024 ), LOOPS - 2 );
+        rc = 0;
+    }
+    UasmFreeResult( &first );
+    UasmDestroy( ctx );
+    if ( rc )
+        printf( "%s: %u runs ok\n", options, LOOPS );
+    return( rc );
+}
+
+/* invalid options: UasmCreate() must fail - and return */
+
+static int Reject( const char *options )
+/**************************************/
+{
+    struct uasm_ctx *ctx;
+
+    ctx = UasmCreate( options );
+    if ( ctx ) {
+        printf( "%s: UasmCreate() didn't fail\n", options );
+        UasmDestroy( ctx );
+        return( 0 );
+    }
+    printf( "%s: rejected\n", options );
+    return( 1 );
+}
+
+int main( void )
+/**************/
+{
+    int rc = 1;
+
+    rc &= Reject( "-h" );
+    rc &= Reject( "-win64 -?" );
+    rc &= Reject( "@/nonexistent/uasm.rsp" );
+    rc &= Reject( "@PATH" );
+    rc &= Reject( "-coff src.asm" );
+    rc &= Reject( "-xyz" );
+
+    rc &= Repeat( "-win64 -Zp8", src64, 1 );
+    rc &= Repeat( "-elf64", src64, 1 );
+    rc &= Repeat( "-coff -Fl -Sg", src32, 1 );
+    rc &= Repeat( "-omf", src32, 1 );
+    rc &= Repeat( "-coff", srcerr, 0 );
+    rc &= Repeat( "-win64 -nomlib", src64, 1 );
+    printf( rc ? "libtest: all tests passed\n" : "libtest: FAILED\n" );
+    return( rc ? EXIT_SUCCESS : EXIT_FAILURE );
+}
@@ -37,6 +37,18 @@ for %%f in (..\src\CodeGenV2\*.asm) do call :cgv2 %%f
 for %%f in (..\src\CodeGenV2Error\*.asm) do call :cgv2err %%f
 for %%f in (..\src\codeview8_32\*.asm) do call :cv832 %%f
 for %%f in (..\src\codeview8_64\*.asm) do call :cv864 %%f
+for %%f in (..\src\hllopt\*.asm) do call :cmphllopt %%f
+for %%f in (..\src\riprel\*.asm) do call :cmpriprel %%f
+for %%f in (..\src\ep\*.asm) do call :cmpep %%f
+for %%f in (..\src\stdio\*.asm) do call :cmpstdio %%f
+for %%f in (..\src\icf\*.asm) do call :cmpicf %%f
+for %%f in (..\src\icfpe\*.asm) do call :cmpicfpe %%f
+for %%f in (..\src\icfcoff\*.asm) do call :cmpicfcoff %%f
+for %%f in (..\src\order\*.asm) do call :cmporder %%f
+for %%f in (..\src\optimize\*.asm) do call :cmpoptimize %%f
+for %%f in (..\src\lazyinc\*.asm) do call :cmplazyinc %%f
+for %%f in (..\src\eprt\*.asm) do call :cmpeprt %%f
+for %%f in (..\src\mca\*.asm) do call :cmpmca %%f
 cd ..
 echo .
 echo .
@@ -346,4 +358,177 @@ if errorlevel 1 goto end
 del %~n1.err
 goto end
 
+:cmphllopt
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -q -bin -hllopt %1
+%FCMP% %~n1.bin ..\exp\hllopt\%~n1.bin
+if errorlevel 1 goto end
+del %~n1.bin
+goto end
+
+:cmpriprel
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -c -q -W2 -win64 -Zp8 %1
+%FCMP% /O16 %~n1.obj ..\exp\riprel\%~n1.obj
+if errorlevel 1 goto end
+del %~n1.obj
+%FCMP% %~n1.err ..\exp\riprel\%~n1.err
+if errorlevel 1 goto end
+del %~n1.err
+goto end
+
+:cmpep
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -q -EP -Fo%~n1.pp %1
+%FCMP% %~n1.pp ..\exp\ep\%~n1.pp
+if errorlevel 1 goto end
+del %~n1.pp
+goto end
+
+:cmpstdio
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -q -coff -Fo%~n1.obj - < %1
+%FCMP% /O16 %~n1.obj ..\exp\stdio\%~n1_stdin.obj
+if errorlevel 1 goto end
+%ASMX% -q -coff -Fo- %1 > %~n1.out
+%FCMP% /O16 %~n1.out ..\exp\stdio\%~n1.obj
+if errorlevel 1 goto end
+%ASMX% -q -coff -Fl%~n1.lst %1
+%ASMX% -q -coff -Fl- %1 > %~n1.ls1
+findstr /V /C:" passes, " %~n1.lst > %~n1.l1
+findstr /V /C:" passes, " %~n1.ls1 > %~n1.l2
+%FCMP% %~n1.l2 %~n1.l1
+if errorlevel 1 goto end
+del %~n1.obj
+del %~n1.out
+del %~n1.lst
+del %~n1.ls1
+del %~n1.l1
+del %~n1.l2
+goto end
+
+:cmpicf
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -q -bin -icf %1
+%FCMP% %~n1.bin ..\exp\icf\%~n1.bin
+if errorlevel 1 goto end
+del %~n1.bin
+goto end
+
+:cmpicfpe
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -q -pe -icf %1
+%FCMP% /O16 %~n1.exe ..\exp\icfpe\%~n1.exe
+if errorlevel 1 goto end
+del %~n1.exe
+goto end
+
+:cmpicfcoff
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -q -win64 -Zp8 -icf %1
+%FCMP% /O16 %~n1.obj ..\exp\icfcoff\%~n1.obj
+if errorlevel 1 goto end
+del %~n1.obj
+goto end
+
+:cmporder
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -q -pe -order=..\src\order\%~n1.ord %1
+%FCMP% /O16 %~n1.exe ..\exp\order\%~n1.exe
+if errorlevel 1 goto end
+del %~n1.exe
+goto end
+
+:cmpoptimize
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -q -bin -Fl %1
+%FCMP% %~n1.bin ..\exp\optimize\%~n1.bin
+if errorlevel 1 goto end
+del %~n1.bin
+findstr /B /C:"0000" %~n1.lst > %~n1.l1
+%FCMP% %~n1.l1 ..\exp\optimize\%~n1.l1
+if errorlevel 1 goto end
+del %~n1.lst
+del %~n1.l1
+goto end
+
+:cmplazyinc
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -q -coff -lazyinc %1
+%FCMP% /O16 %~n1.obj ..\exp\lazyinc\%~n1.obj
+if errorlevel 1 goto end
+del %~n1.obj
+goto end
+
+:cmpeprt
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -q -EP -Fo%~n1.pp %1
+%ASMX% -q -bin -Fo%~n1.bin %~n1.pp
+del %~n1.pp
+%FCMP% %~n1.bin ..\exp\eprt\%~n1.bin
+if errorlevel 1 goto end
+del %~n1.bin
+goto end
+
+:cmpmca
+echo ****************************************************************
+ECHO %1
+echo ****************************************************************
+echo .
+echo .
+%ASMX% -q -bin -Sc -Sn -Fl %1
+%FCMP% %~n1.bin ..\exp\mca\%~n1.bin
+if errorlevel 1 goto end
+del %~n1.bin
+findstr /V /C:"UASM v" /C:" passes, " %~n1.lst > %~n1.l1
+%FCMP% %~n1.l1 ..\exp\mca\%~n1.l1
+if errorlevel 1 goto end
+del %~n1.lst
+del %~n1.l1
+goto end
+
 :end
@@ -0,0 +1,124 @@
+
+;--- -icf: identical code folding, BIN output.
+;--- get1a, get1b and get1c are identical and folded to get1a; the
+;--- labels inside get1b are resolved to the matching labels in get1a.
+;--- sum1 and sum2 reference different data, call1 and call2 call
+;--- different procs: not folded. cmp1 and cmp2 compare with a value
+;--- that depends on the layout; they are identical until get1b and
+;--- get1c are folded, then cmp2 is unfolded again. fall1 and fall2
+;--- don't end with RET or JMP, they continue with different code in
+;--- next1 and next2: not folded.
+
+	.386
+	.model flat
+	option casemap:none
+
+	.data
+
+vala	dd 1
+valb	dd 2
+tab		dd get1a, get1b, get1c
+
+	.code
+
+start:
+	call get1a
+	call get1b
+	call get1c
+	call sum1
+	call sum2
+	call call1
+	call call2
+	call cmp1
+	call cmp2
+	call fall1
+	call fall2
+	jmp get1b_l2
+
+get1a proc
+	mov eax, vala
+	test eax, eax
+	jz get1a_l1
+	mov eax, offset tab
+get1a_l1::
+	ret
+get1a_l2::
+	ret
+get1a endp
+
+get1b proc
+	mov eax, vala
+	test eax, eax
+	jz get1b_l1
+	mov eax, offset tab
+get1b_l1::
+	ret
+get1b_l2::
+	ret
+get1b endp
+
+get1c proc
+	mov eax, vala
+	test eax, eax
+	jz @F
+	mov eax, offset tab
+@@:
+	ret
+	ret
+get1c endp
+
+sum1 proc
+	mov eax, vala
+	add eax, 1
+	ret
+sum1 endp
+
+sum2 proc
+	mov eax, valb
+	add eax, 1
+	ret
+sum2 endp
+
+call1 proc
+	call get1a
+	ret
+call1 endp
+
+call2 proc
+	call sum1
+	ret
+call2 endp
+
+cmp1 proc
+	cmp eax, 8Fh
+	setz al
+	ret
+cmp1 endp
+
+cmp2 proc
+	cmp eax, codeend - start
+	setz al
+	ret
+cmp2 endp
+
+fall1 proc
+	inc eax
+fall1 endp
+
+next1 proc
+	inc eax
+	ret
+next1 endp
+
+fall2 proc
+	inc eax
+fall2 endp
+
+next2 proc
+	add eax, 2
+	ret
+next2 endp
+
+codeend:
+
+	end start
@@ -0,0 +1,85 @@
+
+;--- -icf: identical code folding, 64-bit COFF output.
+;--- get1 and get2 call the same external and are folded; get2 gets
+;--- the address of get1, the fixups are written once. get3 calls
+;--- another external: not folded. ptr1 and ptr2 store the address of a
+;--- label inside themselves at the same position: folded. pub1 and pub2
+;--- are public, their addresses may be compared: not folded. frame1 and
+;--- frame2 are identical FRAME procs, but each has its own unwind data:
+;--- not folded.
+
+	option casemap:none
+
+	externdef ext1:proc
+	externdef ext2:proc
+
+	.data
+
+tab	dq get1, get2, get3
+
+	.code
+
+get1 proc private
+	sub rsp, 28h
+	call ext1
+	add rsp, 28h
+	ret
+get1 endp
+
+get2 proc private
+	sub rsp, 28h
+	call ext1
+	add rsp, 28h
+	ret
+get2 endp
+
+get3 proc private
+	sub rsp, 28h
+	call ext2
+	add rsp, 28h
+	ret
+get3 endp
+
+ptr1 proc private
+	mov rax, offset ptr1_1
+ptr1_1::
+	ret
+ptr1 endp
+
+ptr2 proc private
+	mov rax, offset ptr2_1
+ptr2_1::
+	ret
+ptr2 endp
+
+pub1 proc public
+	mov eax, 1
+	ret
+pub1 endp
+
+pub2 proc public
+	mov eax, 1
+	ret
+pub2 endp
+
+frame1 proc public frame
+	push rbx
+	.pushreg rbx
+	.endprolog
+	mov rbx, rcx
+	lea rax, [rbx+1]
+	pop rbx
+	ret
+frame1 endp
+
+frame2 proc public frame
+	push rbx
+	.pushreg rbx
+	.endprolog
+	mov rbx, rcx
+	lea rax, [rbx+1]
+	pop rbx
+	ret
+frame2 endp
+
+	end
@@ -0,0 +1,77 @@
+
+;--- -icf: identical code folding, 64-bit PE output.
+;--- The RIP-relative operands of val1 and val2 have the same target, so
+;--- the procs are folded, the displacement is computed from the code
+;--- of val1. addr1 and addr2 reference a label inside themselves at the
+;--- same position: folded as well. tab1 and tab2 load an absolute
+;--- address. val3 references other data: not folded.
+
+	.x64
+	.model flat, fastcall
+	option casemap:none
+
+	.data
+
+vala	dq 1
+valb	dq 2
+tab		dq val1, val2, addr1, addr2
+
+	.code
+
+val1 proc
+	mov rax, vala
+	inc rax
+	ret
+val1 endp
+
+val2 proc
+	mov rax, vala
+	inc rax
+	ret
+val2 endp
+
+val3 proc
+	mov rax, valb
+	inc rax
+	ret
+val3 endp
+
+addr1 proc
+	lea rax, addr1_1
+addr1_1::
+	ret
+addr1 endp
+
+addr2 proc
+	lea rax, addr2_1
+addr2_1::
+	ret
+addr2 endp
+
+tab1 proc
+	mov rax, offset tab
+	mov rax, [rax+rcx*8]
+	ret
+tab1 endp
+
+tab2 proc
+	mov rax, offset tab
+	mov rax, [rax+rcx*8]
+	ret
+tab2 endp
+
+start proc
+	sub rsp, 28h
+	call val1
+	call val2
+	call val3
+	call addr1
+	call addr2
+	mov rcx, addr2_1
+	call tab1
+	call tab2
+	add rsp, 28h
+	ret
+start endp
+
+	end start
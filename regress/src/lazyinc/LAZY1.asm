@@ -0,0 +1,28 @@
+;--- -lazyinc: the object module must be the same as without the option.
+;--- B is an expression and takes the value of A at its declaration;
+;--- S1 is laid out with FIELDALIGN:1, R is read with RADIX 16; the
+;--- externals are written in declaration order, not first-use order;
+;--- lbl1 is declared inside _TEXT.
+
+	.386
+	.model flat, stdcall
+
+	include LAZY1.inc
+
+A = 5
+
+	.data
+
+	dd B, E3, E4, R
+	dd sizeof S1
+v1	S1 <1, 2>
+p1	PVOID v1
+	dd ext2, ext1
+
+	.code
+
+	invoke proc2, 1
+	invoke proc1, 2
+	jmp lbl1
+
+	end
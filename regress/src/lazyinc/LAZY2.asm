@@ -0,0 +1,24 @@
+;--- -lazyinc: externals are written in the order of their declaration,
+;--- not in the order of their first use. Externals of the source file
+;--- are numbered between those of the include file. kval and l1 are
+;--- declared inside a segment.
+
+	.386
+	.model flat, stdcall
+
+	include LAZY2.inc
+
+	extern x1:dword
+
+	.data
+
+	dd e5, x1, e3, e2, e1, kval
+
+	.code
+
+	invoke f2, 1, 2
+	invoke f1, 3
+	call l1
+	mov eax, e5
+
+	end
@@ -0,0 +1,52 @@
+
+;--- -Sc listing column and block summary. A RET which is replaced
+;--- by an epilogue shows the epilogue's total.
+
+	.x64
+	.model flat, fastcall
+	option casemap:none
+
+	.code
+
+;--- frame: RET becomes LEAVE + RETN
+
+sum proc uses rbx p:ptr dword, n:dword
+	local acc:dword
+	mov acc, 0
+	xor ebx, ebx
+	mov rcx, p
+	mov edx, n
+@@:
+	add ebx, [rcx]
+	add rcx, 4
+	dec edx
+	jnz @B
+	mov acc, ebx
+	mov eax, acc
+	ret
+sum endp
+
+;--- no frame: RET becomes RETN
+
+mul3 proc
+	imul eax, ecx, 3
+	ret
+mul3 endp
+
+;--- RETN isn't replaced, it's annotated like any instruction
+
+raw proc
+	lea eax, [rcx+rcx*2]
+	retn
+raw endp
+
+;--- SIMD and an instruction without table entry
+
+vec proc
+	vaddps ymm0, ymm1, ymm2
+	vmulps ymm0, ymm0, ymm3
+	fld st(1)
+	ret
+vec endp
+
+	end
@@ -0,0 +1,63 @@
+
+;--- OPTION OPTIMIZE:SIZE, 64-bit code. Rewritten lines are marked
+;--- with '~' in the listing.
+
+	.x64
+	.model flat
+	option casemap:none
+
+	.code
+
+	option optimize:size
+
+;--- MOV r64, imm: the 32-bit register form clears bits 32-63
+
+	mov rax, 1			;mov eax, 1
+	mov rcx, 0FFFFFFFFh	;mov ecx, 0FFFFFFFFh
+	mov r9, 12345678h	;mov r9d, 12345678h
+	mov rdx, -1			;unchanged, negative
+	mov rbx, 100000000h	;unchanged, more than 32 bits
+
+;--- MOV reg, 0 becomes XOR only if the next instruction writes the flags
+;--- without reading them
+
+	mov eax, 0			;xor eax, eax
+	add eax, ecx
+	mov ecx, 0			;xor ecx, ecx
+	test ebx, ebx
+	mov r8, 0			;xor r8d, r8d
+	cmp r9, r10
+	mov si, 0			;xor si, si
+	neg di
+	mov edx, 0			;unchanged, ADC reads CF
+	adc edx, 0
+	mov ebp, 0			;unchanged, SETC reads CF
+	setc bl
+	mov ebx, 0			;unchanged, JZ reads ZF
+	jz lbl1
+	mov edi, 0			;xor edi, edi: the flags don't reach lbl1
+lbl1:
+	sub edi, eax
+	mov al, 0			;unchanged, 8-bit
+	add al, bl
+
+;--- commutative VEX instructions: the 2-byte VEX prefix can't encode
+;--- r8-r15 as second source, so the sources are exchanged
+
+	vaddps xmm0, xmm1, xmm8		;vaddps xmm0, xmm8, xmm1
+	vpxor ymm2, ymm3, ymm12		;vpxor ymm2, ymm12, ymm3
+	vmulpd xmm9, xmm2, xmm10	;vmulpd xmm9, xmm10, xmm2
+	vaddps xmm0, xmm8, xmm1		;unchanged, 2-byte VEX already
+	vsubps xmm0, xmm1, xmm8		;unchanged, not commutative
+	vaddss xmm0, xmm1, xmm8		;unchanged, scalar
+	vmaxps xmm0, xmm1, xmm8		;unchanged, result depends on the order for NaNs
+
+	option optimize:none
+
+	mov rax, 1			;unchanged
+	mov eax, 0			;unchanged
+	add eax, ecx
+	vaddps xmm0, xmm1, xmm8		;unchanged
+	ret
+
+	end
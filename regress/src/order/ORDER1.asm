@@ -0,0 +1,83 @@
+
+;--- -order: procedure ordering, 64-bit PE output.
+;--- ORDER1.ord lists hot3, hot1 and hot2, a name that isn't a proc
+;--- and a name that doesn't exist. The listed procs are placed first
+;--- in file order, the others follow in source order; code in front
+;--- of the first proc stays in place, code between procs moves with
+;--- the proc behind it ( the ALIGN in front of hot2 ). The entries of
+;--- the .pdata section are sorted by address after the move.
+
+	.x64
+	.model flat, fastcall
+	option casemap:none
+	option dotname
+
+	.data
+
+tab	dq cold1, hot1, hot2, hot3, cold2
+
+	.code
+
+	db 0CCh		;code in front of the first proc stays in place
+
+start proc
+	sub rsp, 28h
+	call hot1
+	call hot2
+	call hot3
+	call cold1
+	add rsp, 28h
+	ret
+start_end::
+start endp
+
+cold1 proc
+	xor eax, eax
+	jmp cold1_1
+	nop
+cold1_1:
+	ret
+cold1_end::
+cold1 endp
+
+hot1 proc
+	call hot3
+	lea rax, tab
+	ret
+hot1_end::
+hot1 endp
+
+	align 16		;moves with hot2
+hot2 proc
+	mov eax, hot2_1 - hot2
+	ret
+hot2_1:
+hot2_end::
+hot2 endp
+
+hot3 proc
+	mov rax, offset hot1
+	ret
+hot3_end::
+hot3 endp
+
+cold2 proc
+	jmp hot2
+cold2 endp
+
+;--- unwind data, written in the source. The entries are in source
+;--- order; with -order they are sorted by address.
+
+	.xdata segment dword flat 'DATA'
+xunw	db 1, 0, 0, 0
+	.xdata ends
+
+	.pdata segment dword flat 'DATA'
+	dd IMAGEREL start, IMAGEREL start_end, IMAGEREL xunw
+	dd IMAGEREL cold1, IMAGEREL cold1_end, IMAGEREL xunw
+	dd IMAGEREL hot1, IMAGEREL hot1_end, IMAGEREL xunw
+	dd IMAGEREL hot2, IMAGEREL hot2_end, IMAGEREL xunw
+	dd IMAGEREL hot3, IMAGEREL hot3_end, IMAGEREL xunw
+	.pdata ends
+
+	end start
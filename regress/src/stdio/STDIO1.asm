@@ -0,0 +1,35 @@
+
+;--- "-" as file name: source from stdin ( "-" ), object module ( -Fo- )
+;--- and listing ( -Fl- ) to stdout. COFF, so the object header is
+;--- written last ( seek back ); forward references need a second pass.
+
+	.386
+	.model flat, c
+	option casemap:none
+
+sum	macro a, b
+	mov eax, a
+	add eax, b
+	endm
+
+	.data
+
+tab	dd lbl1, lbl2, fwd
+cnt	dd lengthof buf
+buf	db 100 dup (?)
+	db "stdio", 0
+
+	.code
+
+lbl1:
+	sum 1, 2
+	jmp fwd
+lbl2:
+	mov ecx, offset buf
+	db 200 dup (90h)
+fwd	proc
+	mov eax, cnt
+	ret
+fwd	endp
+
+	end
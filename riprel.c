@@ -0,0 +1,225 @@
+/****************************************************************************
+*
+*  This code is Public Domain.
+*
+*  ========================================================================
+*
+* Description:  OPTION RIPRELATIVE ( default ON if -pie is set ).
+*               In 64-bit code, a data label is addressed RIP-relative
+*               unless a base or index register is involved; then the
+*               displacement is an absolute address which needs a 32-bit
+*               relocation ( a text relocation in PIE, a base relocation
+*               in PE that fails for addresses above 2 GB ).
+*               With the option, such instructions are replaced by a
+*               RIP-relative LEA and a register-only access, if the
+*               destination is a 32- or 64-bit GPR which can hold the
+*               address:
+*               - MOV reg, OFFSET label     -> LEA reg, label
+*               - LEA reg, label[base] or label[index*s]
+*               - MOV/MOVZX/MOVSX reg, label[base] or label[index*s]
+*                                           -> LEA reg64, label
+*                                              op reg, [reg64+base/index*s]
+*               All other absolute references are reported.
+*
+****************************************************************************/
+
+#include <string.h>
+
+#include "globals.h"
+#include "parser.h"
+#include "reswords.h"
+#include "expreval.h"
+#include "lqueue.h"
+#include "listing.h"
+#include "segment.h"
+#include "riprel.h"
+
+static struct {
+    uint_32 converted;  /* absolute references replaced */
+    uint_32 remaining;  /* absolute references reported */
+} riprel_stat;
+
+#define IS_GPR( reg, op ) ( GetValueSp( reg ) & ( op ) )
+
+void RipRelInit( int pass )
+/*************************/
+{
+    memset( &riprel_stat, 0, sizeof( riprel_stat ) );
+}
+
+/* is the operand an absolute address of a label?
+ * for a memory operand, base or index must be 64-bit GPRs.
+ * constants ( EXTERNDEF name:ABS, labels in AT segments ) are not
+ * addresses, and a label that's still undefined in pass one may turn
+ * out to be a constant.
+ */
+static bool IsAbsolute( const struct expr *opnd )
+/***********************************************/
+{
+    const struct asym *sym = opnd->sym;
+
+    if ( opnd->kind != EXPR_ADDR || sym == NULL || opnd->override != NULL )
+        return( FALSE );
+    if ( opnd->is_abs )
+        return( FALSE );
+    if ( sym->state == SYM_INTERNAL ) {
+        if ( sym->segment == NULL ||
+            ((struct dsym *)sym->segment)->e.seginfo->segtype == SEGTYPE_ABS )
+            return( FALSE );
+    } else if ( sym->state != SYM_EXTERNAL )
+        return( FALSE );
+    if ( opnd->instr == T_OFFSET )
+        return( opnd->indirect == FALSE );
+    if ( opnd->instr != EMPTY || opnd->indirect == FALSE )
+        return( FALSE );
+    if ( opnd->base_reg == NULL && opnd->idx_reg == NULL )
+        return( FALSE ); /* RIP-relative already */
+    if ( opnd->base_reg && ( opnd->base_reg->tokval == T_RIP || !IS_GPR( opnd->base_reg->tokval, OP_R64 ) ) )
+        return( FALSE );
+    if ( opnd->idx_reg && !IS_GPR( opnd->idx_reg->tokval, OP_R64 ) )
+        return( FALSE );
+    return( TRUE );
+}
+
+/* the label must be found by its name in the generated lines */
+
+static bool IsVisible( const struct asym *sym )
+/*********************************************/
+{
+    return( SymSearch( sym->name ) == sym );
+}
+
+/* write "label[+disp]" */
+
+static void LabelText( char *buffer, const struct expr *opnd )
+/************************************************************/
+{
+    strcpy( buffer, opnd->sym->name );
+    if ( opnd->value )
+        sprintf( buffer + strlen( buffer ), "%+" I32_SPEC "d", opnd->value );
+}
+
+/* write "[reg64+base]" or "[reg64+index*s]" */
+
+static void RegsText( char *buffer, unsigned reg64, const struct expr *opnd )
+/***************************************************************************/
+{
+    char *p = buffer;
+
+    *p++ = '[';
+    GetResWName( reg64, p );
+    p += strlen( p );
+    if ( opnd->base_reg ) {
+        *p++ = '+';
+        GetResWName( opnd->base_reg->tokval, p );
+        p += strlen( p );
+    }
+    if ( opnd->idx_reg ) {
+        *p++ = '+';
+        GetResWName( opnd->idx_reg->tokval, p );
+        p += strlen( p );
+        if ( opnd->scale > 1 )
+            p += sprintf( p, "*%u", opnd->scale );
+    }
+    *p++ = ']';
+    *p = NULLC;
+}
+
+/* called for each instruction after its operands have been evaluated.
+ * returns TRUE if the instruction has been replaced.
+ */
+bool RipRelInstr( const struct code_info *CodeInfo, const struct expr opndx[], int opndCount )
+/********************************************************************************************/
+{
+    int i;
+    unsigned reg;
+    unsigned reg64;
+    unsigned ptr = EMPTY;
+    char label[MAX_LINE_LEN];
+    char regs[64];
+
+    if ( ModuleInfo.riprelative == FALSE || CodeInfo->Ofssize != USE64 )
+        return( FALSE );
+
+    for ( i = 0; i < opndCount && i < MAX_OPND; i++ )
+        if ( IsAbsolute( &opndx[i] ) )
+            break;
+    if ( i == opndCount || i == MAX_OPND )
+        return( FALSE );
+
+    /* destination must be a 32- or 64-bit GPR which isn't used in the address.
+     * a 16-bit destination would leave the upper bits of the address register
+     * destroyed.
+     */
+    if ( i != OPND2 || opndCount != 2 || opndx[OPND1].kind != EXPR_REG || opndx[OPND1].indirect ||
+        !IS_GPR( opndx[OPND1].base_reg->tokval, OP_R32 | OP_R64 ) || !IsVisible( opndx[i].sym ) )
+        goto report;
+    /* the address register takes the place of base or index */
+    if ( opndx[i].base_reg && opndx[i].idx_reg )
+        goto report;
+    reg = opndx[OPND1].base_reg->tokval;
+    reg64 = T_RAX + GetRegNo( reg );
+    if ( ( opndx[i].base_reg && GetRegNo( opndx[i].base_reg->tokval ) == GetRegNo( reg ) ) ||
+        ( opndx[i].idx_reg && GetRegNo( opndx[i].idx_reg->tokval ) == GetRegNo( reg ) ) )
+        goto report;
+
+    switch ( CodeInfo->token ) {
+    case T_MOV:
+        if ( opndx[i].instr == T_OFFSET ) {
+            LabelText( label, &opndx[i] );
+            AddLineQueueX( "%r %r, %s", T_LEA, reg, label );
+            break;
+        }
+        /* a size mismatch is to be reported by the code generator */
+        if ( opndx[i].mem_type != MT_EMPTY &&
+            SizeFromMemtype( opndx[i].mem_type, USE64, opndx[i].type ) != SizeFromRegister( reg ) )
+            goto report;
+        /* no break */
+    case T_LEA:
+        if ( opndx[i].instr == T_OFFSET )
+            goto report;
+        LabelText( label, &opndx[i] );
+        RegsText( regs, reg64, &opndx[i] );
+        AddLineQueueX( "%r %r, %s", T_LEA, reg64, label );
+        AddLineQueueX( "%r %r, %s", CodeInfo->token, reg, regs );
+        break;
+    case T_MOVZX:
+    case T_MOVSX:
+        if ( opndx[i].instr == T_OFFSET )
+            goto report;
+        switch ( SizeFromMemtype( opndx[i].mem_type, USE64, opndx[i].type ) ) {
+        case 1: ptr = T_BYTE; break;
+        case 2: ptr = T_WORD; break;
+        default: goto report;
+        }
+        LabelText( label, &opndx[i] );
+        RegsText( regs, reg64, &opndx[i] );
+        AddLineQueueX( "%r %r, %s", T_LEA, reg64, label );
+        AddLineQueueX( "%r %r, %r %r %s", CodeInfo->token, reg, ptr, T_PTR, regs );
+        break;
+    default:
+        goto report;
+    }
+    DebugMsg1(("RipRelInstr: absolute reference to %s replaced\n", opndx[i].sym->name ));
+    riprel_stat.converted++;
+    if ( ModuleInfo.list )
+        LstWrite( LSTTYPE_DIRECTIVE, GetCurrOffset(), NULL );
+    RunLineQueue();
+    return( TRUE );
+
+report:
+    riprel_stat.remaining++;
+    if ( Parse_Pass == PASS_2 )
+        EmitWarn( 2, ABSOLUTE_ADDRESS_IN_64BIT_CODE, opndx[i].sym->name );
+    return( FALSE );
+}
+
+/* display RIP-relative conversions ( -stats ); numbers are those of the last pass */
+
+void RipRelStats( void )
+/**********************/
+{
+    if ( riprel_stat.converted || riprel_stat.remaining )
+        printf( "RIP-relative: %" I32_SPEC "u absolute relocations eliminated, %" I32_SPEC "u remaining\n",
+               riprel_stat.converted, riprel_stat.remaining );
+}
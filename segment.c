@@ -284,6 +284,7 @@ static struct dsym *CreateSegment( struct dsym *seg, const char *name, bool add_
         seg->e.seginfo->Ofssize = ModuleInfo.defOfssize;
         seg->e.seginfo->alignment = 4; /* this is PARA (2^4) */
         seg->e.seginfo->combine = COMB_INVALID;
+        seg->e.seginfo->hllcode = ( strcmp( name, "_TEXT" ) == 0 || strcmp( name, "_flat" ) == 0 );
         /* null class name, in case none is mentioned */
         seg->next = NULL;
         /* don't use sym_add_table(). Thus the "prev" member
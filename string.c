@@ -74,6 +74,16 @@ static uint_32 equcnt;
 
 #define MAXUINT_PTR  (~((UINT_PTR)0))
 
+/* v2.52: runs of ASCII characters are widened 16 bytes at a time if SSE2
+ * is available at compile time ( always true for x64 ).
+ */
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define WIDEN_SSE2 1
+#else
+#define WIDEN_SSE2 0
+#endif
+
 /* generic parameter names. In case the parameter name is
  * displayed in an error message ("required parameter %s missing")
  * v2.05: obsolete
@@ -96,6 +106,29 @@ UINT_PTR UTF8toWideChar(const unsigned char *pSource, UINT_PTR nSourceLen, UINT_
  *Returns: number of characters copied to szTarget buffer.
  ********************************************************************/
 
+/* v2.52: copy ASCII characters to UTF-16, stop at the first byte >= 0x80.
+ * returns the number of characters copied.
+ */
+static UINT_PTR WidenASCII(const unsigned char *pSrc, UINT_PTR nLen, unsigned short *pDst)
+{
+  UINT_PTR i=0;
+#if WIDEN_SSE2
+  const __m128i zero=_mm_setzero_si128();
+
+  for (; i + 16 <= nLen; i+=16)
+  {
+    __m128i v=_mm_loadu_si128((const __m128i *)(pSrc + i));
+    if (_mm_movemask_epi8(v))
+      break;
+    _mm_storeu_si128((__m128i *)(pDst + i), _mm_unpacklo_epi8(v, zero));
+    _mm_storeu_si128((__m128i *)(pDst + i + 8), _mm_unpackhi_epi8(v, zero));
+  }
+#endif
+  for (; i < nLen && pSrc[i] < 0x80; i++)
+    pDst[i]=pSrc[i];
+  return i;
+}
+
 UINT_PTR UTF8toWideChar(const unsigned char *pSource, UINT_PTR nSourceLen, UINT_PTR *nSourceDone, unsigned short *szTarget, UINT_PTR nTargetMax)
 {
   static const unsigned int lpOffsetsFromUTF8[6]={0x00000000, 0x00003080, 0x000E2080, 0x03C82080, 0xFA082080, 0x82082080};
@@ -106,6 +139,7 @@ UINT_PTR UTF8toWideChar(const unsigned char *pSource, UINT_PTR nSourceLen, UINT_
   unsigned short *pDstEnd;
   unsigned long nChar;
   unsigned int nTrailing;
+  UINT_PTR nCount;
 
   if (!szTarget && !nTargetMax)
   {
@@ -120,6 +154,18 @@ UINT_PTR UTF8toWideChar(const unsigned char *pSource, UINT_PTR nSourceLen, UINT_
 
   while (pSrc < pSrcEnd && pDst < pDstEnd)
   {
+    if (*pSrc < 0x80 && szTarget)
+    {
+      //Run of ASCII characters
+      nCount=pSrcEnd - pSrc;
+      if (nCount > (UINT_PTR)(pDstEnd - pDst))
+        nCount=pDstEnd - pDst;
+      nCount=WidenASCII(pSrc, nCount, pDst);
+      pSrc+=nCount;
+      pDst+=nCount;
+      pSrcDone=pSrc;
+      continue;
+    }
     if (*pSrc < 0x80)
     {
       nTrailing=0;
@@ -207,6 +253,39 @@ UINT_PTR UTF8toWideChar(const unsigned char *pSource, UINT_PTR nSourceLen, UINT_
   return (pDst - szTarget);
 }
 
+/* text macro buffers grow in powers of 2, starting with TMBUF_MIN bytes */
+#define TMBUF_MIN 16
+
+/* get a text macro buffer which can hold <size> bytes.
+ * If a new buffer has to be allocated, the first <keep> bytes
+ * of the old one are copied.
+ * v2.52: the capacity grows geometrically, so accumulating text
+ * ( <id> CATSTR <id>, <...> inside a loop ) doesn't allocate a new
+ * buffer for each step - old buffers aren't released if FASTMEM is on.
+ * A total_size of 0 means the text isn't owned by the symbol
+ * ( see AddPredefinedText() ).
+ */
+static char *TextMacroBuffer( struct asym *sym, unsigned size, unsigned keep )
+/****************************************************************************/
+{
+    char *p;
+    unsigned newsize;
+
+    if ( sym->string_ptr == NULL || sym->total_size < size ) {
+        for ( newsize = TMBUF_MIN; newsize < size; newsize <<= 1 );
+        p = LclAlloc( newsize );
+        if ( keep )
+            memcpy( p, sym->string_ptr, keep );
+#if FASTMEM==0
+        if ( sym->string_ptr && sym->total_size )
+            LclFree( sym->string_ptr );
+#endif
+        sym->string_ptr = p;
+        sym->total_size = newsize;
+    }
+    return( sym->string_ptr );
+}
+
 int TextItemError( struct asm_tok *item )
 /***************************************/
 {
@@ -234,6 +313,7 @@ ret_code CatStrDir( int i, struct asm_tok tokenarray[] )
 {
     struct asym *sym;
     int count;
+    int keep;
     char *p;
     /* struct expr opndx; */
 
@@ -288,7 +368,7 @@ ret_code CatStrDir( int i, struct asm_tok tokenarray[] )
          */
         sym_remove_table( &SymTables[TAB_UNDEF], (struct dsym *)sym );
 #if FASTPASS
-        SkipSavedState(); /* further passes must be FULL! */
+        TextMacroFwdRef( sym ); /* further passes must re-expand */
 #endif
         EmitWarn( 2, TEXT_MACRO_USED_PRIOR_TO_DEFINITION, sym->name );
     } else if( sym->state != SYM_TMACRO ) {
@@ -298,23 +378,24 @@ ret_code CatStrDir( int i, struct asm_tok tokenarray[] )
     }
 
 
+    /* v2.52: if the first item is the current value ( acc CATSTR acc, <...> ),
+     * keep it and just append the other items.
+     */
+    i = 2;
+    keep = 0;
+    if ( sym->state == SYM_TMACRO && sym->string_ptr && i < Token_Count ) {
+        keep = strlen( sym->string_ptr );
+        if ( keep == tokenarray[i].stringlen && memcmp( sym->string_ptr, tokenarray[i].string_ptr, keep ) == 0 )
+            i += 2;
+        else
+            keep = 0;
+    }
+
     sym->state = SYM_TMACRO;
     sym->isdefined = TRUE;
-#if FASTMEM==0
-    if ( sym->string_ptr )
-        LclFree( sym->string_ptr );
-    sym->string_ptr = (char *)LclAlloc( count + 1 );
-#else
-    /* v2.08: reuse string space if fastmem is on */
-    if ( sym->total_size < ( count+1 ) ) {
-        LclFree( sym->string_ptr ); /* is a noop if fastmem is on */
-        sym->string_ptr = (char *)LclAlloc( count + 1 );
-        sym->total_size = count + 1;
-    }
-#endif
     /* v2.08: don't use temp buffer */
     //memcpy( sym->string_ptr, StringBufferEnd, count + 1 );
-    for ( i = 2, p = sym->string_ptr; i < Token_Count; i += 2 ) {
+    for ( p = TextMacroBuffer( sym, count + 1, keep ) + keep; i < Token_Count; i += 2 ) {
         memcpy( p, tokenarray[i].string_ptr, tokenarray[i].stringlen );
         p += tokenarray[i].stringlen;
     }
@@ -347,10 +428,10 @@ struct asym *SetTextMacro( struct asm_tok tokenarray[], struct asym *sym, const
         sym_remove_table( &SymTables[TAB_UNDEF], (struct dsym *)sym );
 #if FASTPASS
         /* the text macro was referenced before being defined.
-         * this is valid usage, but it requires a full second pass.
-         * just simply deactivate the fastpass feature for this module!
+         * this is valid usage, but the stored lines which contain
+         * the reference must be expanded again in further passes.
          */
-        SkipSavedState();
+        TextMacroFwdRef( sym );
 #endif
         EmitWarn( 2, TEXT_MACRO_USED_PRIOR_TO_DEFINITION, sym->name );
     } else if ( sym->state != SYM_TMACRO ) {
@@ -383,17 +464,7 @@ struct asym *SetTextMacro( struct asm_tok tokenarray[], struct asym *sym, const
             if ( isspace( *( value + count - 1 ) ) == FALSE )
                 break;
     }
-#if FASTMEM==0
-    if ( sym->string_ptr )
-        LclFree( sym->string_ptr );
-    sym->string_ptr = (char *)LclAlloc( count + 1 );
-#else
-    if ( sym->total_size < ( count + 1 ) ) {
-        LclFree( sym->string_ptr ); /* is a noop if fastmem is on */
-        sym->string_ptr = (char *)LclAlloc( count + 1 );
-        sym->total_size = count + 1;
-    }
-#endif
+    TextMacroBuffer( sym, count + 1, 0 );
     memcpy( sym->string_ptr, value, count );
     *(sym->string_ptr + count) = NULLC;
 
@@ -573,7 +644,7 @@ ret_code SubStrDir( int i, struct asm_tok tokenarray[] )
          */
         sym_remove_table( &SymTables[TAB_UNDEF], (struct dsym *)sym );
 #if FASTPASS
-        SkipSavedState();
+        TextMacroFwdRef( sym );
         EmitWarn( 2, TEXT_MACRO_USED_PRIOR_TO_DEFINITION, sym->name );
 #endif
     } else if( sym->state != SYM_TMACRO ) {
@@ -585,17 +656,7 @@ ret_code SubStrDir( int i, struct asm_tok tokenarray[] )
     sym->state = SYM_TMACRO;
     sym->isdefined = TRUE;
 
-#if FASTMEM==0
-    if ( sym->string_ptr )
-        LclFree( sym->string_ptr );
-    sym->string_ptr = (char *)LclAlloc( size + 1 );
-#else
-    if ( sym->total_size < ( size + 1 ) ) {
-        LclFree( sym->string_ptr );
-        sym->string_ptr = LclAlloc ( size + 1 );
-        sym->total_size = size + 1;
-    }
-#endif
+    TextMacroBuffer( sym, size + 1, 0 );
     memcpy( sym->string_ptr, p, size );
     *(sym->string_ptr + size) = NULLC;
     DebugMsg1(("SubStrDir(%s): result=>%s<\n", sym->name, sym->string_ptr ));
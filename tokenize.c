@@ -1458,6 +1458,19 @@ int Tokenize( char *line, unsigned int start, struct asm_tok tokenarray[], unsig
                 }
             }
         }
+        /* v2.52: note tokens which may require HLL/OOP call expansion */
+        switch ( tokenarray[p.index].token ) {
+        case T_POINTER:
+            p.flags3 |= TF3_POINTER;
+            break;
+        case T_OP_BRACKET:
+            if ( p.index && tokenarray[p.index-1].token == T_ID )
+                p.flags3 |= TF3_IDBRACKET;
+            break;
+        case T_CL_BRACKET:
+            p.flags3 |= TF3_CLBRACKET;
+            break;
+        }
         p.index++;
         if( p.index >= MAX_TOKEN ) {
             DebugMsg1(("tokenize: token index %u >= MAX_TOKEN (=%u), line=>%s<\n", p.index, MAX_TOKEN, line ));